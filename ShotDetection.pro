@@ -3,6 +3,7 @@ TEMPLATE = app
 CONFIG += console
 CONFIG -= app_bundle
 CONFIG -= qt
+CONFIG += c++11
 
 SOURCES += main.cpp
 ANDROID_PACKAGE_SOURCE_DIR=$$_PRO_FILE_PWD_/android
@@ -89,15 +90,18 @@ TEMPLATE = app
 CONFIG += console
 CONFIG -= app_bundle
 CONFIG -= qt
+CONFIG += c++11
 
 SOURCES += main.cpp
 INCLUDEPATH += /usr/include/opencv2 /usr/include
-LIBS        += -lopencv_core -lopencv_highgui -lopencv_video -lopencv_imgproc -lopencv_flann
+LIBS        += -lopencv_core -lopencv_highgui -lopencv_video -lopencv_imgproc -lopencv_flann -lpthread
 
 }
 
+include(libshotdetect.pri)
+
 HEADERS += \
-    shotdetector.h
+    benchmark.h
 
 SOURCES += \
-    shotdetector.cpp
+    benchmark.cpp
@@ -0,0 +1,121 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#include "adaptivethreshold.h"
+#include "checkpoint.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief AdaptiveThreshold::AdaptiveThreshold
+ * @param window: number of recent distances the mean and variance are computed on
+ * @param sigmas: standard deviations above the mean of a boundary
+ */
+AdaptiveThreshold::AdaptiveThreshold(int window, double sigmas): ring(std::max(window, 2), 0.), next(0), count(0),
+    sum(0), sumSquares(0), sigmas(sigmas)
+{
+}
+
+/**
+ * @brief AdaptiveThreshold::update: Decides the distance of the next pair of frames and adds it to the window,
+ * a boundary distance clamped to the limit it exceeded.
+ * @param ratio: distance divided by the global boundary distance
+ * @return: true if the distance is a boundary
+ */
+bool AdaptiveThreshold::update(double ratio){
+    double current = limit();
+    bool boundary = ratio > current;
+    //a cut only moves the statistics as far as the limit, a new regime of larger distances still raises them
+    if(boundary)
+        ratio = current;
+    if(count == ring.size()){
+        sum -= ring[next];
+        sumSquares -= ring[next] * ring[next];
+    }else{
+        count++;
+    }
+    ring[next] = ratio;
+    sum += ratio;
+    sumSquares += ratio * ratio;
+    next = next + 1 == ring.size() ? 0 : next + 1;
+    return boundary;
+}
+
+/**
+ * @brief AdaptiveThreshold::decide: Boundary decision of a distance, by adaptive if it is given and the global
+ * boundary distance is positive, otherwise by the global rule. A zero threshold has no ratios to add to the window.
+ * @param adaptive: adaptive threshold of the run, 0 for the fixed threshold
+ * @param distance: distance of the pair of frames
+ * @param limit: global boundary distance (threshold scaled by the pixel count)
+ */
+bool AdaptiveThreshold::decide(AdaptiveThreshold *adaptive, double distance, double limit){
+    if(adaptive && limit > 0)
+        return adaptive->update(distance / limit);
+    return distance > limit;
+}
+
+double AdaptiveThreshold::mean() const{
+    return count ? sum / count : 0;
+}
+
+double AdaptiveThreshold::deviation() const{
+    if(!count)
+        return 0;
+    double m = mean();
+    //running sums can leave a tiny negative variance behind
+    return std::sqrt(std::max(sumSquares / count - m * m, 0.));
+}
+
+/**
+ * @brief AdaptiveThreshold::limit: Ratio above which the next distance is a boundary.
+ */
+double AdaptiveThreshold::limit() const{
+    if(count < ADAPTIVE_WARMUP_FRACTION * ring.size())
+        return 1.;
+    return std::max(mean() + sigmas * deviation(), ADAPTIVE_MIN_RATIO);
+}
+
+/**
+ * @brief AdaptiveThreshold::saveState: Stores the window and its running sums in a checkpoint.
+ */
+void AdaptiveThreshold::saveState(Checkpoint &checkpoint) const{
+    checkpoint.putInt((int64_t) ring.size());
+    checkpoint.putDouble(sigmas);
+    checkpoint.putInt((int64_t) next);
+    checkpoint.putInt((int64_t) count);
+    checkpoint.putDouble(sum);
+    checkpoint.putDouble(sumSquares);
+    for(size_t i = 0; i < ring.size(); i++)
+        checkpoint.putDouble(ring[i]);
+}
+
+/**
+ * @brief AdaptiveThreshold::loadState: Restores the state stored by saveState.
+ * @return: false if the state was saved with another window or sigmas, or the checkpoint is corrupt
+ */
+bool AdaptiveThreshold::loadState(Checkpoint &checkpoint){
+    if(checkpoint.getInt() != (int64_t) ring.size() || checkpoint.getDouble() != sigmas)
+        return false;
+    size_t savedNext = (size_t) checkpoint.getInt();
+    size_t savedCount = (size_t) checkpoint.getInt();
+    if(savedNext >= ring.size() || savedCount > ring.size())
+        return false;
+    next = savedNext;
+    count = savedCount;
+    sum = checkpoint.getDouble();
+    sumSquares = checkpoint.getDouble();
+    for(size_t i = 0; i < ring.size(); i++)
+        ring[i] = checkpoint.getDouble();
+    return !checkpoint.failed();
+}
@@ -0,0 +1,63 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#ifndef ADAPTIVETHRESHOLD_H
+#define ADAPTIVETHRESHOLD_H
+#include <cstddef>
+#include <vector>
+
+class Checkpoint;
+
+//standard deviations above the rolling mean of a boundary distance
+#define ADAPTIVE_DEFAULT_SIGMAS 4.0
+//fraction of the global threshold below which a distance is never a boundary
+#define ADAPTIVE_MIN_RATIO 0.25
+//fraction of the window which must be filled before the rolling statistics are used
+#define ADAPTIVE_WARMUP_FRACTION 0.5
+
+/**
+ * @brief The AdaptiveThreshold class decides boundaries relative to the local context of the distance series
+ * instead of a single global threshold. It keeps the distances of the last window frames in a ring buffer
+ * together with their running sum and sum of squares, so mean and variance are updated in constant time
+ * per frame. A distance is a boundary when it exceeds the rolling mean by sigmas standard
+ * deviations and is above ADAPTIVE_MIN_RATIO of the global threshold (which keeps noise of still scenes
+ * from triggering). Boundary distances are added clamped to the limit they exceeded, so a cut does not
+ * hide the next one, while a sustained rise of the distances (a change to a high-motion scene) raises the
+ * statistics until they follow it. Until the window is half full the global threshold decides.
+ *
+ * Distances are given as ratios to the global boundary distance (threshold scaled by the pixel count),
+ * so the global rule is ratio > 1.
+ */
+class AdaptiveThreshold
+{
+public:
+    AdaptiveThreshold(int window, double sigmas = ADAPTIVE_DEFAULT_SIGMAS);
+    bool update(double ratio);
+    static bool decide(AdaptiveThreshold *adaptive, double distance, double limit);
+    double mean() const;
+    double deviation() const;
+    double limit() const;
+    void saveState(Checkpoint &checkpoint) const;
+    bool loadState(Checkpoint &checkpoint);
+
+private:
+    std::vector<double> ring;
+    size_t next;                // slot of the next distance
+    size_t count;               // distances in the window
+    double sum;
+    double sumSquares;
+    double sigmas;
+};
+
+#endif // ADAPTIVETHRESHOLD_H
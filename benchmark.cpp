@@ -0,0 +1,569 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#include "benchmark.h"
+#include "shotdetector.h"
+#include "resultwriter.h"
+#include <opencv2/highgui/highgui.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+//minimum time spent on each microbenchmark, seconds
+#define MICROBENCHMARK_SECONDS 0.2
+//boundaries detected at most this many frames away from a transition are matched to it
+#define MATCH_TOLERANCE 1
+//sample frames of each shot written by output_benchmark
+#define OUTPUT_BENCHMARK_SAMPLES 2
+//largest displacement of a box per frame, as a fraction of the frame size, so frames of a shot stay alike
+#define SYNTHETIC_SPEED 0.01
+//largest displacement of a box per frame in the high-motion shots of generate_motion_video
+#define SYNTHETIC_MOTION_SPEED 0.05
+//amplitude in gray levels and period in frames of the changing light of the high-motion shots
+#define SYNTHETIC_MOTION_LIGHT 2
+#define SYNTHETIC_MOTION_PERIOD 12
+//window of the gradual transition detector measured by benchmark_suite
+#define GRADUAL_BENCHMARK_WINDOW 12
+
+using namespace cv;
+using namespace std;
+
+DetectionAccuracy::DetectionAccuracy(): detections(0), transitions(0), matched(0), cuts(0), cuts_matched(0),
+    precision(0), recall(0)
+{
+}
+
+namespace {
+
+/** content of a synthetic shot: a vertical gradient with rectangles moving over it **/
+struct SyntheticShot
+{
+    struct Box
+    {
+        Scalar color;
+        Size size;
+        Point2d position;
+        Point2d velocity;
+    };
+    SyntheticShot(Size frameSize, std::mt19937 &rng, double speed = SYNTHETIC_SPEED);
+    void render(int t, Mat &frame) const;
+    Mat background;
+    vector<Box> boxes;
+};
+
+Scalar random_color(std::mt19937 &rng){
+    std::uniform_int_distribution<int> channel(0, 255);
+    return Scalar(channel(rng), channel(rng), channel(rng));
+}
+
+SyntheticShot::SyntheticShot(Size frameSize, std::mt19937 &rng, double speed){
+    Scalar top = random_color(rng), bottom = random_color(rng);
+    background.create(frameSize, CV_8UC3);
+    for(int y = 0; y < frameSize.height; y++){
+        double w = (double) y / std::max(frameSize.height - 1, 1);
+        Scalar color(top[0] * (1 - w) + bottom[0] * w, top[1] * (1 - w) + bottom[1] * w, top[2] * (1 - w) + bottom[2] * w);
+        rectangle(background, Point(0, y), Point(frameSize.width - 1, y), color, CV_FILLED);
+    }
+    std::uniform_real_distribution<double> unit(0, 1);
+    for(int i = 0; i < 3; i++){
+        Box box;
+        box.color = random_color(rng);
+        box.size = Size(std::max(1, (int) (frameSize.width * (0.1 + 0.2 * unit(rng)))),
+                        std::max(1, (int) (frameSize.height * (0.1 + 0.2 * unit(rng)))));
+        box.position = Point2d(unit(rng) * frameSize.width, unit(rng) * frameSize.height);
+        box.velocity = Point2d((unit(rng) - 0.5) * 2 * speed * frameSize.width,
+                               (unit(rng) - 0.5) * 2 * speed * frameSize.height);
+        boxes.push_back(box);
+    }
+}
+
+/** renders frame t of the shot into frame **/
+void SyntheticShot::render(int t, Mat &frame) const{
+    background.copyTo(frame);
+    for(size_t i = 0; i < boxes.size(); i++){
+        const Box &box = boxes[i];
+        int x = (int) (box.position.x + box.velocity.x * t) % frame.cols;
+        int y = (int) (box.position.y + box.velocity.y * t) % frame.rows;
+        x = x < 0 ? x + frame.cols : x;
+        y = y < 0 ? y + frame.rows : y;
+        rectangle(frame, Point(x, y), Point(x + box.size.width - 1, y + box.size.height - 1), box.color, CV_FILLED);
+    }
+}
+
+/** median time of a call of f in seconds, f is repeated for at least MICROBENCHMARK_SECONDS **/
+template<typename F>
+double time_call(F f){
+    vector<double> times;
+    int64 start_t = getTickCount();
+    do{
+        int64 call_t = getTickCount();
+        f();
+        times.push_back((getTickCount() - call_t) / getTickFrequency());
+    }while((getTickCount() - start_t) / getTickFrequency() < MICROBENCHMARK_SECONDS || times.size() < 3);
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+/** shot ends detected by processVideo_NoGUI, read from its event stream **/
+vector<int> detected_boundaries(const string &events){
+    vector<int> boundaries;
+    stringstream lines(events);
+    string line;
+    while(getline(lines, line)){
+        if(line.find("\"event\":\"shot_end\"") == string::npos)
+            continue;
+        size_t pos = line.find("\"frame_number\":");
+        if(pos != string::npos)
+            boundaries.push_back(atoi(line.c_str() + pos + 15));
+    }
+    return boundaries;
+}
+
+/** first and last frames of the gradual transitions detected by processVideo_NoGUI, read from its event stream **/
+vector<std::pair<int, int> > detected_transitions(const string &events){
+    vector<std::pair<int, int> > transitions;
+    stringstream lines(events);
+    string line;
+    while(getline(lines, line)){
+        bool begin = line.find("\"event\":\"transition_begin\"") != string::npos;
+        if(!begin && line.find("\"event\":\"transition_end\"") == string::npos)
+            continue;
+        size_t pos = line.find("\"frame_number\":");
+        if(pos == string::npos)
+            continue;
+        int frame_number = atoi(line.c_str() + pos + 15);
+        if(begin)
+            transitions.push_back(std::make_pair(frame_number, frame_number));
+        else if(!transitions.empty())
+            transitions.back().second = frame_number;
+    }
+    return transitions;
+}
+
+}
+
+/**
+ * @brief generate_synthetic_video: Writes a video of random shots with VideoWriter (MJPG) and returns its transitions.
+ * Shots are 20 to 60 frames long and are joined by a cut (60%), a fade through black (20%) or a dissolve (20%)
+ * of 6 to 12 frames. The same seed gives the same video.
+ * @param path: video file (.avi)
+ * @param size: frame size
+ * @param frames: number of frames
+ * @param fps: frame rate
+ * @param seed: seed of the random shots and transitions
+ * @param truth: transitions of the video
+ * @return: false if the video cannot be written
+ */
+bool generate_synthetic_video(std::string path, cv::Size size, int frames, double fps, unsigned int seed,
+                              std::vector<SyntheticTransition> &truth){
+    VideoWriter writer(path, CV_FOURCC('M', 'J', 'P', 'G'), fps, size);
+    if(!writer.isOpened()){
+        cout << "error openning " << path << " for writing" << endl;
+        return false;
+    }
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> shotLength(20, 60), transitionLength(6, 12), transitionKind(0, 9);
+    truth.clear();
+
+    Mat frame, next, blended;
+    SyntheticShot shot(size, rng);
+    int t = 0;
+    int written = 0;
+    while(written < frames){
+        for(int length = shotLength(rng); length > 0 && written < frames; length--, written++){
+            shot.render(t++, frame);
+            writer << frame;
+        }
+        if(written >= frames)
+            break;
+        SyntheticShot nextShot(size, rng);
+        int kind = transitionKind(rng);
+        int length = transitionLength(rng);
+        SyntheticTransition transition;
+        transition.first_frame = written + 1;
+        if(kind < 6 || frames - written < 2 * length + 1){
+            transition.kind = SyntheticTransition::CUT;
+            transition.last_frame = written + 1;
+        }else if(kind < 8){
+            //shot fades out to black, the next one fades in
+            transition.kind = SyntheticTransition::FADE;
+            for(int i = 1; i <= 2 * length; i++, written++){
+                double alpha = i <= length ? 1. - (double) i / length : (double) (i - length) / length;
+                if(i <= length)
+                    shot.render(t++, frame);
+                else
+                    nextShot.render(i - length - 1, frame);
+                addWeighted(frame, alpha, frame, 0, 0, blended);
+                writer << blended;
+            }
+            transition.last_frame = written;
+        }else{
+            transition.kind = SyntheticTransition::DISSOLVE;
+            for(int i = 1; i <= length; i++, written++){
+                double w = (double) i / (length + 1);
+                shot.render(t++, frame);
+                nextShot.render(i - 1, next);
+                addWeighted(frame, 1 - w, next, w, 0, blended);
+                writer << blended;
+            }
+            //the first frame of the next shot still differs from the last blended one
+            transition.last_frame = written + 1;
+        }
+        truth.push_back(transition);
+        //the next shot continues after the frames rendered during the transition
+        t = transition.kind == SyntheticTransition::CUT ? 0 : length;
+        shot = nextShot;
+    }
+    writer.release();
+    return true;
+}
+
+/**
+ * @brief generate_motion_video: Writes a video of a still shot, three high-motion shots joined by cuts (boxes
+ * moving up to SYNTHETIC_MOTION_SPEED of the frame per frame under a changing light, so adjacent frames differ by
+ * more than the low ratio of a gradual transition but not by a boundary) and another still shot, each quarter of the video long except
+ * the motion shots, which share the middle half. The motion is no gradual transition: the cuts between and around
+ * the motion shots are its only transitions.
+ * @param path: video file (.avi)
+ * @param size: frame size
+ * @param frames: number of frames
+ * @param fps: frame rate
+ * @param seed: seed of the random shots
+ * @param truth: transitions of the video
+ * @return: false if the video cannot be written
+ */
+bool generate_motion_video(std::string path, cv::Size size, int frames, double fps, unsigned int seed,
+                           std::vector<SyntheticTransition> &truth){
+    VideoWriter writer(path, CV_FOURCC('M', 'J', 'P', 'G'), fps, size);
+    if(!writer.isOpened()){
+        cout << "error openning " << path << " for writing" << endl;
+        return false;
+    }
+    std::mt19937 rng(seed);
+    truth.clear();
+    //first frames of the shots, the last entry ends the video
+    int quarter = frames / 4;
+    int starts[] = {0, quarter, quarter + (frames / 2) / 3, quarter + 2 * (frames / 2) / 3, quarter + frames / 2, frames};
+    Mat frame;
+    for(int s = 0; s < 5; s++){
+        SyntheticShot shot(size, rng, s == 0 || s == 4 ? SYNTHETIC_SPEED : SYNTHETIC_MOTION_SPEED);
+        if(s > 0 && starts[s] < frames){
+            SyntheticTransition transition;
+            transition.kind = SyntheticTransition::CUT;
+            transition.first_frame = transition.last_frame = starts[s] + 1;
+            truth.push_back(transition);
+        }
+        for(int t = 0; starts[s] + t < starts[s + 1]; t++){
+            shot.render(t, frame);
+            if(s > 0 && s < 4)
+                frame.convertTo(frame, frame.type(), 1, SYNTHETIC_MOTION_LIGHT * sin(2 * CV_PI * t / SYNTHETIC_MOTION_PERIOD));
+            writer << frame;
+        }
+    }
+    writer.release();
+    return true;
+}
+
+/**
+ * @brief write_ground_truth: Writes transitions as lines of "cut|fade|dissolve first_frame last_frame".
+ */
+bool write_ground_truth(std::string path, const std::vector<SyntheticTransition> &truth){
+    ofstream file(path.c_str());
+    if(!file.is_open()){
+        cout << "error openning " << path << endl;
+        return false;
+    }
+    const char* kinds[] = {"cut", "fade", "dissolve"};
+    for(size_t i = 0; i < truth.size(); i++)
+        file << kinds[truth[i].kind] << " " << truth[i].first_frame << " " << truth[i].last_frame << "\n";
+    return file.good();
+}
+
+/**
+ * @brief read_ground_truth: Reads transitions written by write_ground_truth.
+ */
+bool read_ground_truth(std::string path, std::vector<SyntheticTransition> &truth){
+    ifstream file(path.c_str());
+    if(!file.is_open())
+        return false;
+    truth.clear();
+    string kind;
+    SyntheticTransition transition;
+    while(file >> kind >> transition.first_frame >> transition.last_frame){
+        transition.kind = kind == "fade" ? SyntheticTransition::FADE
+                        : kind == "dissolve" ? SyntheticTransition::DISSOLVE : SyntheticTransition::CUT;
+        truth.push_back(transition);
+    }
+    return true;
+}
+
+/**
+ * @brief evaluate_detections: Matches detected boundaries one to one with transitions: a boundary matches the first
+ * unmatched transition whose frames are within tolerance of it. Unmatched boundaries are false positives,
+ * unmatched transitions are misses.
+ * @param boundaries: frame numbers of the detected shot ends, in increasing order
+ * @param truth: transitions in increasing order
+ * @param tolerance: number of frames a boundary may be away from a transition
+ */
+DetectionAccuracy evaluate_detections(const std::vector<int> &boundaries, const std::vector<SyntheticTransition> &truth,
+                                      int tolerance){
+    DetectionAccuracy accuracy;
+    accuracy.detections = (int) boundaries.size();
+    accuracy.transitions = (int) truth.size();
+    vector<bool> matched(truth.size(), false);
+    for(size_t i = 0; i < truth.size(); i++)
+        accuracy.cuts += truth[i].kind == SyntheticTransition::CUT;
+    for(size_t b = 0; b < boundaries.size(); b++){
+        for(size_t i = 0; i < truth.size(); i++){
+            if(matched[i] || boundaries[b] < truth[i].first_frame - tolerance || boundaries[b] > truth[i].last_frame + tolerance)
+                continue;
+            matched[i] = true;
+            accuracy.matched++;
+            accuracy.cuts_matched += truth[i].kind == SyntheticTransition::CUT;
+            break;
+        }
+    }
+    accuracy.precision = accuracy.detections ? (double) accuracy.matched / accuracy.detections : 1.;
+    accuracy.recall = accuracy.transitions ? (double) accuracy.matched / accuracy.transitions : 1.;
+    return accuracy;
+}
+
+/**
+ * @brief benchmark_suite: Generates synthetic videos at 480p, 1080p and 4K and a 480p high-motion video (see
+ * generate_motion_video) under workPath and reports
+ *  - microbenchmarks on their frames: prepareFrame, compareHistCustom with every method and shotBoundaryDetect
+ *    (median time per call),
+ *  - end-to-end processVideo_NoGUI throughput (frames/sec, decoding and keyframe storing included) together with
+ *    precision and recall of the detected shot ends against the transitions of the video,
+ *  - the gradual transitions detected with a window of GRADUAL_BENCHMARK_WINDOW frames: how many overlap a fade
+ *    or dissolve, and how many are longer than the window or hold a cut (both 0 on a correct run).
+ * If videoFile has a ground truth next to it (videoFile.truth, see write_ground_truth), it is measured end-to-end too.
+ * @param videoFile: optional video with ground truth
+ * @param workPath: directory of the generated videos and of the results
+ * @param threshold: threshold of the detector
+ */
+void benchmark_suite(std::string videoFile, std::string workPath, double threshold){
+    struct Resolution
+    {
+        const char* name;
+        Size size;
+        int frames;
+    };
+    const Resolution resolutions[] = {{"480p", Size(854, 480), 600}, {"1080p", Size(1920, 1080), 300},
+                                      {"4K", Size(3840, 2160), 120}};
+    const int methods[] = {CV_COMP_CHISQR, CV_COMP_CORREL, CV_COMP_INTERSECT, CV_COMP_BHATTACHARYYA};
+    const char* methodNames[] = {"chisqr", "correl", "intersect", "bhattacharyya"};
+    const double fps = 25;
+
+    //create directory if not exists
+    if(!ResultWriter::createDirectories(workPath)){
+        cout << "error creating directory " << workPath << endl;
+        return;
+    }
+#ifdef _WIN32
+    string root = workPath + "\\";
+#else
+    string root = workPath + "/";
+#endif
+
+    vector<string> names, videos;
+    for(int r = 0; r < 3; r++){
+        stringstream video;
+        video << root << "synthetic_" << resolutions[r].name << ".avi";
+        vector<SyntheticTransition> truth;
+        cout << "generating " << video.str() << endl;
+        if(!generate_synthetic_video(video.str(), resolutions[r].size, resolutions[r].frames, fps, 2015 + r, truth)
+                || !write_ground_truth(video.str() + ".truth", truth))
+            return;
+        names.push_back(resolutions[r].name);
+        videos.push_back(video.str());
+    }
+    //high-motion shots between cuts, which must not be taken for one long gradual transition
+    {
+        string video = root + "synthetic_motion.avi";
+        vector<SyntheticTransition> truth;
+        cout << "generating " << video << endl;
+        if(!generate_motion_video(video, resolutions[0].size, resolutions[0].frames, fps, 2018, truth)
+                || !write_ground_truth(video + ".truth", truth))
+            return;
+        names.push_back("motion");
+        videos.push_back(video);
+    }
+    vector<SyntheticTransition> inputTruth;
+    if(!videoFile.empty() && read_ground_truth(videoFile + ".truth", inputTruth)){
+        names.push_back("input");
+        videos.push_back(videoFile);
+    }
+
+    cout << "microbenchmarks (microseconds per call)" << endl;
+    cout << "resolution\tprepareFrame";
+    for(int m = 0; m < 4; m++)
+        cout << "\tcompare " << methodNames[m];
+    cout << "\tshotBoundaryDetect" << endl;
+    for(int r = 0; r < 3; r++){
+        VideoCapture cap(videos[r]);
+        Mat prevFrame, frame;
+        cap >> prevFrame;
+        cap >> frame;
+        if(frame.empty()){
+            cout << "error openning video!!" << endl;
+            return;
+        }
+        ShotDetector sd(videos[r], threshold);
+        MatND prevHist = sd.prepareFrame(prevFrame), hist;
+        cout << names[r] << "\t" << 1e6 * time_call([&]{ hist = sd.prepareFrame(frame); });
+        for(int m = 0; m < 4; m++){
+            volatile double result = 0;
+            cout << "\t" << 1e6 * time_call([&]{ result = compareHistCustom(prevHist, hist, methods[m]); });
+            (void) result;
+        }
+        volatile bool boundary = false;
+        cout << "\t" << 1e6 * time_call([&]{ boundary = sd.shotBoundaryDetect(prevFrame, frame); }) << endl;
+        (void) boundary;
+    }
+
+    cout << "end-to-end (processVideo_NoGUI, threshold " << threshold << ")" << endl;
+    cout << "video\tframes\tseconds\tframes/sec\ttransitions\tdetected\tprecision\trecall\tcut recall" << endl;
+    for(size_t v = 0; v < videos.size(); v++){
+        vector<SyntheticTransition> truth;
+        read_ground_truth(videos[v] + ".truth", truth);
+        ShotDetector sd(videos[v], threshold, 0);
+        stringstream events;
+        sd.setEventStream(&events);
+        int64 start_t = getTickCount();
+        sd.processVideo_NoGUI(root + "result_" + names[v], ShotDetector::XML);
+        double seconds = (getTickCount() - start_t) / getTickFrequency();
+        DetectionAccuracy accuracy = evaluate_detections(detected_boundaries(events.str()), truth, MATCH_TOLERANCE);
+        cout << names[v] << "\t" << sd.processedFrameCount() << "\t" << seconds << "\t" << sd.processedFrameCount() / seconds
+             << "\t" << accuracy.transitions << "\t" << accuracy.detections << "\t" << accuracy.precision
+             << "\t" << accuracy.recall << "\t" << (accuracy.cuts ? (double) accuracy.cuts_matched / accuracy.cuts : 1.) << endl;
+    }
+
+    //every detected transition should overlap a fade or dissolve, none may be longer than the window or hold a cut
+    cout << "gradual transitions (processVideo_NoGUI, -gradual " << GRADUAL_BENCHMARK_WINDOW << ")" << endl;
+    cout << "video\tfades+dissolves\tdetected\tmatched\tlonger than window\tover a cut" << endl;
+    for(size_t v = 0; v < videos.size(); v++){
+        vector<SyntheticTransition> truth;
+        read_ground_truth(videos[v] + ".truth", truth);
+        ShotDetector sd(videos[v], threshold, 0);
+        sd.setGradualWindow(GRADUAL_BENCHMARK_WINDOW);
+        stringstream events;
+        sd.setEventStream(&events);
+        sd.processVideo_NoGUI(root + "result_gradual_" + names[v], ShotDetector::XML);
+        vector<std::pair<int, int> > detected = detected_transitions(events.str());
+        int gradual = 0, matched = 0, longer = 0, overCut = 0;
+        for(size_t i = 0; i < truth.size(); i++)
+            gradual += truth[i].kind != SyntheticTransition::CUT;
+        for(size_t d = 0; d < detected.size(); d++){
+            bool overlaps = false, cut = false;
+            for(size_t i = 0; i < truth.size(); i++){
+                if(truth[i].kind == SyntheticTransition::CUT)
+                    cut = cut || (truth[i].first_frame > detected[d].first && truth[i].first_frame <= detected[d].second);
+                else
+                    overlaps = overlaps || (truth[i].first_frame <= detected[d].second && truth[i].last_frame >= detected[d].first);
+            }
+            matched += overlaps;
+            longer += detected[d].second - detected[d].first + 1 > GRADUAL_BENCHMARK_WINDOW;
+            overCut += cut;
+        }
+        cout << names[v] << "\t" << gradual << "\t" << detected.size() << "\t" << matched << "\t" << longer
+             << "\t" << overCut << endl;
+    }
+}
+
+/**
+ * @brief output_benchmark: Writes the result file of a video with the given number of shots (each one with
+ * OUTPUT_BENCHMARK_SAMPLES sample frames, one frame per 40 ms) in every ResultWriter format and, for comparison,
+ * through cv::FileStorage the way result files were written before. Reports events/sec, MB/sec and file size.
+ * @param workPath: directory of the written files
+ * @param shots: number of shots of the simulated video
+ */
+void output_benchmark(std::string workPath, int shots){
+    const ResultWriter::Format formats[] = {ResultWriter::XML, ResultWriter::YAML, ResultWriter::TEXT,
+                                            ResultWriter::JSON, ResultWriter::BINARY};
+    const char* formatNames[] = {"xml", "yaml", "text", "json", "binary"};
+    const int frames_per_shot = 3 * (OUTPUT_BENCHMARK_SAMPLES + 1);
+    const int events = shots * (OUTPUT_BENCHMARK_SAMPLES + 2);
+
+    if(!ResultWriter::createDirectories(workPath)){
+        cout << "error creating directory " << workPath << endl;
+        return;
+    }
+#ifdef _WIN32
+    string root = workPath + "\\";
+#else
+    string root = workPath + "/";
+#endif
+    ResultWriter::Header header;
+    header.video_path = "benchmark.mp4";
+    header.fps = 25;
+    header.frame_count = shots * frames_per_shot;
+
+    cout << "result file output (" << shots << " shots, " << events << " events)" << endl;
+    cout << "writer	seconds	events/sec	MB/sec	bytes" << endl;
+    for(int f = 0; f < 6; f++){
+        int64 bytes = 0;
+        int64 start_t = getTickCount();
+        if(f < 5){
+            string path = root + "output_benchmark" + ResultWriter::extension(formats[f]);
+            std::unique_ptr<ResultWriter> results(ResultWriter::create(formats[f], path));
+            if(!results->isOpened()){
+                cout << "error openning " << path << endl;
+                return;
+            }
+            results->writeHeader(header);
+            results->beginShots();
+            for(int i = 0; i < shots; i++){
+                int frame_number = i * frames_per_shot + 1;
+                results->shotBegin(frame_number, frame_number * 40.);
+                for(int k = 1; k <= OUTPUT_BENCHMARK_SAMPLES; k++)
+                    results->shotSample(frame_number + 3 * k, (frame_number + 3 * k) * 40.);
+                results->shotEnd(frame_number + frames_per_shot - 1, (frame_number + frames_per_shot - 1) * 40.);
+            }
+            results->endShots();
+            bytes = results->close();
+        }else{
+            //one string per time, formatted with sprintf, as ShotDetector::miliseconds_to_DHMS did
+            auto dhms = [](double duration){
+                char buffer[20];
+                unsigned int seconds = duration / 1000;
+                int length = sprintf(buffer, "%02d:%02d", (int) (seconds / 60 % 60), (int) (seconds % 60));
+                return std::string(buffer, length);
+            };
+            string path = root + "output_benchmark_filestorage.xml";
+            FileStorage fstorage(path, FileStorage::WRITE);
+            fstorage << "Header" << "[" ;
+            fstorage << "{:" << "video_path" << header.video_path << "fps" << header.fps
+                     << "frame_count" << header.frame_count << "}" << "]" ;
+            fstorage << "Shots" << "[" ;
+            for(int i = 0; i < shots; i++){
+                int frame_number = i * frames_per_shot + 1;
+                fstorage << "{:" << "begin_frame_number" << frame_number << "begin_time" << dhms(frame_number * 40.);
+                for(int k = 1; k <= OUTPUT_BENCHMARK_SAMPLES; k++)
+                    fstorage << "frame_number" << frame_number + 3 * k << "time" << dhms((frame_number + 3 * k) * 40.);
+                fstorage << "end_frame_number" << frame_number + frames_per_shot - 1
+                         << "end_time" << dhms((frame_number + frames_per_shot - 1) * 40.) << "}";
+            }
+            fstorage << "]" ;
+            fstorage.release();
+            bytes = RunMetrics::fileSize(path);
+        }
+        double seconds = (getTickCount() - start_t) / getTickFrequency();
+        cout << (f < 5 ? formatNames[f] : "filestorage") << "\t" << seconds << "\t" << events / seconds
+             << "\t" << bytes / seconds / 1e6 << "\t" << bytes << endl;
+    }
+}
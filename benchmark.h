@@ -0,0 +1,58 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+#include <opencv2/core/core.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * transition of a synthetic video. Frames are numbered like the frame numbers of the result file
+ * (frame n is the n'th frame of the video), a cut is a single frame: the first one of the new shot.
+ * Fades go through black, dissolves blend the two shots.
+ */
+struct SyntheticTransition
+{
+    enum Kind {CUT, FADE, DISSOLVE};
+    Kind kind;
+    int first_frame;
+    int last_frame;
+};
+
+/** detected boundaries matched one to one with the transitions of the ground truth **/
+struct DetectionAccuracy
+{
+    DetectionAccuracy();
+    int detections;
+    int transitions;
+    int matched;
+    int cuts;
+    int cuts_matched;
+    double precision;
+    double recall;
+};
+
+bool generate_synthetic_video(std::string path, cv::Size size, int frames, double fps, unsigned int seed,
+                              std::vector<SyntheticTransition> &truth);
+bool generate_motion_video(std::string path, cv::Size size, int frames, double fps, unsigned int seed,
+                           std::vector<SyntheticTransition> &truth);
+bool write_ground_truth(std::string path, const std::vector<SyntheticTransition> &truth);
+bool read_ground_truth(std::string path, std::vector<SyntheticTransition> &truth);
+DetectionAccuracy evaluate_detections(const std::vector<int> &boundaries, const std::vector<SyntheticTransition> &truth,
+                                      int tolerance);
+void benchmark_suite(std::string videoFile, std::string workPath, double threshold);
+void output_benchmark(std::string workPath, int shots);
+
+#endif // BENCHMARK_H
@@ -0,0 +1,259 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#include "cascadedetector.h"
+#include "colorhistogram.h"
+#include "runmetrics.h"
+#include "shotdetector.h"
+#include <opencv2/imgproc/imgproc.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+
+CascadeDetector::StageStats::StageStats(): evaluated(0), passed(0), seconds(0)
+{
+}
+
+CascadeDetector::Stats::Stats(): frames(0), histograms(0)
+{
+}
+
+/**
+ * @brief CascadeDetector::CascadeDetector
+ * @param detector: detector whose histograms (sampling, tiles) and distance the chisqr stage uses
+ * @param stages: stages in the order they are run
+ * @param metrics: stage times of the run, 0 if disabled
+ */
+CascadeDetector::CascadeDetector(ShotDetector &detector, const std::vector<Stage> &stages, RunMetrics *metrics):
+    detector(detector), stages(stages), prev(0), first(true), boundaryAtPrev(false), metrics(metrics),
+    histogramTicks(0)
+{
+    counters.stages.resize(stages.size());
+    features[0].computed = features[1].computed = 0;
+    features[0].edgeCount = features[1].edgeCount = 0;
+}
+
+/**
+ * @brief CascadeDetector::update: Compares the next frame of the video with the previous one. The mad and coarse
+ * gates are skipped while the previous frame is a boundary.
+ * @param frame: BGR frame, which is kept until the next call
+ * @return: true if the frame passes every stage (false for the first frame)
+ */
+bool CascadeDetector::update(const cv::Mat &frame){
+    prev = 1 - prev;
+    Features &curr = features[1 - prev];
+    curr.frame = frame;
+    curr.computed = 0;
+    if(first){
+        first = false;
+        return false;
+    }
+    counters.frames++;
+    int64 update_t = RunMetrics::start(metrics);
+    histogramTicks = 0;
+    bool boundary = true;
+    for(size_t s = 0; s < stages.size() && boundary; s++){
+        //a gate which is the last stage decides
+        if(boundaryAtPrev && isGate(stages[s].metric) && s + 1 < stages.size())
+            continue;
+        StageStats &stats = counters.stages[s];
+        int64 start_t = getTickCount();
+        boundary = measure(stages[s].metric) > stages[s].threshold;
+        stats.seconds += (getTickCount() - start_t) / getTickFrequency();
+        stats.evaluated++;
+        if(boundary)
+            stats.passed++;
+    }
+    //the full histograms are recorded as the histogram stage
+    RunMetrics::stop(metrics, RunMetrics::COMPARE, update_t + histogramTicks);
+    boundaryAtPrev = boundary;
+    return boundary;
+}
+
+/**
+ * @brief CascadeDetector::isGate: Whether a metric only filters the frames for the later stages (mad, coarse).
+ */
+bool CascadeDetector::isGate(Metric metric){
+    return metric == MAD || metric == COARSE;
+}
+
+const CascadeDetector::Stats& CascadeDetector::stats() const{
+    return counters;
+}
+
+/**
+ * @brief CascadeDetector::compute: Computes the features of a metric for a frame, unless they are computed already.
+ * Buffers of the features are reused from frame to frame.
+ */
+void CascadeDetector::compute(Metric metric, Features &f){
+    unsigned bit = 1u << metric;
+    if(f.computed & bit)
+        return;
+    switch(metric){
+    case MAD:
+    case COARSE:
+        if(!(f.computed & ((1u << MAD) | (1u << COARSE)))){
+            int height = std::max(f.frame.rows * CASCADE_THUMBNAIL_WIDTH / std::max(f.frame.cols, 1), 1);
+            resize(f.frame, f.thumbnail, Size(CASCADE_THUMBNAIL_WIDTH, height), 0, 0, INTER_NEAREST);
+        }
+        if(metric == COARSE){
+            int channels[] = {0, 1, 2};
+            int histSize[] = {8, 8, 8};
+            float color_ranges[] = { 0, 256 };
+            const float* ranges[] = { color_ranges, color_ranges, color_ranges };
+            calcHist(&f.thumbnail, 1, channels, Mat(), f.coarse, 3, histSize, ranges, true, false);
+            f.coarse.convertTo(f.coarse, CV_32F, 1./f.thumbnail.total(), 0);
+        }
+        break;
+    case CHISQR:
+    case BHATTACHARYYA:
+        if(!(f.computed & ((1u << CHISQR) | (1u << BHATTACHARYYA)))){
+            int64 start_t = RunMetrics::start(metrics);
+            detector.prepareFrameCounts(f.frame, f.hist);
+            if(metrics){
+                int64 ticks = getTickCount() - start_t;
+                metrics->record(RunMetrics::HISTOGRAM, ticks);
+                histogramTicks += ticks;
+            }
+            counters.histograms++;
+        }
+        if(metric == BHATTACHARYYA)
+            f.hist.convertTo(f.normalized, CV_32F, 1./detector.sampledPixelCount(f.frame), 0);
+        break;
+    case ECR:
+    {
+        Mat small, gray;
+        int height = std::max(f.frame.rows * CASCADE_EDGE_WIDTH / std::max(f.frame.cols, 1), 1);
+        resize(f.frame, small, Size(CASCADE_EDGE_WIDTH, height), 0, 0, INTER_AREA);
+        if(small.channels() == 3)
+            cvtColor(small, gray, CV_BGR2GRAY);
+        else
+            gray = small;
+        Canny(gray, f.edges, 50, 150);
+        Mat kernel = getStructuringElement(MORPH_RECT, Size(2 * CASCADE_EDGE_RADIUS + 1, 2 * CASCADE_EDGE_RADIUS + 1));
+        dilate(f.edges, f.dilated, kernel);
+        f.edgeCount = countNonZero(f.edges);
+        break;
+    }
+    }
+    //the chisqr and bhattacharyya features share the histogram, mad and coarse the thumbnail
+    if(metric == BHATTACHARYYA)
+        bit |= 1u << CHISQR;
+    if(metric == COARSE)
+        bit |= 1u << MAD;
+    f.computed |= bit;
+}
+
+/**
+ * @brief CascadeDetector::measure: Returns the metric of the current frame against the previous one.
+ */
+double CascadeDetector::measure(Metric metric){
+    Features &p = features[prev];
+    Features &c = features[1 - prev];
+    compute(metric, p);
+    compute(metric, c);
+    switch(metric){
+    case MAD:
+    {
+        Mat diff;
+        absdiff(p.thumbnail, c.thumbnail, diff);
+        Scalar m = mean(diff);
+        return (m[0] + m[1] + m[2] + m[3]) / diff.channels();
+    }
+    case COARSE:
+        return compareHistCustom(p.coarse, c.coarse, CV_COMP_CHISQR);
+    case CHISQR:
+        return detector.histDistance(p.hist, c.hist) / detector.sampledPixelCount(c.frame);
+    case BHATTACHARYYA:
+        return compareHistCustom(p.normalized, c.normalized, CV_COMP_BHATTACHARYYA);
+    case ECR:
+    {
+        //edges entering the current frame far from every edge of the previous one, and exiting edges
+        if(p.edgeCount == 0 || c.edgeCount == 0)
+            return p.edgeCount == c.edgeCount ? 0 : 1;
+        Mat changed;
+        subtract(c.edges, p.dilated, changed);
+        double entering = (double) countNonZero(changed) / c.edgeCount;
+        subtract(p.edges, c.dilated, changed);
+        double exiting = (double) countNonZero(changed) / p.edgeCount;
+        return std::max(entering, exiting);
+    }
+    }
+    return 0;
+}
+
+/**
+ * @brief CascadeDetector::parse: Parses a comma separated list of stages, each one a metric name (mad, coarse,
+ * chisqr, bhattacharyya, ecr) optionally followed by =threshold. Default thresholds are the CASCADE_* constants,
+ * threshold for chisqr, threshold * CASCADE_MAD_RATIO for mad and threshold * CASCADE_COARSE_RATIO for coarse,
+ * with the threshold of the gates limited to CASCADE_GATE_LIMIT.
+ * @param threshold: boundary threshold of the detector
+ * @return: false if a metric is unknown or the list is empty
+ */
+bool CascadeDetector::parse(const std::string &spec, double threshold, std::vector<Stage> &stages){
+    stages.clear();
+    double gateThreshold = std::min(threshold, (double) CASCADE_GATE_LIMIT);
+    stringstream list(spec);
+    string item;
+    while(getline(list, item, ',')){
+        if(item.empty())
+            continue;
+        size_t equals = item.find('=');
+        string name = item.substr(0, equals);
+        Stage stage;
+        if(name == "mad"){
+            stage.metric = MAD;
+            stage.threshold = gateThreshold * CASCADE_MAD_RATIO;
+        }else if(name == "coarse"){
+            stage.metric = COARSE;
+            stage.threshold = gateThreshold * CASCADE_COARSE_RATIO;
+        }else if(name == "chisqr"){
+            stage.metric = CHISQR;
+            stage.threshold = threshold;
+        }else if(name == "bhattacharyya"){
+            stage.metric = BHATTACHARYYA;
+            stage.threshold = CASCADE_BHATTACHARYYA_THRESHOLD;
+        }else if(name == "ecr"){
+            stage.metric = ECR;
+            stage.threshold = CASCADE_ECR_THRESHOLD;
+        }else{
+            cout << "unknown cascade stage " << name << endl;
+            return false;
+        }
+        if(equals != string::npos)
+            stage.threshold = atof(item.c_str() + equals + 1);
+        stages.push_back(stage);
+    }
+    return !stages.empty();
+}
+
+const char* CascadeDetector::metricName(Metric metric){
+    switch(metric){
+    case MAD:
+        return "mad";
+    case COARSE:
+        return "coarse";
+    case CHISQR:
+        return "chisqr";
+    case BHATTACHARYYA:
+        return "bhattacharyya";
+    case ECR:
+        return "ecr";
+    }
+    return "";
+}
@@ -0,0 +1,117 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#ifndef CASCADEDETECTOR_H
+#define CASCADEDETECTOR_H
+#include <opencv2/core/core.hpp>
+#include <string>
+#include <vector>
+
+class RunMetrics;
+class ShotDetector;
+
+//width of the thumbnails of the mad and coarse stages, sampled from the frame without filtering
+#define CASCADE_THUMBNAIL_WIDTH 128
+//width of the frames the edges of the ecr stage are detected on
+#define CASCADE_EDGE_WIDTH 160
+//distance in pixels within which an edge of one frame counts as the same edge in the other
+#define CASCADE_EDGE_RADIUS 2
+//default thresholds: mean absolute difference of thumbnails in gray levels per unit of the boundary threshold
+#define CASCADE_MAD_RATIO 10
+//coarse histogram distance as a fraction of the boundary threshold (merging bins only lowers the distance)
+#define CASCADE_COARSE_RATIO 0.25
+//boundary threshold (the default one) above which the mad and coarse thresholds stop growing: a frame passing a
+//higher threshold passes this one as well, so the gates stay as loose as they are for it
+#define CASCADE_GATE_LIMIT 0.49
+//Bhattacharyya distance of the full histograms
+#define CASCADE_BHATTACHARYYA_THRESHOLD 0.3
+//edge change ratio
+#define CASCADE_ECR_THRESHOLD 0.4
+
+/**
+ * @brief The CascadeDetector class decides shot boundaries with a sequence of tests of increasing cost, each one
+ * run only on the frames which passed the ones before it. A frame is a boundary when it passes every stage.
+ * Cheap first stages (mad, the mean absolute difference of small thumbnails, or coarse, the Chi-Square distance
+ * of their 8x8x8 histograms) reject most frames of a shot, so the full histogram (chisqr, the decision of
+ * ShotDetector) and secondary metrics (bhattacharyya on the full histograms, ecr, the edge change ratio) are
+ * only computed around cuts. Features of the previous frame are computed when a stage first needs them, so a
+ * frame which stops at the first stage costs its thumbnail only. A gate (mad or coarse) which rejects a frame the
+ * later stages would pass loses a boundary: coarse misses cuts between shots whose colors fall into the same
+ * coarse bins, mad is the safer gate. Both thresholds scale with the boundary threshold. While the previous
+ * frame is a boundary (inside a fade or dissolve, whose frames differ less from each other than across a cut) the
+ * gates are skipped, so a transition is not split by a frame a gate rejects.
+ *
+ * Every stage counts the frames it evaluated and passed and the time it took, see Stats. With RunMetrics, full
+ * histograms are recorded as the histogram stage and the rest of the decision as the compare stage.
+ */
+class CascadeDetector
+{
+public:
+    enum Metric {MAD, COARSE, CHISQR, BHATTACHARYYA, ECR};
+    struct Stage
+    {
+        Metric metric;
+        double threshold;           // a frame passes the stage when its metric exceeds the threshold
+    };
+    struct StageStats
+    {
+        StageStats();
+        int evaluated;
+        int passed;
+        double seconds;             // features of both frames and the metric
+    };
+    struct Stats
+    {
+        Stats();
+        std::vector<StageStats> stages;
+        int frames;                 // frames compared with the previous one
+        int histograms;             // full histograms computed
+    };
+
+    CascadeDetector(ShotDetector &detector, const std::vector<Stage> &stages, RunMetrics *metrics = 0);
+    bool update(const cv::Mat &frame);
+    const Stats& stats() const;
+    static bool parse(const std::string &spec, double threshold, std::vector<Stage> &stages);
+    static const char* metricName(Metric metric);
+
+private:
+    /** features of a frame, computed on demand **/
+    struct Features
+    {
+        cv::Mat frame;
+        cv::Mat thumbnail;
+        cv::MatND coarse;           // normalized 8x8x8 histogram of the thumbnail
+        cv::MatND hist;             // full histogram (bin counts) of ShotDetector::prepareFrameCounts
+        cv::MatND normalized;       // hist divided by the pixel count
+        cv::Mat edges;              // edge map and the edge map dilated by CASCADE_EDGE_RADIUS
+        cv::Mat dilated;
+        int edgeCount;
+        unsigned computed;          // bit (1 << metric) for the features of each metric
+    };
+    void compute(Metric metric, Features &features);
+    double measure(Metric metric);
+    static bool isGate(Metric metric);
+
+    ShotDetector &detector;
+    std::vector<Stage> stages;
+    Features features[2];
+    int prev;                       // features of the previous frame, 1 - prev is the current one
+    bool first;
+    bool boundaryAtPrev;            // the previous frame passed every stage, gates are skipped
+    Stats counters;
+    RunMetrics *metrics;
+    int64 histogramTicks;           // time of the full histograms of the current frame, recorded apart from compare
+};
+
+#endif // CASCADEDETECTOR_H
@@ -0,0 +1,235 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#include "checkpoint.h"
+#include "sidecarfile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace cv;
+using namespace std;
+
+#define CHECKPOINT_MAGIC "SHOTCKP"
+#define CHECKPOINT_BYTE_ORDER 0x01020304u
+//dimensions of a histogram stored in a checkpoint
+#define CHECKPOINT_MAX_DIMS 8
+
+Checkpoint::Checkpoint(): offset(0), readFailed(false)
+{
+    memset(&header, 0, sizeof(Header));
+}
+
+/**
+ * @brief Checkpoint::clear: Starts a new checkpoint.
+ */
+void Checkpoint::clear(){
+    data.clear();
+    offset = 0;
+    readFailed = false;
+}
+
+void Checkpoint::put(const void *bytes, size_t size){
+    const uchar *p = (const uchar*) bytes;
+    data.insert(data.end(), p, p + size);
+}
+
+void Checkpoint::putInt(int64_t value){
+    put(&value, sizeof(value));
+}
+
+void Checkpoint::putDouble(double value){
+    put(&value, sizeof(value));
+}
+
+/**
+ * @brief Checkpoint::putHist: Stores the dimensions, type and nonzero bins of a continuous histogram (or an empty one).
+ */
+void Checkpoint::putHist(const cv::MatND &hist){
+    if(hist.empty() || !hist.isContinuous() || hist.dims > CHECKPOINT_MAX_DIMS){
+        putInt(0);
+        return;
+    }
+    putInt(hist.dims);
+    for(int d = 0; d < hist.dims; d++)
+        putInt(hist.size[d]);
+    putInt(hist.type());
+    size_t elemSize = hist.elemSize();
+    size_t total = hist.total();
+    size_t countOffset = data.size();
+    putInt(0);
+    int64_t nonzero = 0;
+    static const uchar zeros[64] = {0};
+    for(size_t i = 0; i < total; i++){
+        const uchar *bin = hist.data + i * elemSize;
+        if(memcmp(bin, zeros, elemSize) == 0)
+            continue;
+        uint32_t index = (uint32_t) i;
+        put(&index, sizeof(index));
+        put(bin, elemSize);
+        nonzero++;
+    }
+    memcpy(&data[countOffset], &nonzero, sizeof(nonzero));
+}
+
+/**
+ * @brief Checkpoint::write: Writes the checkpoint put so far to path.tmp and moves it over path.
+ * @param videoPath: video the checkpoint belongs to
+ * @param frame_count: frames processed
+ */
+bool Checkpoint::write(const std::string &path, const std::string &videoPath, int frame_count){
+    memset(&header, 0, sizeof(Header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.version = VERSION;
+    header.byte_order = CHECKPOINT_BYTE_ORDER;
+    header.header_size = sizeof(Header);
+    header.frame_count = frame_count;
+    header.data_size = (int64_t) data.size();
+    SidecarFile::videoStat(videoPath, header.video_size, header.video_mtime);
+
+    SidecarFile file;
+    FILE *output = file.create(path);
+    if(!output)
+        return false;
+    fwrite(&header, sizeof(Header), 1, output);
+    if(!data.empty())
+        fwrite(&data[0], 1, data.size(), output);
+    //the checkpoint must survive the machine, not only the process
+    return file.commit(true);
+}
+
+/**
+ * @brief Checkpoint::size: Bytes of the state put so far.
+ */
+size_t Checkpoint::size() const{
+    return data.size();
+}
+
+/**
+ * @brief Checkpoint::read: Reads a checkpoint and checks its header.
+ * @return: false if the file does not exist, is truncated or was written by another version or byte order
+ */
+bool Checkpoint::read(const std::string &path){
+    clear();
+    FILE *input = fopen(path.c_str(), "rb");
+    if(!input)
+        return false;
+    bool valid = fread(&header, sizeof(Header), 1, input) == 1
+            && memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) == 0 && header.version == VERSION
+            && header.byte_order == CHECKPOINT_BYTE_ORDER && header.header_size == sizeof(Header)
+            && header.frame_count > 0 && header.data_size >= 0;
+    if(valid){
+        data.resize((size_t) header.data_size);
+        valid = data.empty() || fread(&data[0], 1, data.size(), input) == data.size();
+    }
+    fclose(input);
+    if(!valid){
+        memset(&header, 0, sizeof(Header));
+        data.clear();
+    }
+    return valid;
+}
+
+/**
+ * @brief Checkpoint::matches: Returns true if the checkpoint read was written for the video as it is now
+ * (same size and modification time).
+ */
+bool Checkpoint::matches(const std::string &videoPath) const{
+    int64_t size, mtime;
+    if(header.frame_count <= 0 || !SidecarFile::videoStat(videoPath, size, mtime))
+        return false;
+    return header.video_size == size && header.video_mtime == mtime;
+}
+
+int Checkpoint::frameCount() const{
+    return header.frame_count;
+}
+
+bool Checkpoint::get(void *bytes, size_t size){
+    if(readFailed || offset + size > data.size()){
+        readFailed = true;
+        memset(bytes, 0, size);
+        return false;
+    }
+    memcpy(bytes, &data[offset], size);
+    offset += size;
+    return true;
+}
+
+int64_t Checkpoint::getInt(){
+    int64_t value;
+    get(&value, sizeof(value));
+    return value;
+}
+
+double Checkpoint::getDouble(){
+    double value;
+    get(&value, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Checkpoint::getHist: Reads a histogram stored by putHist.
+ * @return: false if the checkpoint is corrupt
+ */
+bool Checkpoint::getHist(cv::MatND &hist){
+    int dims = (int) getInt();
+    if(dims == 0){
+        hist.release();
+        return !readFailed;
+    }
+    if(dims < 0 || dims > CHECKPOINT_MAX_DIMS){
+        readFailed = true;
+        return false;
+    }
+    int sizes[CHECKPOINT_MAX_DIMS];
+    for(int d = 0; d < dims; d++)
+        sizes[d] = (int) getInt();
+    int type = (int) getInt();
+    int64_t nonzero = getInt();
+    if(readFailed)
+        return false;
+    hist.create(dims, sizes, type);
+    hist = Scalar::all(0);
+    size_t elemSize = hist.elemSize();
+    size_t total = hist.total();
+    for(int64_t i = 0; i < nonzero; i++){
+        uint32_t index;
+        if(!get(&index, sizeof(index)) || index >= total){
+            readFailed = true;
+            return false;
+        }
+        get(hist.data + (size_t) index * elemSize, elemSize);
+    }
+    return !readFailed;
+}
+
+/**
+ * @brief Checkpoint::failed: Returns true if a get read past the end of the checkpoint.
+ */
+bool Checkpoint::failed() const{
+    return readFailed;
+}
+
+/**
+ * @brief Checkpoint::tell: Read position, to read the state after it again with seek.
+ */
+size_t Checkpoint::tell() const{
+    return offset;
+}
+
+void Checkpoint::seek(size_t position){
+    offset = std::min(position, data.size());
+    readFailed = false;
+}
@@ -0,0 +1,77 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+#include <opencv2/core/core.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The Checkpoint class keeps the state of a detection run in a small file, so that a run which is
+ * interrupted (a crash, a preempted machine) can be resumed from the last checkpoint instead of the first frame.
+ * The state is serialized field by field with the put methods and read back in the same order with the get
+ * methods, each class saving and loading its own part (see ShotStream::saveState).
+ *
+ * File layout (little endian): a Header followed by data_size bytes of state. Histograms are stored sparse,
+ * as the offsets and values of their nonzero bins. A checkpoint is written to path.tmp and renamed over path,
+ * so the file always holds a complete checkpoint.
+ */
+class Checkpoint
+{
+public:
+    struct Header
+    {
+        char magic[8];              // "SHOTCKP"
+        uint32_t version;
+        uint32_t byte_order;        // 0x01020304 as written by the host
+        uint32_t header_size;
+        int32_t frame_count;        // frames processed when the checkpoint was taken
+        int64_t data_size;
+        int64_t video_size;         // size and modification time of the video the checkpoint belongs to
+        int64_t video_mtime;
+    };
+
+    Checkpoint();
+    //writing
+    void clear();
+    void put(const void *bytes, size_t size);
+    void putInt(int64_t value);
+    void putDouble(double value);
+    void putHist(const cv::MatND &hist);
+    bool write(const std::string &path, const std::string &videoPath, int frame_count);
+    size_t size() const;
+    //reading
+    bool read(const std::string &path);
+    bool matches(const std::string &videoPath) const;
+    int frameCount() const;
+    bool get(void *bytes, size_t size);
+    int64_t getInt();
+    double getDouble();
+    bool getHist(cv::MatND &hist);
+    bool failed() const;
+    size_t tell() const;
+    void seek(size_t position);
+
+    static const uint32_t VERSION = 3;
+
+private:
+    Header header;
+    std::vector<uchar> data;
+    size_t offset;                  // read position in data
+    bool readFailed;                // a get went past the end of data
+};
+
+#endif // CHECKPOINT_H
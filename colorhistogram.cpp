@@ -0,0 +1,949 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#include "colorhistogram.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#  include <immintrin.h>
+#  define COLOR_HIST_X86 1
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#  define COLOR_HIST_ARM_NEON 1
+#endif
+#if defined(__GNUC__)
+#  define COLOR_HIST_TARGET(isa) __attribute__((target(isa)))
+#else
+#  define COLOR_HIST_TARGET(isa)
+#endif
+
+//each strip of a parallel histogram covers at least this many pixels
+#define COLOR_HIST_MIN_STRIP_PIXELS (1 << 18)
+
+using namespace cv;
+
+namespace {
+
+/** accumulates one row of BGR pixels into 4 interleaved sub-histograms **/
+typedef void (*ColorHistRowFunc)(const uchar* p, int width, int* h);
+
+/**
+ * bin of b,g,r pixel, equal to the bin calcHist computes for 32 bins over (0, 256):
+ * each channel is quantized with >>3 and the histogram is indexed as [b][g][r].
+ */
+inline int colorBin(const uchar* p){
+    return ((p[0] >> 3) << 10) | ((p[1] >> 3) << 5) | (p[2] >> 3);
+}
+
+/**
+ * Consecutive pixels are counted in different sub-histograms, so runs of pixels with the same
+ * color (which are common in video) do not wait on the store of the previous increment.
+ */
+void colorHistRow_generic(const uchar* p, int width, int* h){
+    int* h0 = h;
+    int* h1 = h + COLOR_HIST_TOTAL_BINS;
+    int* h2 = h + 2 * COLOR_HIST_TOTAL_BINS;
+    int* h3 = h + 3 * COLOR_HIST_TOTAL_BINS;
+    int x = 0;
+    for( ; x <= width - 4; x += 4, p += 12 )
+    {
+        h0[colorBin(p)]++;
+        h1[colorBin(p + 3)]++;
+        h2[colorBin(p + 6)]++;
+        h3[colorBin(p + 9)]++;
+    }
+    for( ; x < width; x++, p += 3 )
+        h0[colorBin(p)]++;
+}
+
+#ifdef COLOR_HIST_X86
+/**
+ * 4 pixels are expanded to 32 bit lanes as 0x00rrggbb and their bins are computed as
+ * ((v & 0xF8) << 7) | ((v & 0xF800) >> 6) | ((v & 0xF80000) >> 19)
+ */
+COLOR_HIST_TARGET("ssse3")
+void colorHistRow_ssse3(const uchar* p, int width, int* h){
+    int* h0 = h;
+    int* h1 = h + COLOR_HIST_TOTAL_BINS;
+    int* h2 = h + 2 * COLOR_HIST_TOTAL_BINS;
+    int* h3 = h + 3 * COLOR_HIST_TOTAL_BINS;
+    const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i maskB = _mm_set1_epi32(0xF8);
+    const __m128i maskG = _mm_set1_epi32(0xF800);
+    const __m128i maskR = _mm_set1_epi32(0xF80000);
+    int bins[4];
+    int x = 0;
+    // 16 bytes are loaded for 4 pixels, so stop before reading past the end of row
+    for( ; x + 6 <= width; x += 4, p += 12 )
+    {
+        __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)p), expand);
+        __m128i b = _mm_slli_epi32(_mm_and_si128(v, maskB), 7);
+        __m128i g = _mm_srli_epi32(_mm_and_si128(v, maskG), 6);
+        __m128i r = _mm_srli_epi32(_mm_and_si128(v, maskR), 19);
+        _mm_storeu_si128((__m128i*)bins, _mm_or_si128(_mm_or_si128(b, g), r));
+        h0[bins[0]]++;
+        h1[bins[1]]++;
+        h2[bins[2]]++;
+        h3[bins[3]]++;
+    }
+    colorHistRow_generic(p, width - x, h);
+}
+
+/**
+ * Same as the SSSE3 version for 8 pixels: the 24 bytes are split over the two 128 bit lanes
+ * (dwords 0-3 and 3-6) before the in-lane byte shuffle.
+ */
+COLOR_HIST_TARGET("avx2")
+void colorHistRow_avx2(const uchar* p, int width, int* h){
+    int* h0 = h;
+    int* h1 = h + COLOR_HIST_TOTAL_BINS;
+    int* h2 = h + 2 * COLOR_HIST_TOTAL_BINS;
+    int* h3 = h + 3 * COLOR_HIST_TOTAL_BINS;
+    const __m256i split = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+    const __m256i expand = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m256i maskB = _mm256_set1_epi32(0xF8);
+    const __m256i maskG = _mm256_set1_epi32(0xF800);
+    const __m256i maskR = _mm256_set1_epi32(0xF80000);
+    int bins[8];
+    int x = 0;
+    // 32 bytes are loaded for 8 pixels, so stop before reading past the end of row
+    for( ; x + 11 <= width; x += 8, p += 24 )
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        v = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(v, split), expand);
+        __m256i b = _mm256_slli_epi32(_mm256_and_si256(v, maskB), 7);
+        __m256i g = _mm256_srli_epi32(_mm256_and_si256(v, maskG), 6);
+        __m256i r = _mm256_srli_epi32(_mm256_and_si256(v, maskR), 19);
+        _mm256_storeu_si256((__m256i*)bins, _mm256_or_si256(_mm256_or_si256(b, g), r));
+        h0[bins[0]]++;
+        h1[bins[1]]++;
+        h2[bins[2]]++;
+        h3[bins[3]]++;
+        h0[bins[4]]++;
+        h1[bins[5]]++;
+        h2[bins[6]]++;
+        h3[bins[7]]++;
+    }
+    colorHistRow_generic(p, width - x, h);
+}
+#endif
+
+#ifdef COLOR_HIST_ARM_NEON
+/** vld3 deinterleaves 16 pixels into b, g and r planes, bins are built in 16 bit lanes **/
+void colorHistRow_neon(const uchar* p, int width, int* h){
+    int* h0 = h;
+    int* h1 = h + COLOR_HIST_TOTAL_BINS;
+    int* h2 = h + 2 * COLOR_HIST_TOTAL_BINS;
+    int* h3 = h + 3 * COLOR_HIST_TOTAL_BINS;
+    unsigned short bins[16];
+    int x = 0;
+    for( ; x + 16 <= width; x += 16, p += 48 )
+    {
+        uint8x16x3_t v = vld3q_u8(p);
+        uint8x16_t b = vshrq_n_u8(v.val[0], 3);
+        uint8x16_t g = vshrq_n_u8(v.val[1], 3);
+        uint8x16_t r = vshrq_n_u8(v.val[2], 3);
+        uint16x8_t lo = vorrq_u16(vorrq_u16(vshlq_n_u16(vmovl_u8(vget_low_u8(b)), 10),
+                                            vshlq_n_u16(vmovl_u8(vget_low_u8(g)), 5)),
+                                  vmovl_u8(vget_low_u8(r)));
+        uint16x8_t hi = vorrq_u16(vorrq_u16(vshlq_n_u16(vmovl_u8(vget_high_u8(b)), 10),
+                                            vshlq_n_u16(vmovl_u8(vget_high_u8(g)), 5)),
+                                  vmovl_u8(vget_high_u8(r)));
+        vst1q_u16(bins, lo);
+        vst1q_u16(bins + 8, hi);
+        for( int k = 0; k < 16; k += 4 )
+        {
+            h0[bins[k]]++;
+            h1[bins[k + 1]]++;
+            h2[bins[k + 2]]++;
+            h3[bins[k + 3]]++;
+        }
+    }
+    colorHistRow_generic(p, width - x, h);
+}
+#endif
+
+ColorHistRowFunc colorHistRowFunc(int kernel){
+    switch(kernel){
+    case COLOR_HIST_GENERIC:
+        return colorHistRow_generic;
+#ifdef COLOR_HIST_X86
+    case COLOR_HIST_SSSE3:
+        return colorHistRow_ssse3;
+    case COLOR_HIST_AVX2:
+        return colorHistRow_avx2;
+#endif
+#ifdef COLOR_HIST_ARM_NEON
+    case COLOR_HIST_NEON:
+        return colorHistRow_neon;
+#endif
+    default:
+        return 0;
+    }
+}
+
+int bestColorHistKernel(){
+    static const int best = colorHistKernelSupported(COLOR_HIST_AVX2) ? COLOR_HIST_AVX2 :
+                            colorHistKernelSupported(COLOR_HIST_SSSE3) ? COLOR_HIST_SSSE3 :
+                            colorHistKernelSupported(COLOR_HIST_NEON) ? COLOR_HIST_NEON : COLOR_HIST_GENERIC;
+    return best;
+}
+
+/**
+ * sub-histograms of the calling thread. They are kept between calls,
+ * so the steady state of the detection loop does not allocate.
+ */
+int* threadSubHistograms(){
+    static thread_local std::vector<int> subHist;
+    if(subHist.empty())
+        subHist.resize(4 * COLOR_HIST_TOTAL_BINS);
+    return &subHist[0];
+}
+
+/**
+ * counts rows [y0, y1) of the frame into the thread's sub-histograms and returns them.
+ */
+int* accumulateRows(const Mat& frame, int y0, int y1, ColorHistRowFunc rowFunc){
+    int* h = threadSubHistograms();
+    memset(h, 0, 4 * COLOR_HIST_TOTAL_BINS * sizeof(int));
+    int width = frame.cols;
+    if(frame.isContinuous())
+    {
+        width *= y1 - y0;
+        y1 = y0 + 1;
+    }
+    for( int y = y0; y < y1; y++ )
+        rowFunc(frame.ptr<uchar>(y), width, h);
+    return h;
+}
+
+/** adds the 4 sub-histograms into dst **/
+template<typename T>
+void sumSubHistograms(const int* h, T* dst){
+    for( int i = 0; i < COLOR_HIST_TOTAL_BINS; i++ )
+        dst[i] = (T) (h[i] + h[i + COLOR_HIST_TOTAL_BINS] + h[i + 2 * COLOR_HIST_TOTAL_BINS] + h[i + 3 * COLOR_HIST_TOTAL_BINS]);
+}
+
+/** counts every pixelStride'th pixel of a row, ceil(width / pixelStride) pixels in total **/
+void colorHistRowStrided(const uchar* p, int width, int pixelStride, int* h){
+    int* h0 = h;
+    int* h1 = h + COLOR_HIST_TOTAL_BINS;
+    int* h2 = h + 2 * COLOR_HIST_TOTAL_BINS;
+    int* h3 = h + 3 * COLOR_HIST_TOTAL_BINS;
+    int step = 3 * pixelStride;
+    int x = 0;
+    for( ; x < width - 3 * pixelStride; x += 4 * pixelStride, p += 4 * step )
+    {
+        h0[colorBin(p)]++;
+        h1[colorBin(p + step)]++;
+        h2[colorBin(p + 2 * step)]++;
+        h3[colorBin(p + 3 * step)]++;
+    }
+    for( ; x < width; x += pixelStride, p += step )
+        h0[colorBin(p)]++;
+}
+
+/** luma bin combined with the chroma bin ((u >> 3) << 5 | (v >> 3)) shared by the pixel **/
+inline int yuvBin(int y, int chroma){
+    return ((y >> 3) << 10) | chroma;
+}
+
+/** counts an I420 frame, every chroma sample is shared by the 2x2 luma block it covers **/
+void yuvHistI420(const Mat& frame, int* h){
+    int* h0 = h;
+    int* h1 = h + COLOR_HIST_TOTAL_BINS;
+    int* h2 = h + 2 * COLOR_HIST_TOTAL_BINS;
+    int* h3 = h + 3 * COLOR_HIST_TOTAL_BINS;
+    int width = frame.cols, height = frame.rows * 2 / 3;
+    const uchar* U = frame.data + (size_t) width * height;
+    const uchar* V = U + (size_t) (width / 2) * (height / 2);
+    for( int y = 0; y < height; y += 2, U += width / 2, V += width / 2 )
+    {
+        const uchar* Y0 = frame.ptr<uchar>(y);
+        const uchar* Y1 = frame.ptr<uchar>(y + 1);
+        for( int x = 0; x < width; x += 2 )
+        {
+            int chroma = ((U[x >> 1] >> 3) << 5) | (V[x >> 1] >> 3);
+            h0[yuvBin(Y0[x], chroma)]++;
+            h1[yuvBin(Y0[x + 1], chroma)]++;
+            h2[yuvBin(Y1[x], chroma)]++;
+            h3[yuvBin(Y1[x + 1], chroma)]++;
+        }
+    }
+}
+
+/** counts a YUYV frame, every chroma pair is shared by the 2 luma samples around it **/
+void yuvHistYUYV(const Mat& frame, int* h){
+    int* h0 = h;
+    int* h1 = h + COLOR_HIST_TOTAL_BINS;
+    for( int y = 0; y < frame.rows; y++ )
+    {
+        const uchar* p = frame.ptr<uchar>(y);
+        for( int x = 0; x < frame.cols; x += 2, p += 4 )
+        {
+            int chroma = ((p[1] >> 3) << 5) | (p[3] >> 3);
+            h0[yuvBin(p[0], chroma)]++;
+            h1[yuvBin(p[2], chroma)]++;
+        }
+    }
+}
+
+/** horizontal strips of the frame are counted in parallel and summed into total **/
+class ColorHistStrips : public ParallelLoopBody
+{
+public:
+    ColorHistStrips(const Mat& frame, int strips, ColorHistRowFunc rowFunc, int* total, std::mutex& totalMutex):
+        frame(frame), strips(strips), rowFunc(rowFunc), total(total), totalMutex(totalMutex)
+    {
+    }
+    void operator()(const Range& range) const{
+        for( int s = range.start; s < range.end; s++ )
+        {
+            const int* h = accumulateRows(frame, frame.rows * s / strips, frame.rows * (s + 1) / strips, rowFunc);
+            std::lock_guard<std::mutex> lock(totalMutex);
+            for( int i = 0; i < COLOR_HIST_TOTAL_BINS; i++ )
+                total[i] += h[i] + h[i + COLOR_HIST_TOTAL_BINS] + h[i + 2 * COLOR_HIST_TOTAL_BINS] + h[i + 3 * COLOR_HIST_TOTAL_BINS];
+        }
+    }
+private:
+    const Mat& frame;
+    int strips;
+    ColorHistRowFunc rowFunc;
+    int* total;
+    std::mutex& totalMutex;
+};
+
+/**
+ * tiles of a grid x grid split of the frame are counted in parallel, each into its own histogram.
+ * Tiles are numbered in strip order (left to right, top to bottom), so the tiles a thread counts in
+ * a row are next to each other in memory.
+ */
+class ColorHistTiles : public ParallelLoopBody
+{
+public:
+    ColorHistTiles(const Mat& frame, int grid, int pixelStride, ColorHistRowFunc rowFunc, Mat& hist):
+        frame(frame), grid(grid), pixelStride(pixelStride), rowFunc(rowFunc), hist(hist)
+    {
+    }
+    void operator()(const Range& range) const{
+        for( int t = range.start; t < range.end; t++ )
+        {
+            int ty = t / grid, tx = t % grid;
+            Mat tile = frame(Range(frame.rows * ty / grid, frame.rows * (ty + 1) / grid),
+                             Range(frame.cols * tx / grid, frame.cols * (tx + 1) / grid));
+            const int* h;
+            if( pixelStride == 1 )
+                h = accumulateRows(tile, 0, tile.rows, rowFunc);
+            else
+            {
+                int* sub = threadSubHistograms();
+                memset(sub, 0, 4 * COLOR_HIST_TOTAL_BINS * sizeof(int));
+                for( int y = 0; y < tile.rows; y++ )
+                    colorHistRowStrided(tile.ptr<uchar>(y), tile.cols, pixelStride, sub);
+                h = sub;
+            }
+            uchar* dst = hist.data + t * hist.step[0];
+            if( hist.type() == CV_32S )
+                sumSubHistograms(h, (int*)dst);
+            else
+                sumSubHistograms(h, (float*)dst);
+        }
+    }
+private:
+    const Mat& frame;
+    int grid;
+    int pixelStride;
+    ColorHistRowFunc rowFunc;
+    Mat& hist;
+};
+
+}
+
+/**
+ * @brief cv::calcColorHist: Computes the 32x32x32 color histogram of a BGR frame in a single pass.
+ * The result is identical to calcHist with 32 bins over (0, 256) for each channel,
+ * (bin counts of CV_32F type, not normalized) but pixels are quantized with a shift
+ * and counted in integer bins. Large frames are split into strips counted on parallel threads.
+ * Frames which are not 8 bit, 3 channel images are passed to calcHist.
+ * @param _frame: input frame (CV_8UC3)
+ * @param hist: output histogram, its storage is reused when already allocated
+ * @param type: type of bin counts, CV_32F (same as calcHist) or CV_32S
+ * @param kernel: implementation to be used, COLOR_HIST_AUTO selects the fastest supported one
+ */
+void cv::calcColorHist( InputArray _frame, MatND& hist, int type, int kernel )
+{
+    Mat frame = _frame.getMat();
+    int histSize[] = {COLOR_HIST_BINS, COLOR_HIST_BINS, COLOR_HIST_BINS};
+    if( frame.type() != CV_8UC3 )
+    {
+        int channels[] = {0, 1, 2};
+        // color ranges for rgb channels are between (0, 256)
+        float color_ranges[] = { 0, 256 };
+        const float* ranges[] = { color_ranges, color_ranges, color_ranges };
+        calcHist(&frame, 1, channels, Mat(), hist, 3, histSize, ranges, true, false);
+        if( type != CV_32F )
+            hist.convertTo(hist, type);
+        return;
+    }
+    CV_Assert( type == CV_32F || type == CV_32S );
+    if( kernel == COLOR_HIST_AUTO )
+        kernel = bestColorHistKernel();
+    if( !colorHistKernelSupported(kernel) )
+        CV_Error( CV_StsBadArg, "Color histogram kernel is not supported" );
+    ColorHistRowFunc rowFunc = colorHistRowFunc(kernel);
+
+    hist.create(3, histSize, type);
+    int strips = std::min(getNumThreads(), (int) (frame.total() / COLOR_HIST_MIN_STRIP_PIXELS));
+    strips = std::min(strips, frame.rows);
+    if( strips <= 1 )
+    {
+        const int* h = accumulateRows(frame, 0, frame.rows, rowFunc);
+        if( type == CV_32S )
+            sumSubHistograms(h, (int*)hist.data);
+        else
+            sumSubHistograms(h, (float*)hist.data);
+        return;
+    }
+
+    static thread_local std::vector<int> total(COLOR_HIST_TOTAL_BINS);
+    std::fill(total.begin(), total.end(), 0);
+    std::mutex totalMutex;
+    parallel_for_(Range(0, strips), ColorHistStrips(frame, strips, rowFunc, &total[0], totalMutex));
+    if( type == CV_32S )
+        std::copy(total.begin(), total.end(), (int*)hist.data);
+    else
+        std::copy(total.begin(), total.end(), (float*)hist.data);
+}
+
+/**
+ * @brief cv::calcColorHistSampled: Computes the color histogram of calcColorHist on a subset of the pixels:
+ * every rowStride'th row and every pixelStride'th pixel of these rows, starting from the top left pixel.
+ * Rows are skipped with a matrix header, without copying the frame. The histogram has
+ * ceil(rows / rowStride) * ceil(cols / pixelStride) counts.
+ * @param _frame: input frame (CV_8UC3)
+ * @param hist: output histogram, its storage is reused when already allocated
+ * @param pixelStride: distance of sampled pixels in a row, 1 samples every pixel
+ * @param rowStride: distance of sampled rows, 1 samples every row
+ * @param type: type of bin counts, CV_32F or CV_32S
+ */
+void cv::calcColorHistSampled( InputArray _frame, MatND& hist, int pixelStride, int rowStride, int type )
+{
+    Mat frame = _frame.getMat();
+    CV_Assert( pixelStride >= 1 && rowStride >= 1 );
+    if( rowStride > 1 )
+    {
+        CV_Assert( frame.dims == 2 );
+        frame = Mat((frame.rows + rowStride - 1) / rowStride, frame.cols, frame.type(), frame.data, frame.step[0] * rowStride);
+    }
+    if( pixelStride == 1 )
+    {
+        calcColorHist(frame, hist, type);
+        return;
+    }
+    CV_Assert( frame.type() == CV_8UC3 && (type == CV_32F || type == CV_32S) );
+
+    int histSize[] = {COLOR_HIST_BINS, COLOR_HIST_BINS, COLOR_HIST_BINS};
+    hist.create(3, histSize, type);
+    int* h = threadSubHistograms();
+    memset(h, 0, 4 * COLOR_HIST_TOTAL_BINS * sizeof(int));
+    for( int y = 0; y < frame.rows; y++ )
+        colorHistRowStrided(frame.ptr<uchar>(y), frame.cols, pixelStride, h);
+    if( type == CV_32S )
+        sumSubHistograms(h, (int*)hist.data);
+    else
+        sumSubHistograms(h, (float*)hist.data);
+}
+
+/**
+ * @brief cv::calcColorHistTiles: Splits the frame into a grid x grid layout of tiles and computes the color
+ * histogram of calcColorHist of every tile. Tiles are counted in parallel, one tile per task, instead of one
+ * histogram in strips. Sampling is the one of calcColorHistSampled: every rowStride'th row of the frame, and
+ * every pixelStride'th pixel of these rows starting from the left edge of each tile.
+ * @param _frame: input frame (CV_8UC3)
+ * @param hist: output histograms (grid * grid x 32x32x32, 4 dimensions), the histogram of tile (tx, ty)
+ * is hist[ty * grid + tx]. Its storage is reused when already allocated
+ * @param grid: tiles per side, 1 computes a single histogram of the whole frame in a 4 dimensional matrix
+ * @param pixelStride: distance of sampled pixels in a row, 1 samples every pixel
+ * @param rowStride: distance of sampled rows, 1 samples every row
+ * @param type: type of bin counts, CV_32F or CV_32S
+ */
+void cv::calcColorHistTiles( InputArray _frame, MatND& hist, int grid, int pixelStride, int rowStride, int type )
+{
+    Mat frame = _frame.getMat();
+    CV_Assert( frame.type() == CV_8UC3 && frame.dims == 2 && (type == CV_32F || type == CV_32S) );
+    CV_Assert( grid >= 1 && pixelStride >= 1 && rowStride >= 1 );
+    if( rowStride > 1 )
+        frame = Mat((frame.rows + rowStride - 1) / rowStride, frame.cols, frame.type(), frame.data, frame.step[0] * rowStride);
+
+    int histSize[] = {grid * grid, COLOR_HIST_BINS, COLOR_HIST_BINS, COLOR_HIST_BINS};
+    hist.create(4, histSize, type);
+    ColorHistRowFunc rowFunc = colorHistRowFunc(bestColorHistKernel());
+    parallel_for_(Range(0, grid * grid), ColorHistTiles(frame, grid, pixelStride, rowFunc, hist));
+}
+
+/**
+ * @brief cv::colorHistTilePixels: Returns the number of pixels calcColorHistTiles counts in the histograms
+ * of a frame of the given size, which is the sum of their bin counts.
+ */
+double cv::colorHistTilePixels( Size size, int grid, int pixelStride, int rowStride )
+{
+    double columns = 0;
+    for( int tx = 0; tx < grid; tx++ )
+    {
+        int width = size.width * (tx + 1) / grid - size.width * tx / grid;
+        columns += (width + pixelStride - 1) / pixelStride;
+    }
+    return columns * ((size.height + rowStride - 1) / rowStride);
+}
+
+/**
+ * @brief cv::calcYUVHist: Computes the 32x32x32 histogram of a frame in the YUV layout delivered by
+ * the decoder, so the frame does not have to be converted to BGR first. Bins are indexed as
+ * (y >> 3, u >> 3, v >> 3) in the place of (b, g, r), every luma sample is counted once together
+ * with the chroma sample it was subsampled to. The histogram has the same size and type as the
+ * one of calcColorHist and can be compared with compareHistCustom, but distances are measured in
+ * YUV space, so thresholds tuned on BGR histograms have to be calibrated (see -benchyuv).
+ * @param _frame: CV_8UC1 I420 frame (rows * 3/2) or CV_8UC2 YUYV frame, width and height must be even
+ * @param hist: output histogram, its storage is reused when already allocated
+ * @param layout: YUV_I420 or YUV_YUYV
+ * @param type: type of bin counts, CV_32F or CV_32S
+ */
+void cv::calcYUVHist( InputArray _frame, MatND& hist, int layout, int type )
+{
+    Mat frame = _frame.getMat();
+    CV_Assert( type == CV_32F || type == CV_32S );
+    if( layout == YUV_I420 )
+        CV_Assert( frame.type() == CV_8UC1 && frame.isContinuous() && frame.rows % 3 == 0 && frame.cols % 2 == 0 );
+    else if( layout == YUV_YUYV )
+        CV_Assert( frame.type() == CV_8UC2 && frame.cols % 2 == 0 );
+    else
+        CV_Error( CV_StsBadArg, "Unknown YUV layout" );
+
+    int histSize[] = {COLOR_HIST_BINS, COLOR_HIST_BINS, COLOR_HIST_BINS};
+    hist.create(3, histSize, type);
+    int* h = threadSubHistograms();
+    memset(h, 0, 4 * COLOR_HIST_TOTAL_BINS * sizeof(int));
+    if( layout == YUV_I420 )
+        yuvHistI420(frame, h);
+    else
+        yuvHistYUYV(frame, h);
+    if( type == CV_32S )
+        sumSubHistograms(h, (int*)hist.data);
+    else
+        sumSubHistograms(h, (float*)hist.data);
+}
+
+/**
+ * @brief cv::yuvFramePixels: Returns the number of pixels of an unconverted frame, which is the total count
+ * of its calcYUVHist histogram.
+ */
+int cv::yuvFramePixels( InputArray _frame, int layout )
+{
+    Mat frame = _frame.getMat();
+    return layout == YUV_I420 ? frame.cols * (frame.rows * 2 / 3) : frame.cols * frame.rows;
+}
+
+/**
+ * @brief cv::colorHistKernelSupported: Returns true if given kernel is compiled in and supported by the CPU.
+ */
+bool cv::colorHistKernelSupported( int kernel )
+{
+    switch(kernel){
+    case COLOR_HIST_AUTO:
+    case COLOR_HIST_GENERIC:
+        return true;
+#ifdef COLOR_HIST_X86
+    case COLOR_HIST_SSSE3:
+        return checkHardwareSupport(CV_CPU_SSSE3);
+#ifdef CV_CPU_AVX2
+    case COLOR_HIST_AVX2:
+        return checkHardwareSupport(CV_CPU_AVX2);
+#endif
+#endif
+#ifdef COLOR_HIST_ARM_NEON
+    case COLOR_HIST_NEON:
+        return checkHardwareSupport(CV_CPU_NEON);
+#endif
+    default:
+        return false;
+    }
+}
+
+const char* cv::colorHistKernelName( int kernel )
+{
+    switch(kernel){
+    case COLOR_HIST_AUTO:
+        return colorHistKernelName(bestColorHistKernel());
+    case COLOR_HIST_GENERIC:
+        return "generic";
+    case COLOR_HIST_SSSE3:
+        return "ssse3";
+    case COLOR_HIST_AVX2:
+        return "avx2";
+    case COLOR_HIST_NEON:
+        return "neon";
+    default:
+        return "unknown";
+    }
+}
+
+namespace {
+
+/** partial sums of a histogram comparison, sums which are not used by a method stay zero **/
+struct HistSums
+{
+    HistSums(): result(0), s1(0), s2(0), s11(0), s12(0), s22(0) {}
+    double result, s1, s2, s11, s12, s22;
+};
+
+typedef void (*CompareHistFunc)(const float* h1, const float* h2, int len, HistSums& sums);
+
+/**
+ * Every method is compiled as its own specialization, so the method is not tested for every bin.
+ * Zero denominators of chi-square are masked without a branch.
+ */
+template<int METHOD>
+void compareHist_generic(const float* h1, const float* h2, int len, HistSums& sums){
+    for( int j = 0; j < len; j++ )
+    {
+        double a = h1[j];
+        double b = h2[j];
+        if( METHOD == CV_COMP_CHISQR )
+        {
+            double d = a - b;
+            double s = a + b;
+            sums.result += std::fabs(s) > FLT_EPSILON ? d*d/s : 0.;
+        }
+        else if( METHOD == CV_COMP_CORREL )
+        {
+            sums.s12 += a*b;
+            sums.s1 += a;
+            sums.s11 += a*a;
+            sums.s2 += b;
+            sums.s22 += b*b;
+        }
+        else if( METHOD == CV_COMP_INTERSECT )
+        {
+            sums.result += std::min(h1[j], h2[j]);
+        }
+        else if( METHOD == CV_COMP_BHATTACHARYYA )
+        {
+            sums.result += std::sqrt(a*b);
+            sums.s1 += a;
+            sums.s2 += b;
+        }
+    }
+}
+
+/** chi-square of integer bin counts, a zero sum of counts means an empty bin in both histograms **/
+void compareChiSquareCounts_generic(const int* h1, const int* h2, int len, HistSums& sums){
+    for( int j = 0; j < len; j++ )
+    {
+        int s = h1[j] + h2[j];
+        double d = h1[j] - h2[j];
+        sums.result += s != 0 ? d*d/s : 0.;
+    }
+}
+
+#ifdef COLOR_HIST_X86
+struct HistSums_sse2
+{
+    HistSums_sse2(): result(_mm_setzero_pd()), s1(result), s2(result), s11(result), s12(result), s22(result) {}
+    __m128d result, s1, s2, s11, s12, s22;
+};
+
+inline double sumLanes(__m128d v){
+    double lanes[2];
+    _mm_storeu_pd(lanes, v);
+    return lanes[0] + lanes[1];
+}
+
+template<int METHOD>
+inline void compareLanes_sse2(__m128 fa, __m128 fb, HistSums_sse2& sums){
+    __m128d a = _mm_cvtps_pd(fa);
+    __m128d b = _mm_cvtps_pd(fb);
+    if( METHOD == CV_COMP_CHISQR )
+    {
+        const __m128d absMask = _mm_castsi128_pd(_mm_set_epi32(0x7fffffff, -1, 0x7fffffff, -1));
+        __m128d d = _mm_sub_pd(a, b);
+        __m128d s = _mm_add_pd(a, b);
+        __m128d valid = _mm_cmpgt_pd(_mm_and_pd(s, absMask), _mm_set1_pd(FLT_EPSILON));
+        sums.result = _mm_add_pd(sums.result, _mm_and_pd(valid, _mm_div_pd(_mm_mul_pd(d, d), s)));
+    }
+    else if( METHOD == CV_COMP_CORREL )
+    {
+        sums.s12 = _mm_add_pd(sums.s12, _mm_mul_pd(a, b));
+        sums.s1 = _mm_add_pd(sums.s1, a);
+        sums.s11 = _mm_add_pd(sums.s11, _mm_mul_pd(a, a));
+        sums.s2 = _mm_add_pd(sums.s2, b);
+        sums.s22 = _mm_add_pd(sums.s22, _mm_mul_pd(b, b));
+    }
+    else if( METHOD == CV_COMP_INTERSECT )
+    {
+        sums.result = _mm_add_pd(sums.result, _mm_cvtps_pd(_mm_min_ps(fa, fb)));
+    }
+    else if( METHOD == CV_COMP_BHATTACHARYYA )
+    {
+        sums.result = _mm_add_pd(sums.result, _mm_sqrt_pd(_mm_mul_pd(a, b)));
+        sums.s1 = _mm_add_pd(sums.s1, a);
+        sums.s2 = _mm_add_pd(sums.s2, b);
+    }
+}
+
+/** 4 bins per iteration, converted to double in 2 lane halves **/
+template<int METHOD>
+void compareHist_sse2(const float* h1, const float* h2, int len, HistSums& sums){
+    HistSums_sse2 v;
+    int j = 0;
+    for( ; j <= len - 4; j += 4 )
+    {
+        __m128 a = _mm_loadu_ps(h1 + j);
+        __m128 b = _mm_loadu_ps(h2 + j);
+        compareLanes_sse2<METHOD>(a, b, v);
+        compareLanes_sse2<METHOD>(_mm_movehl_ps(a, a), _mm_movehl_ps(b, b), v);
+    }
+    sums.result += sumLanes(v.result);
+    sums.s1 += sumLanes(v.s1);
+    sums.s2 += sumLanes(v.s2);
+    sums.s11 += sumLanes(v.s11);
+    sums.s12 += sumLanes(v.s12);
+    sums.s22 += sumLanes(v.s22);
+    compareHist_generic<METHOD>(h1 + j, h2 + j, len - j, sums);
+}
+
+void compareChiSquareCounts_sse2(const int* h1, const int* h2, int len, HistSums& sums){
+    __m128d result = _mm_setzero_pd();
+    int j = 0;
+    for( ; j <= len - 2; j += 2 )
+    {
+        __m128i a = _mm_loadl_epi64((const __m128i*)(h1 + j));
+        __m128i b = _mm_loadl_epi64((const __m128i*)(h2 + j));
+        __m128i s = _mm_add_epi32(a, b);
+        __m128d d = _mm_cvtepi32_pd(_mm_sub_epi32(a, b));
+        __m128d valid = _mm_cmpneq_pd(_mm_cvtepi32_pd(s), _mm_setzero_pd());
+        result = _mm_add_pd(result, _mm_and_pd(valid, _mm_div_pd(_mm_mul_pd(d, d), _mm_cvtepi32_pd(s))));
+    }
+    sums.result += sumLanes(result);
+    compareChiSquareCounts_generic(h1 + j, h2 + j, len - j, sums);
+}
+
+//no constructor, vectors are zeroed in the AVX function which uses them
+struct HistSums_avx
+{
+    __m256d result, s1, s2, s11, s12, s22;
+};
+
+COLOR_HIST_TARGET("avx")
+inline double sumLanes(__m256d v){
+    double lanes[4];
+    _mm256_storeu_pd(lanes, v);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+template<int METHOD>
+COLOR_HIST_TARGET("avx")
+inline void compareLanes_avx(__m128 fa, __m128 fb, HistSums_avx& sums){
+    __m256d a = _mm256_cvtps_pd(fa);
+    __m256d b = _mm256_cvtps_pd(fb);
+    if( METHOD == CV_COMP_CHISQR )
+    {
+        const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+        __m256d d = _mm256_sub_pd(a, b);
+        __m256d s = _mm256_add_pd(a, b);
+        __m256d valid = _mm256_cmp_pd(_mm256_and_pd(s, absMask), _mm256_set1_pd(FLT_EPSILON), _CMP_GT_OQ);
+        sums.result = _mm256_add_pd(sums.result, _mm256_and_pd(valid, _mm256_div_pd(_mm256_mul_pd(d, d), s)));
+    }
+    else if( METHOD == CV_COMP_CORREL )
+    {
+        sums.s12 = _mm256_add_pd(sums.s12, _mm256_mul_pd(a, b));
+        sums.s1 = _mm256_add_pd(sums.s1, a);
+        sums.s11 = _mm256_add_pd(sums.s11, _mm256_mul_pd(a, a));
+        sums.s2 = _mm256_add_pd(sums.s2, b);
+        sums.s22 = _mm256_add_pd(sums.s22, _mm256_mul_pd(b, b));
+    }
+    else if( METHOD == CV_COMP_INTERSECT )
+    {
+        sums.result = _mm256_add_pd(sums.result, _mm256_cvtps_pd(_mm_min_ps(fa, fb)));
+    }
+    else if( METHOD == CV_COMP_BHATTACHARYYA )
+    {
+        sums.result = _mm256_add_pd(sums.result, _mm256_sqrt_pd(_mm256_mul_pd(a, b)));
+        sums.s1 = _mm256_add_pd(sums.s1, a);
+        sums.s2 = _mm256_add_pd(sums.s2, b);
+    }
+}
+
+/** 8 bins per iteration, converted to double in 2 halves of 4 lanes **/
+template<int METHOD>
+COLOR_HIST_TARGET("avx")
+void compareHist_avx(const float* h1, const float* h2, int len, HistSums& sums){
+    HistSums_avx v;
+    v.result = v.s1 = v.s2 = v.s11 = v.s12 = v.s22 = _mm256_setzero_pd();
+    int j = 0;
+    for( ; j <= len - 8; j += 8 )
+    {
+        __m256 a = _mm256_loadu_ps(h1 + j);
+        __m256 b = _mm256_loadu_ps(h2 + j);
+        compareLanes_avx<METHOD>(_mm256_castps256_ps128(a), _mm256_castps256_ps128(b), v);
+        compareLanes_avx<METHOD>(_mm256_extractf128_ps(a, 1), _mm256_extractf128_ps(b, 1), v);
+    }
+    sums.result += sumLanes(v.result);
+    sums.s1 += sumLanes(v.s1);
+    sums.s2 += sumLanes(v.s2);
+    sums.s11 += sumLanes(v.s11);
+    sums.s12 += sumLanes(v.s12);
+    sums.s22 += sumLanes(v.s22);
+    compareHist_generic<METHOD>(h1 + j, h2 + j, len - j, sums);
+}
+
+COLOR_HIST_TARGET("avx")
+void compareChiSquareCounts_avx(const int* h1, const int* h2, int len, HistSums& sums){
+    __m256d result = _mm256_setzero_pd();
+    int j = 0;
+    for( ; j <= len - 4; j += 4 )
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(h1 + j));
+        __m128i b = _mm_loadu_si128((const __m128i*)(h2 + j));
+        __m256d s = _mm256_cvtepi32_pd(_mm_add_epi32(a, b));
+        __m256d d = _mm256_cvtepi32_pd(_mm_sub_epi32(a, b));
+        __m256d valid = _mm256_cmp_pd(s, _mm256_setzero_pd(), _CMP_NEQ_OQ);
+        result = _mm256_add_pd(result, _mm256_and_pd(valid, _mm256_div_pd(_mm256_mul_pd(d, d), s)));
+    }
+    sums.result += sumLanes(result);
+    compareChiSquareCounts_generic(h1 + j, h2 + j, len - j, sums);
+}
+#endif
+
+template<int METHOD>
+CompareHistFunc compareHistFunc(int kernel){
+#ifdef COLOR_HIST_X86
+    if( kernel == COLOR_HIST_AVX2 )
+        return compareHist_avx<METHOD>;
+    if( kernel == COLOR_HIST_SSSE3 )
+        return compareHist_sse2<METHOD>;
+#endif
+    return compareHist_generic<METHOD>;
+}
+
+typedef void (*CompareCountsFunc)(const int* h1, const int* h2, int len, HistSums& sums);
+
+CompareCountsFunc compareCountsFunc(int kernel){
+#ifdef COLOR_HIST_X86
+    if( kernel == COLOR_HIST_AVX2 )
+        return compareChiSquareCounts_avx;
+    if( kernel == COLOR_HIST_SSSE3 )
+        return compareChiSquareCounts_sse2;
+#endif
+    return compareChiSquareCounts_generic;
+}
+
+}
+
+/**
+ * @brief cv::compareHistCustom: Compares two histograms with the fastest kernel supported by the CPU.
+ * See compareHistKernel.
+ */
+double cv::compareHistCustom( InputArray _H1, InputArray _H2, int method )
+{
+    return compareHistKernel(_H1, _H2, method, COLOR_HIST_AUTO);
+}
+
+/**
+ * @brief cv::compareHistKernel: Compares two histograms with CV_COMP_CHISQR, CV_COMP_CORREL,
+ * CV_COMP_INTERSECT or CV_COMP_BHATTACHARYYA like compareHist. The method is selected once
+ * for a specialized inner loop. The generic kernel adds the bins in the same order and with
+ * the same arithmetic as a plain loop; SIMD kernels keep 2 (SSE2) or 4 (AVX) partial sums,
+ * so their results differ from the generic kernel only by rounding, within 1e-12 relative.
+ * Histograms of CV_32S bin counts can be compared with CV_COMP_CHISQR: the distance is computed
+ * on the integer counts without conversion, and equals the distance of normalized histograms
+ * times the pixel count (within 1e-6 relative, the rounding of normalized CV_32F bins), so it
+ * is compared with a threshold scaled by the pixel count.
+ * @param _H1: first histogram
+ * @param _H2: second histogram, of the same type and size as _H1
+ * @param method: comparison method
+ * @param kernel: implementation to be used, COLOR_HIST_AUTO selects the fastest supported one
+ * @return: distance of the histograms
+ */
+double cv::compareHistKernel( InputArray _H1, InputArray _H2, int method, int kernel )
+{
+    Mat H1 = _H1.getMat(), H2 = _H2.getMat();
+    const Mat* arrays[] = {&H1, &H2, 0};
+    Mat planes[2];
+    NAryMatIterator it(arrays, planes);
+    double result = 0;
+    int len = (int)it.size;
+
+    CV_Assert( H1.type() == H2.type() && (H1.type() == CV_32F || (H1.type() == CV_32S && method == CV_COMP_CHISQR)) );
+    CV_Assert( it.planes[0].isContinuous() && it.planes[1].isContinuous() );
+
+    if( kernel == COLOR_HIST_AUTO )
+        kernel = bestColorHistKernel();
+    if( !colorHistKernelSupported(kernel) )
+        CV_Error( CV_StsBadArg, "Histogram comparison kernel is not supported" );
+
+    HistSums sums;
+    if( H1.type() == CV_32S )
+    {
+        CompareCountsFunc func = compareCountsFunc(kernel);
+        for( size_t i = 0; i < it.nplanes; i++, ++it )
+        {
+            len = it.planes[0].rows*it.planes[0].cols;
+            func((const int*)it.planes[0].data, (const int*)it.planes[1].data, len, sums);
+        }
+        return sums.result;
+    }
+
+    CompareHistFunc func;
+    if( method == CV_COMP_CHISQR )
+        func = compareHistFunc<CV_COMP_CHISQR>(kernel);
+    else if( method == CV_COMP_CORREL )
+        func = compareHistFunc<CV_COMP_CORREL>(kernel);
+    else if( method == CV_COMP_INTERSECT )
+        func = compareHistFunc<CV_COMP_INTERSECT>(kernel);
+    else if( method == CV_COMP_BHATTACHARYYA )
+        func = compareHistFunc<CV_COMP_BHATTACHARYYA>(kernel);
+    else
+        CV_Error( CV_StsBadArg, "Unknown comparison method" );
+
+    for( size_t i = 0; i < it.nplanes; i++, ++it )
+    {
+        len = it.planes[0].rows*it.planes[0].cols;
+        func((const float*)it.planes[0].data, (const float*)it.planes[1].data, len, sums);
+    }
+    result = sums.result;
+
+    if( method == CV_COMP_CORREL )
+    {
+        size_t total = H1.total();
+        double scale = 1./total;
+        double num = sums.s12 - sums.s1*sums.s2*scale;
+        double denom2 = (sums.s11 - sums.s1*sums.s1*scale)*(sums.s22 - sums.s2*sums.s2*scale);
+        result = std::abs(denom2) > DBL_EPSILON ? num/std::sqrt(denom2) : 1.;
+    }
+    else if( method == CV_COMP_BHATTACHARYYA )
+    {
+        double s1 = sums.s1 * sums.s2;
+        s1 = fabs(s1) > FLT_EPSILON ? 1./std::sqrt(s1) : 1.;
+        result = std::sqrt(std::max(1. - result*s1, 0.));
+    }
+
+    return result;
+}
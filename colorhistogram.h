@@ -0,0 +1,50 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#ifndef COLORHISTOGRAM_H
+#define COLORHISTOGRAM_H
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+//histogram size (bins) for b,g,r channels equal to 32.
+#define COLOR_HIST_BINS 32
+#define COLOR_HIST_TOTAL_BINS (COLOR_HIST_BINS * COLOR_HIST_BINS * COLOR_HIST_BINS)
+
+namespace cv {
+/**
+ * implementations of calcColorHist and compareHistKernel, COLOR_HIST_AUTO selects the fastest one
+ * supported by the CPU. Comparison kernels need SSE2 for COLOR_HIST_SSSE3 and AVX for COLOR_HIST_AVX2,
+ * they fall back to the generic kernel on NEON.
+ */
+enum ColorHistKernel {COLOR_HIST_AUTO, COLOR_HIST_GENERIC, COLOR_HIST_SSSE3, COLOR_HIST_AVX2, COLOR_HIST_NEON};
+/**
+ * unconverted frame layouts accepted by calcYUVHist: planar 4:2:0 (CV_8UC1, rows * 3/2, Y plane followed
+ * by U and V planes) and packed 4:2:2 (CV_8UC2, Y0 U Y1 V).
+ */
+enum YUVLayout {YUV_I420, YUV_YUYV};
+
+void calcColorHist( InputArray _frame, MatND& hist, int type = CV_32F, int kernel = COLOR_HIST_AUTO );
+void calcColorHistSampled( InputArray _frame, MatND& hist, int pixelStride, int rowStride, int type = CV_32F );
+void calcColorHistTiles( InputArray _frame, MatND& hist, int grid, int pixelStride = 1, int rowStride = 1, int type = CV_32F );
+double colorHistTilePixels( Size size, int grid, int pixelStride = 1, int rowStride = 1 );
+void calcYUVHist( InputArray _frame, MatND& hist, int layout, int type = CV_32F );
+int yuvFramePixels( InputArray _frame, int layout );
+bool colorHistKernelSupported( int kernel );
+const char* colorHistKernelName( int kernel );
+
+double compareHistCustom( InputArray _H1, InputArray _H2, int method );
+double compareHistKernel( InputArray _H1, InputArray _H2, int method, int kernel );
+}
+
+#endif // COLORHISTOGRAM_H
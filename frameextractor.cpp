@@ -0,0 +1,161 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#include "frameextractor.h"
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+FrameExtractor::Stats::Stats(): delivered(0), seeks(0), grabbed(0), seek_seconds(0), grab_seconds(0)
+{
+}
+
+/**
+ * @brief FrameExtractor::FrameExtractor: Opens the video, see isOpened.
+ */
+FrameExtractor::FrameExtractor(const std::string &videoPath): cap(videoPath), position(0), seekGap(0), seekIndex(0)
+{
+}
+
+bool FrameExtractor::isOpened() const{
+    return cap.isOpened();
+}
+
+/**
+ * @brief FrameExtractor::setSeekGap: Seeks to the requested frames which are more than gap frames after the
+ * current position and decodes forward to the others. 0 (the default) chooses from the measured times.
+ */
+void FrameExtractor::setSeekGap(int gap){
+    seekGap = gap;
+}
+
+/**
+ * @brief FrameExtractor::setSeekIndex: Seeks with the given index of the video, which must stay open while
+ * frames are extracted. Frames after the indexed ones are reached without it.
+ */
+void FrameExtractor::setSeekIndex(const SeekIndex *index){
+    seekIndex = index && index->frameCount() > 0 ? index : 0;
+}
+
+/**
+ * @brief FrameExtractor::extract: Reads the given frames and passes them to callback in increasing order,
+ * a frame requested twice is passed twice. Frames after the end of the video are not passed.
+ * Every frame is retrieved into a new buffer, so the callback may keep it (e.g. queue it to a KeyframeWriter).
+ * @param frame_numbers: frame numbers of the result file (1 is the first frame), in any order
+ * @return: number of frames passed to callback
+ */
+int FrameExtractor::extract(std::vector<int> frame_numbers, FrameCallback callback){
+    if(!cap.isOpened())
+        return 0;
+    std::sort(frame_numbers.begin(), frame_numbers.end());
+    Mat frame;
+    int frameIndex = -1;
+    int delivered = 0;
+    for(size_t i = 0; i < frame_numbers.size(); i++){
+        int index = frame_numbers[i] - 1;
+        if(index < 0)
+            continue;
+        if(index != frameIndex){
+            bool reached = (index < position || shouldSeek(index)) ? seek(index) : skip(index);
+            //an indexed seek grabs the frame itself
+            if(!reached || (position == index && !cap.grab()))
+                break;
+            position = index + 1;
+            frame = Mat();
+            cap.retrieve(frame);
+            if(frame.empty())
+                break;
+            frameIndex = index;
+        }
+        callback(frame_numbers[i], frame);
+        delivered++;
+    }
+    counters.delivered += delivered;
+    return delivered;
+}
+
+/**
+ * @brief FrameExtractor::stats: Seeks and grabs of the frames extracted so far and their times.
+ */
+const FrameExtractor::Stats& FrameExtractor::stats() const{
+    return counters;
+}
+
+/**
+ * @brief FrameExtractor::shouldSeek: Decides if seeking to the frame with the given index, which is not before
+ * the current position, is faster than grabbing the frames in between. With an index which knows the keyframes
+ * a seek decodes from the keyframe of the frame, so it is faster exactly when the position is before it.
+ */
+bool FrameExtractor::shouldSeek(int index) const{
+    int gap = index - position;
+    if(gap == 0)
+        return false;
+    if(seekIndex && seekIndex->header().keyframe_interval > 0 && index < seekIndex->frameCount())
+        return position < seekIndex->keyframeIndex(index);
+    if(seekGap > 0)
+        return gap > seekGap;
+    if(counters.seeks == 0 || counters.grabbed == 0)
+        return gap > EXTRACT_INITIAL_SEEK_GAP;
+    return gap * counters.grab_seconds / counters.grabbed > counters.seek_seconds / counters.seeks;
+}
+
+/**
+ * @brief FrameExtractor::seek: Seeks the capture to the frame with the given index. Backends which
+ * land on an earlier frame (e.g. a keyframe) are decoded forward to it, the time of these grabs is
+ * part of the seek time. A backend which lands after the frame is rewound to the beginning.
+ * Indexed frames are sought with the seek index, which grabs the frame too.
+ * @return: false if the end of the video is reached before the frame
+ */
+bool FrameExtractor::seek(int index){
+    int64 start_t = getTickCount();
+    if(seekIndex && index < seekIndex->frameCount()){
+        int decoded;
+        bool reached = seekIndex->seek(cap, index, position, decoded);
+        counters.seeks++;
+        counters.seek_seconds += (getTickCount() - start_t) / getTickFrequency();
+        return reached;
+    }
+    cap.set(CV_CAP_PROP_POS_FRAMES, index);
+    position = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
+    if(position > index){
+        cap.set(CV_CAP_PROP_POS_FRAMES, 0);
+        position = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
+    }
+    bool reached = true;
+    while(position < index && (reached = cap.grab()))
+        position++;
+    counters.seeks++;
+    counters.seek_seconds += (getTickCount() - start_t) / getTickFrequency();
+    return reached;
+}
+
+/**
+ * @brief FrameExtractor::skip: Decodes forward to the frame with the given index without retrieving the frames.
+ * @return: false if the end of the video is reached before the frame
+ */
+bool FrameExtractor::skip(int index){
+    if(position >= index)
+        return true;
+    int64 start_t = getTickCount();
+    bool reached = true;
+    int grabbed = 0;
+    while(position < index && (reached = cap.grab())){
+        position++;
+        grabbed++;
+    }
+    counters.grabbed += grabbed;
+    counters.grab_seconds += (getTickCount() - start_t) / getTickFrequency();
+    return reached;
+}
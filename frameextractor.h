@@ -0,0 +1,73 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#ifndef FRAMEEXTRACTOR_H
+#define FRAMEEXTRACTOR_H
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+#include "seekindex.h"
+
+//frames to the next requested one above which a seek is tried before seek and grab times are measured
+#define EXTRACT_INITIAL_SEEK_GAP 32
+
+/**
+ * @brief The FrameExtractor class reads many frames of a video with a single capture, e.g. the keyframes
+ * of the shots of a result file. Requested frames are served in increasing order: the capture decodes
+ * forward (grab without retrieve) to a frame which is near and seeks to a frame which is far.
+ * A frame is far when grabbing the frames before it is expected to take longer than a seek, both times
+ * are measured on the video while frames are extracted (until then a frame is far when it is more than
+ * EXTRACT_INITIAL_SEEK_GAP frames away). setSeekGap fixes the distance instead. With a seek index of the
+ * video (see SeekIndex) seeks are frame accurate and a frame is far when the capture is before its keyframe.
+ *
+ * Frame numbers are the ones of the result file: frame n is the n'th frame of the video, the frame
+ * getShotFromVideo(n - 1) returns.
+ */
+class FrameExtractor
+{
+public:
+    /** a requested frame, valid until the callback returns unless its header is copied **/
+    typedef std::function<void(int frame_number, const cv::Mat &frame)> FrameCallback;
+    struct Stats
+    {
+        Stats();
+        int delivered;              // frames passed to the callback
+        int seeks;
+        int grabbed;                // frames decoded to reach a requested frame, requested ones excluded
+        double seek_seconds;
+        double grab_seconds;
+    };
+
+    explicit FrameExtractor(const std::string &videoPath);
+    bool isOpened() const;
+    void setSeekGap(int gap);
+    void setSeekIndex(const SeekIndex *index);
+    int extract(std::vector<int> frame_numbers, FrameCallback callback);
+    const Stats& stats() const;
+
+private:
+    bool shouldSeek(int index) const;
+    bool seek(int index);
+    bool skip(int index);
+
+    cv::VideoCapture cap;
+    int position;                   // index of the frame the capture decodes next
+    int seekGap;                    // 0 if the gap is chosen from the measured times
+    const SeekIndex *seekIndex;     // 0 if seeks are not indexed
+    Stats counters;
+};
+
+#endif // FRAMEEXTRACTOR_H
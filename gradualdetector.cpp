@@ -0,0 +1,213 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#include "gradualdetector.h"
+#include "checkpoint.h"
+#include "shotdetector.h"
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+/**
+ * @brief GradualDetector::GradualDetector
+ * @param detector: detector whose distance (tiles) confirms a transition
+ * @param window: number of frame distances summed, the longest transition which is found
+ * @param low_ratio: fraction of the threshold above which a distance is part of a transition
+ */
+GradualDetector::GradualDetector(const ShotDetector &detector, int window, double low_ratio): detector(detector),
+    windowSize(std::max(window, GRADUAL_MIN_FRAMES)), lowRatio(low_ratio), frames(0), windowSum(0), runStart(-1), inTransition(false), gap(0)
+{
+    ring.resize(windowSize + 1);
+    for(size_t i = 0; i < ring.size(); i++)
+        ring[i].ratio = 0;
+}
+
+GradualDetector::Entry& GradualDetector::entry(int64 index){
+    return ring[(size_t) (index % (int64) ring.size())];
+}
+
+/**
+ * @brief GradualDetector::update: Adds the next frame of the video.
+ * @param hist: histogram of the frame, copied into the ring buffer
+ * @param distance: distance of hist to the histogram of the previous frame (0 for the first frame)
+ * @param limit: distance of a boundary between adjacent frames (threshold scaled by the pixel count)
+ * @param boundary: the frame is a shot boundary (a cut), it ends the transition in progress and starts none
+ * @param frame_number: frame number of the frame
+ * @param time: position of the frame in miliseconds
+ * @param transition: the transition which ended before this frame, if true is returned
+ * @return: true if a gradual transition ended
+ */
+bool GradualDetector::update(const cv::MatND &hist, double distance, double limit, bool boundary, int frame_number,
+                             double time, Transition &transition){
+    int64 k = frames++;
+    double ratio = limit > 0 ? distance / limit : 0;
+    //the oldest distance leaves the window when frame k takes its slot
+    if(k >= windowSize)
+        windowSum = std::max(windowSum - entry(k - windowSize).ratio, 0.);
+    Entry &e = entry(k);
+    hist.copyTo(e.hist);
+    e.ratio = ratio > lowRatio && k > 0 ? std::min(ratio, 1.) : 0;
+    e.frame_number = frame_number;
+    e.time = time;
+    windowSum += e.ratio;
+    if(e.ratio == 0)
+        runStart = -1;
+    else if(runStart < 0)
+        runStart = k;
+
+    if(boundary && k > 0){
+        //the transition in progress ends before the cut, a run starting after it is compared with the cut frame
+        bool ended = inTransition;
+        if(ended)
+            transition = current;
+        inTransition = false;
+        clearWindow();
+        return ended;
+    }
+    if(inTransition){
+        if(e.ratio > 0){
+            current.end_frame_number = frame_number;
+            current.end_time = time;
+            gap = 0;
+            //changes which last longer than the window are motion, not a transition
+            if(current.end_frame_number - current.begin_frame_number + 1 > windowSize)
+                inTransition = false;
+            return false;
+        }
+        if(++gap <= GRADUAL_GAP_FRAMES)
+            return false;
+        inTransition = false;
+        transition = current;
+        //distances of the transition must not start another one
+        clearWindow();
+        return true;
+    }
+    if(windowSum <= 1. || e.ratio == 0)
+        return false;
+
+    //the run of changing frames ending with frame k, a run longer than the window is motion
+    int64 begin = runStart;
+    if(k - begin + 1 < GRADUAL_MIN_FRAMES || k - begin + 1 > windowSize)
+        return false;
+    //the frame before the run and the current one must belong to different shots
+    if(detector.histDistance(entry(begin - 1).hist, e.hist) <= limit)
+        return false;
+    inTransition = true;
+    current.begin_frame_number = entry(begin).frame_number;
+    current.begin_time = entry(begin).time;
+    current.end_frame_number = frame_number;
+    current.end_time = time;
+    gap = 0;
+    return false;
+}
+
+/**
+ * @brief GradualDetector::finish: Ends the transition in progress at the end of video.
+ * @return: true if a transition was in progress
+ */
+bool GradualDetector::finish(Transition &transition){
+    if(!inTransition)
+        return false;
+    inTransition = false;
+    transition = current;
+    clearWindow();
+    return true;
+}
+
+int GradualDetector::window() const{
+    return windowSize;
+}
+
+/**
+ * @brief GradualDetector::saveState: Stores the window in a checkpoint. Only the histograms update() can still
+ * compare are stored: the ones of the run of changing frames at the end of the window, the frame before it
+ * and the last frame.
+ */
+void GradualDetector::saveState(Checkpoint &checkpoint) const{
+    checkpoint.putInt(windowSize);
+    checkpoint.putDouble(lowRatio);
+    checkpoint.putInt(frames);
+    checkpoint.putDouble(windowSum);
+    checkpoint.putInt(inTransition);
+    saveTransition(checkpoint, current);
+    checkpoint.putInt(gap);
+    int64 last = frames - 1;
+    //the run and the frame before it, within the window
+    int64 first = runStart >= 0 ? std::max(runStart - 1, last - windowSize + 1) : last;
+    int64 size = (int64) ring.size();
+    for(int64 i = 0; i < size; i++){
+        const Entry &e = ring[(size_t) i];
+        //frame of the video this slot holds
+        int64 k = last - ((last - i) % size + size) % size;
+        checkpoint.putDouble(e.ratio);
+        checkpoint.putInt(e.frame_number);
+        checkpoint.putDouble(e.time);
+        checkpoint.putHist(k >= first && k >= 0 ? e.hist : cv::MatND());
+    }
+}
+
+/**
+ * @brief GradualDetector::loadState: Restores the state stored by saveState.
+ * @return: false if the state was saved with another window or low ratio, or the checkpoint is corrupt
+ */
+bool GradualDetector::loadState(Checkpoint &checkpoint){
+    if(checkpoint.getInt() != windowSize || checkpoint.getDouble() != lowRatio)
+        return false;
+    frames = checkpoint.getInt();
+    windowSum = checkpoint.getDouble();
+    inTransition = checkpoint.getInt() != 0;
+    loadTransition(checkpoint, current);
+    gap = (int) checkpoint.getInt();
+    for(size_t i = 0; i < ring.size(); i++){
+        Entry &e = ring[i];
+        e.ratio = checkpoint.getDouble();
+        e.frame_number = (int) checkpoint.getInt();
+        e.time = checkpoint.getDouble();
+        if(!checkpoint.getHist(e.hist))
+            return false;
+    }
+    //the run of changing frames ending with the last frame
+    runStart = -1;
+    for(int64 k = frames - 1; k > 0 && k > frames - 1 - (int64) ring.size() && entry(k).ratio > 0; k--)
+        runStart = k;
+    return !checkpoint.failed();
+}
+
+/**
+ * @brief GradualDetector::saveTransition: Stores a transition in a checkpoint field by field.
+ */
+void GradualDetector::saveTransition(Checkpoint &checkpoint, const Transition &transition){
+    checkpoint.putInt(transition.begin_frame_number);
+    checkpoint.putDouble(transition.begin_time);
+    checkpoint.putInt(transition.end_frame_number);
+    checkpoint.putDouble(transition.end_time);
+}
+
+/**
+ * @brief GradualDetector::loadTransition: Reads a transition stored by saveTransition.
+ */
+void GradualDetector::loadTransition(Checkpoint &checkpoint, Transition &transition){
+    transition.begin_frame_number = (int) checkpoint.getInt();
+    transition.begin_time = checkpoint.getDouble();
+    transition.end_frame_number = (int) checkpoint.getInt();
+    transition.end_time = checkpoint.getDouble();
+}
+
+void GradualDetector::clearWindow(){
+    for(size_t i = 0; i < ring.size(); i++)
+        ring[i].ratio = 0;
+    windowSum = 0;
+    runStart = -1;
+}
@@ -0,0 +1,90 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#ifndef GRADUALDETECTOR_H
+#define GRADUALDETECTOR_H
+#include <opencv2/core/core.hpp>
+#include <vector>
+
+class Checkpoint;
+class ShotDetector;
+
+//fraction of the boundary threshold above which a frame distance belongs to a gradual transition
+#define GRADUAL_LOW_RATIO 0.2
+//frames of a transition below the low ratio which do not end it
+#define GRADUAL_GAP_FRAMES 2
+//minimum number of frames above the low ratio, shorter changes are cuts
+#define GRADUAL_MIN_FRAMES 3
+
+/**
+ * @brief The GradualDetector class finds gradual transitions (fades, dissolves) which change the frame
+ * little by little, so no single distance between adjacent frames exceeds the boundary threshold.
+ * It keeps the histograms and distances of the last window frames in a ring buffer and maintains the
+ * sum of the distances over the window incrementally (distances below GRADUAL_LOW_RATIO of the threshold
+ * count as 0, each one counts at most the threshold). When the sum exceeds the threshold, the transition
+ * begins at the first frame of the run of distances above the low ratio; it is confirmed by comparing the
+ * histogram of the frame before the run, still in the ring buffer, with the current one (with the distance of
+ * the detector, see ShotDetector::histDistance). The transition ends
+ * when the distances stay below the low ratio for more than GRADUAL_GAP_FRAMES frames, or at a cut. A run of
+ * changing frames longer than the window (camera or object motion) is no transition, one which grows longer
+ * than the window is dropped.
+ *
+ * The start of the run of changing frames is tracked as frames arrive, so every frame costs one histogram copy
+ * into the ring and at most one comparison, memory is window + 2 histograms.
+ */
+class GradualDetector
+{
+public:
+    struct Transition
+    {
+        int begin_frame_number;     // first frame which differs from the previous shot
+        double begin_time;
+        int end_frame_number;       // last frame which differs from the frame before it
+        double end_time;
+    };
+
+    GradualDetector(const ShotDetector &detector, int window, double low_ratio = GRADUAL_LOW_RATIO);
+    bool update(const cv::MatND &hist, double distance, double limit, bool boundary, int frame_number, double time,
+                Transition &transition);
+    bool finish(Transition &transition);
+    int window() const;
+    void saveState(Checkpoint &checkpoint) const;
+    bool loadState(Checkpoint &checkpoint);
+    static void saveTransition(Checkpoint &checkpoint, const Transition &transition);
+    static void loadTransition(Checkpoint &checkpoint, Transition &transition);
+
+private:
+    struct Entry
+    {
+        cv::MatND hist;
+        double ratio;               // distance to the previous frame divided by the threshold
+        int frame_number;
+        double time;
+    };
+    Entry& entry(int64 index);
+    void clearWindow();
+
+    const ShotDetector &detector;
+    std::vector<Entry> ring;        // last windowSize + 1 frames, frame k at k % ring.size()
+    int windowSize;
+    double lowRatio;
+    int64 frames;                   // frames seen
+    double windowSum;               // clamped ratios of the last windowSize frames
+    int64 runStart;                 // first frame of the run of changing frames ending with the last one, -1 if none
+    bool inTransition;
+    Transition current;
+    int gap;                        // frames below the low ratio since the last one above it
+};
+
+#endif // GRADUALDETECTOR_H
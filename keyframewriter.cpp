@@ -0,0 +1,175 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#include "keyframewriter.h"
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <algorithm>
+#include <iostream>
+
+using namespace cv;
+using namespace std;
+
+KeyframeWriter::Options::Options(): format(JPEG), quality(95), thumbnail_width(0), workers(2), capacity(16)
+{
+}
+
+KeyframeWriter::Stats::Stats(): written(0), failed(0), blocked(0), blocked_seconds(0), max_backlog(0)
+{
+}
+
+/**
+ * @brief KeyframeWriter::KeyframeWriter: Starts the worker threads.
+ * @param options: format, quality, thumbnail size, number of workers and queue capacity
+ * @param metrics: counts encoding time, keyframes and bytes written, if not null
+ */
+KeyframeWriter::KeyframeWriter(const Options &options, RunMetrics *metrics): options(options), metrics(metrics), active(0), closing(false)
+{
+    if(this->options.workers < 1)
+        this->options.workers = 1;
+    if(this->options.capacity < 1)
+        this->options.capacity = 1;
+    if(options.format == JPEG){
+        params.push_back(CV_IMWRITE_JPEG_QUALITY);
+        params.push_back(options.quality);
+    }else if(options.format == PNG){
+        params.push_back(CV_IMWRITE_PNG_COMPRESSION);
+        params.push_back(options.quality);
+    }else if(options.format == PPM){
+        params.push_back(CV_IMWRITE_PXM_BINARY);
+        params.push_back(1);
+    }
+    for(int i = 0; i < this->options.workers; i++)
+        workers.push_back(std::thread(&KeyframeWriter::workerLoop, this));
+}
+
+KeyframeWriter::~KeyframeWriter()
+{
+    close();
+}
+
+/**
+ * @brief KeyframeWriter::write: Queues the frame to be stored as fileName with the extension of the format.
+ * The writer keeps a reference to the pixels of frame instead of copying them, so the caller must not
+ * write into the frame afterwards (decoding the next frame into a new cv::Mat is fine).
+ * Blocks while capacity frames are already waiting. Can be called from several threads.
+ * @param fileName: path of the stored frame without extension
+ * @param frame: frame to be stored
+ */
+void KeyframeWriter::write(const std::string &fileName, cv::Mat &frame){
+    Job job;
+    job.fileName = fileName + extension(options.format);
+    job.frame = frame;
+
+    unique_lock<mutex> lock(jobsMutex);
+    if(jobs.size() >= options.capacity){
+        int64 start_t = getTickCount();
+        notFull.wait(lock, [this]{ return jobs.size() < options.capacity; });
+        counters.blocked++;
+        counters.blocked_seconds += (getTickCount() - start_t) / getTickFrequency();
+    }
+    jobs.push_back(job);
+    counters.max_backlog = std::max(counters.max_backlog, jobs.size());
+    lock.unlock();
+    notEmpty.notify_one();
+}
+
+/**
+ * @brief KeyframeWriter::wait: Waits until every frame queued so far is written, the writer stays open.
+ */
+void KeyframeWriter::wait(){
+    unique_lock<mutex> lock(jobsMutex);
+    idle.wait(lock, [this]{ return jobs.empty() && active == 0; });
+}
+
+/**
+ * @brief KeyframeWriter::close: Waits until every queued frame is written and stops the workers.
+ * Frames must not be written after close.
+ */
+void KeyframeWriter::close(){
+    {
+        lock_guard<mutex> lock(jobsMutex);
+        if(closing)
+            return;
+        closing = true;
+    }
+    notEmpty.notify_all();
+    for(size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    workers.clear();
+}
+
+KeyframeWriter::Stats KeyframeWriter::stats() const{
+    lock_guard<mutex> lock(jobsMutex);
+    return counters;
+}
+
+const char* KeyframeWriter::extension(Format format){
+    switch(format){
+    case PNG:
+        return ".png";
+    case PPM:
+        return ".ppm";
+    default:
+        return ".jpg";
+    }
+}
+
+/**
+ * @brief KeyframeWriter::workerLoop: Encodes queued frames until the writer is closed and the queue is empty.
+ */
+void KeyframeWriter::workerLoop(){
+    while(1){
+        Job job;
+        {
+            unique_lock<mutex> lock(jobsMutex);
+            notEmpty.wait(lock, [this]{ return closing || !jobs.empty(); });
+            if(jobs.empty())
+                return;
+            job = jobs.front();
+            jobs.pop_front();
+            active++;
+        }
+        notFull.notify_one();
+
+        bool stored = false;
+        int64 start_t = RunMetrics::start(metrics);
+        try{
+            if(options.thumbnail_width > 0 && options.thumbnail_width < job.frame.cols){
+                int height = std::max(1, job.frame.rows * options.thumbnail_width / job.frame.cols);
+                Mat thumbnail;
+                resize(job.frame, thumbnail, Size(options.thumbnail_width, height), 0, 0, INTER_AREA);
+                job.frame = thumbnail;
+            }
+            stored = imwrite(job.fileName, job.frame, params);
+        }catch(const cv::Exception &e){
+            cout << "error writing " << job.fileName << ": " << e.what() << endl;
+        }
+        if(metrics){
+            RunMetrics::stop(metrics, RunMetrics::ENCODE, start_t);
+            if(stored){
+                metrics->add(RunMetrics::KEYFRAMES_WRITTEN, 1);
+                metrics->add(RunMetrics::BYTES_WRITTEN, RunMetrics::fileSize(job.fileName));
+            }
+        }
+
+        lock_guard<mutex> lock(jobsMutex);
+        if(stored)
+            counters.written++;
+        else
+            counters.failed++;
+        if(--active == 0 && jobs.empty())
+            idle.notify_all();
+    }
+}
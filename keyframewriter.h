@@ -0,0 +1,87 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#ifndef KEYFRAMEWRITER_H
+#define KEYFRAMEWRITER_H
+#include <opencv2/core/core.hpp>
+#include "runmetrics.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The KeyframeWriter class encodes and stores keyframes on a pool of worker threads,
+ * so the detection loop does not wait for the encoder or the disk. Frames are queued in a
+ * bounded queue; write() blocks while the queue is full (backpressure) and the time spent
+ * blocked is counted. close() (or the destructor) writes every queued frame before returning.
+ */
+class KeyframeWriter
+{
+public:
+    enum Format {JPEG, PNG, PPM};
+    struct Options
+    {
+        Options();
+        Format format;
+        int quality;                // JPEG quality (0-100) or PNG compression level (0-9), ignored for PPM
+        int thumbnail_width;        // frames are resized to this width keeping aspect ratio, 0 keeps the size
+        int workers;                // number of encoding threads
+        size_t capacity;            // maximum number of frames waiting to be written
+    };
+    struct Stats
+    {
+        Stats();
+        size_t written;
+        size_t failed;
+        size_t blocked;             // number of write() calls which waited for a free slot
+        double blocked_seconds;     // total time write() calls waited for a free slot
+        size_t max_backlog;         // largest number of frames waiting to be written
+    };
+
+    explicit KeyframeWriter(const Options &options, RunMetrics *metrics = 0);
+    ~KeyframeWriter();
+    void write(const std::string &fileName, cv::Mat &frame);
+    void wait();
+    void close();
+    Stats stats() const;
+    static const char* extension(Format format);
+
+private:
+    KeyframeWriter(const KeyframeWriter&);
+    KeyframeWriter& operator=(const KeyframeWriter&);
+    void workerLoop();
+
+    struct Job
+    {
+        std::string fileName;
+        cv::Mat frame;
+    };
+    Options options;
+    RunMetrics *metrics;
+    std::vector<int> params;
+    std::deque<Job> jobs;
+    std::vector<std::thread> workers;
+    mutable std::mutex jobsMutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::condition_variable idle;
+    size_t active;                  // frames being encoded
+    bool closing;
+    Stats counters;
+};
+
+#endif // KEYFRAMEWRITER_H
@@ -0,0 +1,35 @@
+# sources of libshotdetect, shared by the library and the command line tool
+HEADERS += \
+    shotdetector.h \
+    shotstream.h \
+    spscqueue.h \
+    colorhistogram.h \
+    keyframewriter.h \
+    rawframesource.h \
+    signaturecache.h \
+    runmetrics.h \
+    gradualdetector.h \
+    adaptivethreshold.h \
+    resultwriter.h \
+    frameextractor.h \
+    seekindex.h \
+    checkpoint.h \
+    cascadedetector.h \
+    sidecarfile.h
+
+SOURCES += \
+    shotdetector.cpp \
+    shotstream.cpp \
+    colorhistogram.cpp \
+    keyframewriter.cpp \
+    rawframesource.cpp \
+    signaturecache.cpp \
+    runmetrics.cpp \
+    gradualdetector.cpp \
+    adaptivethreshold.cpp \
+    resultwriter.cpp \
+    frameextractor.cpp \
+    seekindex.cpp \
+    checkpoint.cpp \
+    cascadedetector.cpp \
+    sidecarfile.cpp
@@ -0,0 +1,10 @@
+# shared library by default, qmake "CONFIG+=staticlib" builds the static one
+TEMPLATE = lib
+TARGET = shotdetect
+CONFIG -= qt
+CONFIG += c++11
+
+INCLUDEPATH += /usr/include/opencv2 /usr/include
+LIBS        += -lopencv_core -lopencv_highgui -lopencv_video -lopencv_imgproc -lopencv_flann -lpthread
+
+include(libshotdetect.pri)
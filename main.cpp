@@ -13,23 +13,105 @@
 *******************************************************************************/
 
 #include "shotdetector.h"
+#include "colorhistogram.h"
+#include "rawframesource.h"
+#include "benchmark.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <thread>
 
 #define DEFAULT_THRESHOLD 0.49
 #define APP_VERSION "1.0.0"
 #define ENABLE_GUI false
 #define DEFAULT_SAMPLE_PERIOD 30
+#define DEFAULT_THREADS 1
+#define DEFAULT_INGEST_QUEUE 8
+#define SYNTHETIC_FRAMES 600
+#define SYNTHETIC_FPS 25
+#define OUTPUT_BENCHMARK_SHOTS 100000
 
 using namespace std;
 using namespace cv;
 
 void show_help(char** );
+void scaling_report(string videoFile, string outputPath, double threshold, int sample_period, int max_threads);
+void histogram_report(string videoFile);
+void compare_report(string videoFile);
+void sampling_report(string videoFile, double threshold);
+void tile_report(string videoFile, double threshold);
+void cascade_report(const CascadeDetector::Stats &stats, const vector<CascadeDetector::Stage> &stages);
+void yuv_report(string videoFile, double threshold);
+void extract_report(string videoFile, int count);
+void seek_report(string videoFile, string indexFile, int count);
+double calibrate_threshold(const vector<double> &distances, const vector<char> &reference, long &agreed);
+uint64 frame_checksum(const Mat &frame);
+vector<string> batch_videos(string manifest, bool isGlob);
+void batch_process(const vector<string>& videos, string outputPath, double threshold, int sample_period,
+                   ShotDetector::SamplingMode sampling, int sampling_factor,
+                   const KeyframeWriter::Options& keyframeOptions, std::ostream* eventStream, int num_threads,
+                   ShotDetector::OutputFormat resultFormat);
 
 int main(int argc, char** argv)
 {
     double threshold = DEFAULT_THRESHOLD;
     bool showGUI = ENABLE_GUI;
     int sample_period = DEFAULT_SAMPLE_PERIOD;
-    string videoFile, outputPath;
+    int num_threads = DEFAULT_THREADS;
+    bool showScaling = false;
+    bool pipelined = false;
+    int coarseStep = 0;
+    int gradualWindow = 0;
+    int adaptiveWindow = 0;
+    double adaptiveSigmas = ADAPTIVE_DEFAULT_SIGMAS;
+    string cacheFile;
+    string metricsFile;
+    double metricsPeriod = 0;
+    vector<double> thresholds;
+    vector<int> extractFrames;
+    int extractBenchmarkFrames = 0;
+    string seekIndexFile;
+    int keyframeInterval = 0;
+    int seekBenchmarkFrames = 0;
+    string checkpointFile;
+    double checkpointPeriod = DEFAULT_CHECKPOINT_PERIOD;
+    bool resume = false;
+    bool showHistogramReport = false;
+    bool showCompareReport = false;
+    bool showSamplingReport = false;
+    bool showTileReport = false;
+    int tileGrid = 0;
+    int tileIgnored = -1;
+    string cascadeSpec;
+    bool showYUVReport = false;
+    bool showBenchmarkSuite = false;
+    int outputBenchmarkShots = 0;
+    ShotDetector::OutputFormat resultFormat = ShotDetector::XML;
+    cv::Size syntheticSize;
+    bool yuvNative = false;
+    double yuvThreshold = -1;
+    ShotDetector::SamplingMode sampling = ShotDetector::SAMPLE_ALL;
+    int sampling_factor = 1;
+    KeyframeWriter::Options keyframeOptions;
+    bool qualitySet = false;
+    string videoFile, outputPath, batchManifest, eventTarget, ingestFormat;
+    cv::Size ingestSize;
+    double ingestFps = 0;
+    int ingestQueue = DEFAULT_INGEST_QUEUE;
+    RawFrameSource::DropPolicy dropPolicy = RawFrameSource::BLOCK;
+    bool realtime = false;
+    bool batchGlob = false;
     if (argc < 4) { // Check the value of argc. If not enough parameters have been passed, inform user and exit.
         show_help(argv);
         exit(0);
@@ -48,36 +130,372 @@ int main(int argc, char** argv)
                 outputPath = argv[i + 1];
             } else if (string(argv[i]) == "-s") {
                 sample_period = atoi( argv[i + 1] );
+            } else if (string(argv[i]) == "-j") {
+                num_threads = atoi( argv[i + 1] );
+                if(num_threads <= 0)
+                    num_threads = std::thread::hardware_concurrency();
+            } else if (string(argv[i]) == "-batch") {
+                batchManifest = argv[i + 1];
+                batchGlob = false;
+            } else if (string(argv[i]) == "-batchglob") {
+                batchManifest = argv[i + 1];
+                batchGlob = true;
+            } else if (string(argv[i]) == "-ingest") {
+                ingestFormat = argv[i + 1];
+            } else if (string(argv[i]) == "-size") {
+                sscanf(argv[i + 1], "%dx%d", &ingestSize.width, &ingestSize.height);
+            } else if (string(argv[i]) == "-fps") {
+                ingestFps = atof( argv[i + 1] );
+            } else if (string(argv[i]) == "-queue") {
+                ingestQueue = atoi( argv[i + 1] );
+            } else if (string(argv[i]) == "-drop") {
+                string policy(argv[i + 1]);
+                if(policy == "newest")
+                    dropPolicy = RawFrameSource::DROP_NEWEST;
+                else if(policy == "oldest")
+                    dropPolicy = RawFrameSource::DROP_OLDEST;
+                else
+                    dropPolicy = RawFrameSource::BLOCK;
+            } else if (string(argv[i]) == "-events") {
+                eventTarget = argv[i + 1];
+            } else if (string(argv[i]) == "-format") {
+                string keyframeFormat(argv[i + 1]);
+                if(keyframeFormat == "png")
+                    keyframeOptions.format = KeyframeWriter::PNG;
+                else if(keyframeFormat == "ppm")
+                    keyframeOptions.format = KeyframeWriter::PPM;
+                else
+                    keyframeOptions.format = KeyframeWriter::JPEG;
+            } else if (string(argv[i]) == "-resultformat") {
+                string format(argv[i + 1]);
+                if(format == "yaml")
+                    resultFormat = ShotDetector::YAML;
+                else if(format == "text")
+                    resultFormat = ShotDetector::TEXT;
+                else if(format == "json")
+                    resultFormat = ShotDetector::JSON;
+                else if(format == "binary")
+                    resultFormat = ShotDetector::BINARY;
+                else
+                    resultFormat = ShotDetector::XML;
+            } else if (string(argv[i]) == "-benchoutput") {
+                outputBenchmarkShots = atoi( argv[i + 1] );
+                if(outputBenchmarkShots <= 0)
+                    outputBenchmarkShots = OUTPUT_BENCHMARK_SHOTS;
+            } else if (string(argv[i]) == "-quality") {
+                keyframeOptions.quality = atoi( argv[i + 1] );
+                qualitySet = true;
+            } else if (string(argv[i]) == "-thumbnail") {
+                keyframeOptions.thumbnail_width = atoi( argv[i + 1] );
+            } else if (string(argv[i]) == "-writers") {
+                keyframeOptions.workers = atoi( argv[i + 1] );
+            } else if (string(argv[i]) == "-pixelstride") {
+                sampling = ShotDetector::SAMPLE_PIXEL_STRIDE;
+                sampling_factor = atoi( argv[i + 1] );
+            } else if (string(argv[i]) == "-rowstride") {
+                sampling = ShotDetector::SAMPLE_ROW_STRIDE;
+                sampling_factor = atoi( argv[i + 1] );
+            } else if (string(argv[i]) == "-downscale") {
+                sampling = ShotDetector::SAMPLE_DOWNSCALE;
+                sampling_factor = atoi( argv[i + 1] );
+            } else if (string(argv[i]) == "-tiles") {
+                tileGrid = atoi( argv[i + 1] );
+            } else if (string(argv[i]) == "-tileignore") {
+                tileIgnored = atoi( argv[i + 1] );
+            } else if (string(argv[i]) == "-cascade") {
+                cascadeSpec = argv[i + 1];
+            } else if (string(argv[i]) == "-tlist") {
+                stringstream list(argv[i + 1]);
+                string value;
+                while(getline(list, value, ','))
+                    if(!value.empty())
+                        thresholds.push_back(atof( value.c_str() ));
+            } else if (string(argv[i]) == "-extract") {
+                stringstream list(argv[i + 1]);
+                string value;
+                while(getline(list, value, ','))
+                    if(!value.empty())
+                        extractFrames.push_back(atoi( value.c_str() ));
+            } else if (string(argv[i]) == "-benchextract") {
+                extractBenchmarkFrames = atoi( argv[i + 1] );
+            } else if (string(argv[i]) == "-seekindex") {
+                seekIndexFile = argv[i + 1];
+            } else if (string(argv[i]) == "-keyint") {
+                keyframeInterval = atoi( argv[i + 1] );
+            } else if (string(argv[i]) == "-benchseek") {
+                seekBenchmarkFrames = atoi( argv[i + 1] );
+            } else if (string(argv[i]) == "-checkpoint") {
+                checkpointFile = argv[i + 1];
+            } else if (string(argv[i]) == "-checkpointperiod") {
+                checkpointPeriod = atof( argv[i + 1] );
+            } else if (string(argv[i]) == "-cache") {
+                cacheFile = argv[i + 1];
+            } else if (string(argv[i]) == "-adaptive") {
+                adaptiveWindow = atoi( argv[i + 1] );
+            } else if (string(argv[i]) == "-sigmas") {
+                adaptiveSigmas = atof( argv[i + 1] );
+            } else if (string(argv[i]) == "-gradual") {
+                gradualWindow = atoi( argv[i + 1] );
+            } else if (string(argv[i]) == "-coarse") {
+                coarseStep = atoi( argv[i + 1] );
+            } else if (string(argv[i]) == "-metrics") {
+                metricsFile = argv[i + 1];
+            } else if (string(argv[i]) == "-metricsperiod") {
+                metricsPeriod = atof( argv[i + 1] );
+            } else if (string(argv[i]) == "-synthetic") {
+                sscanf(argv[i + 1], "%dx%d", &syntheticSize.width, &syntheticSize.height);
+            } else if (string(argv[i]) == "-yuvt") {
+                yuvThreshold = atof( argv[i + 1] );
             } else if (string(argv[i]) == "-h") {
                 show_help(argv);
             }
         }
         if (string(argv[i]) == "-show") {
             showGUI = true;
+        } else if (string(argv[i]) == "-scaling") {
+            showScaling = true;
+        } else if (string(argv[i]) == "-pipeline") {
+            pipelined = true;
+        } else if (string(argv[i]) == "-realtime") {
+            realtime = true;
+        } else if (string(argv[i]) == "-benchhist") {
+            showHistogramReport = true;
+        } else if (string(argv[i]) == "-benchcompare") {
+            showCompareReport = true;
+        } else if (string(argv[i]) == "-benchsampling") {
+            showSamplingReport = true;
+        } else if (string(argv[i]) == "-benchtiles") {
+            showTileReport = true;
+        } else if (string(argv[i]) == "-benchyuv") {
+            showYUVReport = true;
+        } else if (string(argv[i]) == "-benchsuite") {
+            showBenchmarkSuite = true;
+        } else if (string(argv[i]) == "-resume") {
+            resume = true;
+        } else if (string(argv[i]) == "-yuv") {
+            yuvNative = true;
+        }
+    }
+    if(!qualitySet && keyframeOptions.format == KeyframeWriter::PNG){
+        //default PNG compression of imwrite
+        keyframeOptions.quality = 3;
+    }
+    if(tileIgnored < 0){
+        //a quarter of the tiles may hold local motion
+        tileIgnored = tileGrid * tileGrid / 4;
+    }
+    if(yuvThreshold < 0){
+        //uncalibrated, -benchyuv finds the YUV threshold matching the BGR one
+        yuvThreshold = threshold;
+    }
+    //-adaptive, -gradual, -seekindex and -checkpoint are options of the sequential detector, the stream of
+    //-ingest and the cache decide adaptively or detect gradual transitions too, the other modes would ignore them
+    string mode = !batchManifest.empty() ? "-batch" : showGUI ? "-show" : !ingestFormat.empty() ? "-ingest"
+                : !thresholds.empty() ? "-tlist" : !cascadeSpec.empty() ? "-cascade" : !cacheFile.empty() ? "-cache"
+                : pipelined ? "-pipeline" : coarseStep > 1 ? "-coarse" : "";
+    if(!mode.empty()){
+        bool streamMode = mode == "-ingest" || mode == "-cache";
+        string unsupported = !checkpointFile.empty() ? "-checkpoint" : !seekIndexFile.empty() ? "-seekindex"
+                           : streamMode ? "" : adaptiveWindow > 0 ? "-adaptive" : gradualWindow > 0 ? "-gradual" : "";
+        if(!unsupported.empty()){
+            cout << unsupported << " is not supported with " << mode << endl;
+            return 1;
         }
     }
     if(outputPath.compare("") == 0 || outputPath.compare(" ") == 0 ){
         //default output filename
         outputPath = "result";
     }
+    //shot events streamed as JSON lines, to stdout ("-"), a file or a named pipe
+    ostream stdoutEvents(0);
+    ofstream eventFile;
+    ostream* eventStream = 0;
+    if(eventTarget == "-"){
+        //stdout carries only the events, other messages are moved to stderr
+        stdoutEvents.rdbuf(cout.rdbuf());
+        cout.rdbuf(cerr.rdbuf());
+        eventStream = &stdoutEvents;
+    }else if(!eventTarget.empty()){
+        eventFile.open(eventTarget.c_str());
+        if(!eventFile.is_open()){
+            cout << "error openning event stream " << eventTarget << endl;
+            exit(1);
+        }
+        eventStream = &eventFile;
+    }
+    if(!batchManifest.empty()){
+        vector<string> videos = batch_videos(batchManifest, batchGlob);
+        batch_process(videos, outputPath, threshold, sample_period, sampling, sampling_factor, keyframeOptions,
+                      eventStream, num_threads, resultFormat);
+        return 0;
+    }
+    //stage times and counters of the run, exported at the end and every metricsPeriod seconds
+    RunMetrics metrics;
+    RunMetrics* runMetrics = metricsFile.empty() ? 0 : &metrics;
+    if(runMetrics && metricsPeriod > 0)
+        metrics.startExport(metricsFile, RunMetrics::formatOf(metricsFile), metricsPeriod);
     switch(showGUI){
     case true:
     {
-        ShotDetector sd(videoFile, threshold, sample_period);
-        sd.processVideo(outputPath, ShotDetector::XML);
+        ShotDetector sd(videoFile, threshold, sample_period, sampling, sampling_factor);
+        sd.setKeyframeOptions(keyframeOptions);
+        sd.setEventStream(eventStream);
+        sd.setMetrics(runMetrics);
+        sd.processVideo(outputPath, resultFormat);
         break;
     }
     case false:
     {
         cout <<"video file: " << videoFile <<endl;
-        ShotDetector sd(videoFile, threshold, sample_period);
+        if(showHistogramReport){
+            histogram_report(videoFile);
+            break;
+        }
+        if(showCompareReport){
+            compare_report(videoFile);
+            break;
+        }
+        if(showSamplingReport){
+            sampling_report(videoFile, threshold);
+            break;
+        }
+        if(showYUVReport){
+            yuv_report(videoFile, threshold);
+            break;
+        }
+        if(showTileReport){
+            tile_report(videoFile, threshold);
+            break;
+        }
+        if(extractBenchmarkFrames > 0){
+            extract_report(videoFile, extractBenchmarkFrames);
+            break;
+        }
+        if(showBenchmarkSuite){
+            benchmark_suite(videoFile, outputPath, threshold);
+            break;
+        }
+        if(outputBenchmarkShots > 0){
+            output_benchmark(outputPath, outputBenchmarkShots);
+            break;
+        }
+        if(syntheticSize.width > 0 && syntheticSize.height > 0){
+            vector<SyntheticTransition> truth;
+            if(generate_synthetic_video(videoFile, syntheticSize, SYNTHETIC_FRAMES, SYNTHETIC_FPS, 0, truth)
+                    && write_ground_truth(videoFile + ".truth", truth))
+                cout << SYNTHETIC_FRAMES << " frames with " << truth.size() << " transitions written, ground truth: "
+                     << videoFile << ".truth" <<endl;
+            break;
+        }
+        if(showScaling){
+            scaling_report(videoFile, outputPath, threshold, sample_period, num_threads);
+            break;
+        }
+        ShotDetector sd(videoFile, threshold, sample_period, sampling, sampling_factor);
+        sd.setKeyframeOptions(keyframeOptions);
+        sd.setEventStream(eventStream);
+        sd.setYUVNative(yuvNative, yuvThreshold);
+        sd.setMetrics(runMetrics);
+        sd.setGradualWindow(gradualWindow);
+        sd.setAdaptiveThreshold(adaptiveWindow, adaptiveSigmas);
+        sd.setSeekIndex(seekIndexFile, keyframeInterval);
+        sd.setCheckpoint(checkpointFile, checkpointPeriod, resume);
+        sd.setTileGrid(tileGrid, tileIgnored);
+        if(!ingestFormat.empty()){
+            RawFrameSource source(videoFile, ingestFormat == "y4m" ? RawFrameSource::YUV4MPEG : RawFrameSource::RAWVIDEO_BGR24,
+                                  ingestSize, ingestFps, ingestQueue, dropPolicy, realtime);
+            int64 start_t =  cv::getTickCount();
+            sd.processStream(source, outputPath, resultFormat);
+            double time_elapsed = (cv::getTickCount() - start_t) / cv::getTickFrequency();
+            cout << "time elapsed: "<< time_elapsed <<" seconds" <<endl;
+            cout << "frames: " << source.receivedFrames() << " received, " << sd.processedFrameCount() << " processed, "
+                 << source.droppedFrames() << " dropped" <<endl;
+            cout << "decision latency (ms): p50 " << sd.decisionLatency(50) << ", p99 " << sd.decisionLatency(99)
+                 << ", max " << sd.decisionLatency(100) <<endl;
+            break;
+        }
+        if(seekBenchmarkFrames > 0){
+            if(seekIndexFile.empty()){
+                cout << "-benchseek needs the seek index file of -seekindex" << endl;
+                break;
+            }
+            SeekIndex index;
+            if(!index.open(seekIndexFile) || !index.matches(videoFile)){
+                cout << "writing seek index " << seekIndexFile << endl;
+                sd.processVideo_NoGUI(outputPath, resultFormat);
+            }
+            index.close();
+            seek_report(videoFile, seekIndexFile, seekBenchmarkFrames);
+            break;
+        }
         int64 start_t =  cv::getTickCount();
-        sd.processVideo_NoGUI(outputPath, ShotDetector::XML);
+        if(!extractFrames.empty()){
+            int stored = sd.extractKeyframes(extractFrames, outputPath);
+            double time_elapsed = (cv::getTickCount() - start_t) / cv::getTickFrequency();
+            FrameExtractor::Stats extractStats = sd.extractionStats();
+            cout << "time elapsed: "<< time_elapsed <<" seconds" <<endl;
+            cout << "keyframes: " << stored << " of " << extractFrames.size() << " stored, " << extractStats.seeks
+                 << " seeks, " << extractStats.grabbed << " frames skipped" <<endl;
+            break;
+        }
+        if(!thresholds.empty()){
+            sd.processVideo_Sweep(outputPath, resultFormat, thresholds);
+            double time_elapsed = (cv::getTickCount() - start_t) / cv::getTickFrequency();
+            cout << "time elapsed: "<< time_elapsed <<" seconds" <<endl;
+            cout << "frames/sec: "<< sd.processedFrameCount() / time_elapsed <<endl;
+            KeyframeWriter::Stats keyframeStats = sd.keyframeWriterStats();
+            cout << "keyframes: " << keyframeStats.written << " written for " << thresholds.size() << " thresholds" <<endl;
+            break;
+        }
+        if(!cascadeSpec.empty()){
+            vector<CascadeDetector::Stage> stages;
+            if(!CascadeDetector::parse(cascadeSpec, threshold, stages)){
+                cout << "-cascade needs a list of stages: mad, coarse, chisqr, bhattacharyya, ecr" << endl;
+                break;
+            }
+            sd.processVideo_Cascade(outputPath, resultFormat, stages);
+            double time_elapsed = (cv::getTickCount() - start_t) / cv::getTickFrequency();
+            cout << "time elapsed: "<< time_elapsed <<" seconds" <<endl;
+            cout << "frames/sec: "<< sd.processedFrameCount() / time_elapsed <<endl;
+            cascade_report(sd.cascadeStats(), stages);
+            break;
+        }
+        if(!cacheFile.empty()){
+            bool replayed = sd.processVideo_Cached(outputPath, resultFormat, cacheFile);
+            double time_elapsed = (cv::getTickCount() - start_t) / cv::getTickFrequency();
+            cout << "time elapsed: "<< time_elapsed <<" seconds" <<endl;
+            cout << "signature cache: " << (replayed ? "results replayed from " : "written to ") << cacheFile <<endl;
+            break;
+        }
+        if(pipelined)
+            sd.processVideo_Pipelined(outputPath, resultFormat);
+        else if(coarseStep > 1)
+            sd.processVideo_Coarse(outputPath, resultFormat, coarseStep);
+        else if(gradualWindow > 0 || adaptiveWindow > 0 || !checkpointFile.empty() || !seekIndexFile.empty())
+            sd.processVideo_NoGUI(outputPath, resultFormat);
+        else
+            sd.processVideo_Parallel(outputPath, resultFormat, num_threads);
 
         int64 stop_t =  cv::getTickCount();
         int64 elapsed_t = stop_t - start_t;
         double time_elapsed = elapsed_t / cv::getTickFrequency();
         cout << "time elapsed: "<< time_elapsed <<" seconds" <<endl;
+        cout << "frames/sec: "<< sd.processedFrameCount() / time_elapsed <<endl;
+        if(coarseStep > 1)
+            cout << "frames retrieved: " << sd.retrievedFrameCount() << " of " << sd.processedFrameCount() << ", "
+                 << sd.bisectedIntervalCount() << " intervals bisected" <<endl;
+        else if(!pipelined)
+            cout << "frame/histogram buffer reallocations: " << sd.bufferReallocationCount() <<endl;
+        if(!checkpointFile.empty()){
+            ShotDetector::CheckpointStats checkpointStats = sd.checkpointStats();
+            cout << "checkpoints: " << checkpointStats.written << " written (" << checkpointStats.bytes << " bytes, "
+                 << (checkpointStats.written ? 1000. * checkpointStats.seconds / checkpointStats.written : 0)
+                 << " ms each), resumed after frame " << checkpointStats.resumed_frames <<endl;
+        }
+        KeyframeWriter::Stats keyframeStats = sd.keyframeWriterStats();
+        cout << "keyframes: " << keyframeStats.written << " written, " << keyframeStats.failed << " failed, largest backlog "
+             << keyframeStats.max_backlog << ", detection blocked " << keyframeStats.blocked << " times ("
+             << keyframeStats.blocked_seconds << " seconds)" <<endl;
         break;
     }
     default:
@@ -87,6 +505,10 @@ int main(int argc, char** argv)
         break;
     }
     }
+    if(runMetrics){
+        metrics.stopExport();
+        metrics.exportFile(metricsFile, RunMetrics::formatOf(metricsFile));
+    }
 
     return 0;
 }
@@ -96,8 +518,800 @@ void show_help(char **argv) {
           "Usage: " <<  argv[0] << endl <<
           "-h               : show this help\n"
           "-t threshold     : threshold (Default = "<< DEFAULT_THRESHOLD << ")\n"
+          "-extract n1,n2,. : store the frames with the given frame numbers of the result file under output_path\n"
+          "                   with a single decoder, without detecting shots\n"
+          "-benchextract n  : extract n frames spread over the video with getShotFromVideo and with one decoder\n"
+          "                   (forward decoding, seeking and the automatic choice) and compare frames/sec\n"
+          "-seekindex file  : write the frame numbers, times and keyframes of the video to file while detecting\n"
+          "                   (sequential detection), -extract and getShotFromVideo seek with it once it belongs\n"
+          "                   to the video\n"
+          "-keyint n        : keyframe interval the video was encoded with, recorded in the seek index (Default = 0,\n"
+          "                   unknown: the backend seeks from its own keyframe)\n"
+          "-benchseek n     : look up n random frames with plain seeks and with the seek index (written first if\n"
+          "                   needed) and compare the latency per lookup\n"
+          "-tlist t1,t2,... : detect at every threshold of the list in one pass, results of each one are stored\n"
+          "                   in output_path_t<threshold>, keyframes are shared under output_path\n"
           "-i file          : input file path\n"
           "-o output_path   : save detected shots to output path "<<endl<<
           "-s sample_period : set the sample period of stored frames. (Default = "<< DEFAULT_SAMPLE_PERIOD <<")\n"<<
+          "-j threads       : process segments of the video in parallel, 0 uses all cores (Default = "<< DEFAULT_THREADS <<")\n"
+          "-pipeline        : run decoding, histograms, detection and writing on separate threads\n"
+          "-cache file      : keep the frame distances of the video in file, later runs with the same sampling\n"
+          "                   compute the results for a new -t or -s from it without decoding (no keyframes stored)\n"
+          "-checkpoint file : save the detection state to file every -checkpointperiod seconds (sequential detection),\n"
+          "                   the file is removed when the run completes\n"
+          "-checkpointperiod s : seconds between checkpoints (Default = "<< DEFAULT_CHECKPOINT_PERIOD <<")\n"
+          "-resume          : continue from the -checkpoint file of the video, with the results of an uninterrupted run\n"
+          "-adaptive n      : decide boundaries against the rolling mean and deviation of the last n frame distances\n"
+          "                   instead of the fixed threshold (sequential detection)\n"
+          "-sigmas k        : deviations above the rolling mean of an adaptive boundary (Default = "<< ADAPTIVE_DEFAULT_SIGMAS <<")\n"
+          "-gradual w       : also detect fades and dissolves of up to w frames and write them as begin/end\n"
+          "                   ranges to GradualTransitions of the result file (sequential detection)\n"
+          "                   -adaptive, -gradual, -seekindex and -checkpoint are rejected with -pipeline, -coarse,\n"
+          "                   -tlist, -cascade, -batch and -show, -seekindex and -checkpoint also with -ingest, -cache\n"
+          "-coarse k        : compare every k'th frame, grab the others without decoding them to images\n"
+          "                   and bisect the intervals which contain a boundary\n"
+          "-benchhist       : compare color histogram kernels with calcHist at several resolutions\n"
+          "-batch list      : process the videos listed in file list (one path per line) instead of -i,\n"
+          "                   -j videos at a time, each one is stored under output_path/<video name>\n"
+          "-batchglob glob  : same as -batch for the videos matching glob (or all files of a directory)\n"
+          "-ingest f        : read uncompressed frames from -i (- for stdin, or a named pipe), f is rawvideo (BGR24) or y4m\n"
+          "-size WxH        : frame size of rawvideo input\n"
+          "-fps f           : frame rate of rawvideo input\n"
+          "-realtime        : pace input frames at their frame rate, to replay a file as a live source\n"
+          "-drop p          : when detection falls behind: block (Default), newest (drop incoming frames)\n"
+          "                   or oldest (drop the oldest waiting frame)\n"
+          "-queue n         : number of input frames waiting for detection (Default = "<< DEFAULT_INGEST_QUEUE <<")\n"
+          "-events target   : stream every shot event as a line of JSON to target as soon as it is detected,\n"
+          "                   target is - (stdout), a file or a named pipe\n"
+          "-format f        : format of stored frames: jpeg, png or ppm (Default = jpeg)\n"
+          "-resultformat f  : format of the result file: xml, yaml, text, json or binary (Default = xml)\n"
+          "-quality q       : JPEG quality (0-100, Default = 95) or PNG compression (0-9, Default = 3)\n"
+          "-thumbnail w     : store frames resized to width w\n"
+          "-writers n       : number of threads encoding stored frames (Default = 2)\n"
+          "-pixelstride n   : count every n'th pixel of each row in the histograms\n"
+          "-rowstride n     : count every n'th row of the frames in the histograms\n"
+          "-downscale n     : downscale frames by n (area interpolation) before computing histograms\n"
+          "-benchcompare    : measure cycles per histogram pair of the histogram comparison kernels\n"
+          "-benchsampling   : compare speed and detected boundaries of the sampling modes with full resolution\n"
+          "-tiles n         : split frames into n x n tiles with a histogram each, computed in parallel, and compare\n"
+          "                   frames tile by tile (raise -t, see -benchtiles)\n"
+          "-tileignore k    : drop the k largest tile distances of every frame (Default = a quarter of the tiles)\n"
+          "-benchtiles      : compare time per frame and detected boundaries of 2x2 and 4x4 tiles with one histogram\n"
+          "-cascade s1,s2,. : decide boundaries with a cascade of metrics, each stage run only on the frames which passed\n"
+          "                   the ones before: mad, coarse, chisqr, bhattacharyya, ecr, each optionally =threshold,\n"
+          "                   e.g. coarse,chisqr,ecr. Reports pass rate and time of every stage\n"
+          "-yuv             : compute histograms on unconverted YUV frames of the decoder (or y4m input)\n"
+          "-yuvt threshold  : threshold of YUV histograms (Default = -t threshold), see -benchyuv\n"
+          "-benchyuv        : measure the decode and conversion time saved by -yuv and calibrate -yuvt for -t\n"
+          "-metrics file    : export stage times (decode, histogram, compare, encode, storage) with latency\n"
+          "                   histograms and frame, boundary, keyframe and byte counters to file at the end of\n"
+          "                   the run, in Prometheus text format if file ends with .prom, JSON otherwise\n"
+          "-metricsperiod s : also export the metrics every s seconds while the video is processed\n"
+          "-benchsuite      : generate synthetic videos with known cuts, fades and dissolves at 480p, 1080p and 4K\n"
+          "                   and a high-motion video with cuts under output_path, report microbenchmarks, frames/sec,\n"
+          "                   precision, recall and gradual transitions (also for -i when it has a ground truth file\n"
+          "                   -i.truth)\n"
+          "-benchoutput n   : write result files of n shots (0 for "<< OUTPUT_BENCHMARK_SHOTS <<") in every format under\n"
+          "                   output_path and report events/sec and MB/sec against cv::FileStorage\n"
+          "-synthetic WxH   : write a synthetic video of size WxH to -i and its ground truth to -i.truth\n"
+          "-scaling         : report frames/sec for 1, 2, 4, ... up to the -j thread count\n"
           "-show            : display the shots on GUI (Graphical Version)" <<endl;
 }
+
+/**
+ * @brief scaling_report: processes the video with increasing thread counts
+ * and prints throughput (frames/sec) and speedup against the sequential run.
+ */
+void scaling_report(string videoFile, string outputPath, double threshold, int sample_period, int max_threads){
+    double sequential_fps = 0;
+    cout << "threads\tseconds\tframes/sec\tspeedup" <<endl;
+    for(int threads = 1; ; threads *= 2){
+        if(threads > max_threads)
+            threads = max_threads;
+        ShotDetector sd(videoFile, threshold, sample_period);
+        int64 start_t =  cv::getTickCount();
+        sd.processVideo_Parallel(outputPath, ShotDetector::XML, threads);
+        double time_elapsed = (cv::getTickCount() - start_t) / cv::getTickFrequency();
+        double fps = sd.processedFrameCount() / time_elapsed;
+        if(threads == 1)
+            sequential_fps = fps;
+        cout << threads << "\t" << time_elapsed << "\t" << fps << "\t" << fps / sequential_fps <<endl;
+        if(threads >= max_threads)
+            break;
+    }
+}
+
+/**
+ * @brief histogram_report: measures calcHist + sum + convertTo (previous prepareFrame) against
+ * every supported calcColorHist kernel on frames of the video scaled to common resolutions,
+ * and checks that bin counts are identical to calcHist.
+ */
+void histogram_report(string videoFile){
+    const int widths[] = {640, 1280, 1920, 3840};
+    const int heights[] = {480, 720, 1080, 2160};
+    const int kernels[] = {COLOR_HIST_GENERIC, COLOR_HIST_SSSE3, COLOR_HIST_AVX2, COLOR_HIST_NEON};
+    const int frames = 10;
+
+    VideoCapture cap(videoFile);
+    vector<Mat> source;
+    for(int i = 0; i < frames; i++){
+        Mat frame;
+        cap >> frame;
+        if(frame.empty())
+            break;
+        source.push_back(frame);
+    }
+    if(source.empty()){
+        cout << "error openning video!!" << endl;
+        return;
+    }
+
+    int channels[] = {0, 1, 2};
+    int histSize[] = {32, 32, 32};
+    float color_ranges[] = { 0, 256 };
+    const float* ranges[] = { color_ranges, color_ranges, color_ranges };
+    cout << "resolution\tkernel\tms/frame\tspeedup\tidentical" << endl;
+    for(int r = 0; r < 4; r++){
+        vector<Mat> scaled(source.size());
+        for(size_t i = 0; i < source.size(); i++)
+            resize(source[i], scaled[i], Size(widths[r], heights[r]));
+
+        vector<MatND> expected(scaled.size());
+        int64 start_t = getTickCount();
+        for(size_t i = 0; i < scaled.size(); i++){
+            calcHist(&scaled[i], 1, channels, Mat(), expected[i], 3, histSize, ranges, true, false);
+            MatND normalized;
+            double s = cv::sum(expected[i])[0];
+            expected[i].convertTo(normalized, expected[i].type(), 1./s, 0);
+        }
+        double legacy_ms = 1000. * (getTickCount() - start_t) / getTickFrequency() / scaled.size();
+        cout << widths[r] << "x" << heights[r] << "\tcalcHist\t" << legacy_ms << "\t1\t-" << endl;
+
+        for(int k = 0; k < 4; k++){
+            if(!colorHistKernelSupported(kernels[k]))
+                continue;
+            bool identical = true;
+            MatND hist;
+            start_t = getTickCount();
+            for(size_t i = 0; i < scaled.size(); i++){
+                calcColorHist(scaled[i], hist, CV_32F, kernels[k]);
+                identical = identical && memcmp(hist.data, expected[i].data, COLOR_HIST_TOTAL_BINS * sizeof(float)) == 0;
+            }
+            double ms = 1000. * (getTickCount() - start_t) / getTickFrequency() / scaled.size();
+            cout << widths[r] << "x" << heights[r] << "\t" << colorHistKernelName(kernels[k]) << "\t" << ms
+                 << "\t" << legacy_ms / ms << "\t" << (identical ? "yes" : "no") << endl;
+        }
+    }
+}
+
+/**
+ * @brief compare_report: measures CPU cycles per histogram pair of every comparison method and
+ * supported kernel on consecutive frames of the video, and the largest relative deviation of
+ * each result from the generic kernel. Integer chi-square of bin counts is reported against
+ * the generic chi-square of normalized histograms times the pixel count.
+ */
+void compare_report(string videoFile){
+    const int methods[] = {CV_COMP_CHISQR, CV_COMP_CORREL, CV_COMP_INTERSECT, CV_COMP_BHATTACHARYYA};
+    const char* methodNames[] = {"chisqr", "correl", "intersect", "bhattacharyya"};
+    const int kernels[] = {COLOR_HIST_GENERIC, COLOR_HIST_SSSE3, COLOR_HIST_AVX2, COLOR_HIST_NEON};
+    const int frames = 20;
+    const int repeats = 50;
+
+    VideoCapture cap(videoFile);
+    vector<MatND> hists, counts;
+    double pixelCount = 0;
+    for(int i = 0; i < frames; i++){
+        Mat frame;
+        cap >> frame;
+        if(frame.empty())
+            break;
+        MatND count, hist;
+        calcColorHist(frame, count, CV_32S);
+        calcColorHist(frame, hist, CV_32F);
+        hist.convertTo(hist, hist.type(), 1./frame.total(), 0);
+        counts.push_back(count);
+        hists.push_back(hist);
+        pixelCount = frame.total();
+    }
+    if(hists.size() < 2){
+        cout << "error openning video!!" << endl;
+        return;
+    }
+
+    size_t pairs = hists.size() - 1;
+    cout << "method\tkernel\tcycles/pair\tspeedup\tmax relative deviation" << endl;
+    for(int m = 0; m < 4; m++){
+        vector<double> expected(pairs);
+        double generic_cycles = 0;
+        for(int k = 0; k < 4; k++){
+            if(!colorHistKernelSupported(kernels[k]))
+                continue;
+            vector<double> results(pairs);
+            int64 start_t = getCPUTickCount();
+            for(int r = 0; r < repeats; r++)
+                for(size_t i = 0; i < pairs; i++)
+                    results[i] = compareHistKernel(hists[i], hists[i + 1], methods[m], kernels[k]);
+            double cycles = (double)(getCPUTickCount() - start_t) / (repeats * pairs);
+            if(kernels[k] == COLOR_HIST_GENERIC){
+                expected = results;
+                generic_cycles = cycles;
+            }
+            double deviation = 0;
+            for(size_t i = 0; i < pairs; i++)
+                deviation = std::max(deviation, std::abs(results[i] - expected[i]) / std::max(std::abs(expected[i]), DBL_MIN));
+            cout << methodNames[m] << "\t" << colorHistKernelName(kernels[k]) << "\t" << cycles
+                 << "\t" << generic_cycles / cycles << "\t" << deviation << endl;
+        }
+        if(methods[m] != CV_COMP_CHISQR)
+            continue;
+        for(int k = 0; k < 4; k++){
+            if(!colorHistKernelSupported(kernels[k]))
+                continue;
+            vector<double> results(pairs);
+            int64 start_t = getCPUTickCount();
+            for(int r = 0; r < repeats; r++)
+                for(size_t i = 0; i < pairs; i++)
+                    results[i] = compareHistKernel(counts[i], counts[i + 1], CV_COMP_CHISQR, kernels[k]);
+            double cycles = (double)(getCPUTickCount() - start_t) / (repeats * pairs);
+            double deviation = 0;
+            for(size_t i = 0; i < pairs; i++)
+                deviation = std::max(deviation, std::abs(results[i] / pixelCount - expected[i]) / std::max(std::abs(expected[i]), DBL_MIN));
+            cout << "chisqr (counts)\t" << colorHistKernelName(kernels[k]) << "\t" << cycles
+                 << "\t" << generic_cycles / cycles << "\t" << deviation << endl;
+        }
+    }
+}
+
+/**
+ * @brief sampling_report: detects boundaries of the video at full resolution (prepareFrame and
+ * shotBoundaryDetectHist) and with every sampling mode at factors 2, 4 and 8. For each setting,
+ * prints histogram + detection throughput (decoding excluded) and how many of the full resolution
+ * boundaries are found (missed and extra boundaries are the disagreements).
+ */
+void sampling_report(string videoFile, double threshold){
+    const ShotDetector::SamplingMode modes[] = {ShotDetector::SAMPLE_ALL, ShotDetector::SAMPLE_PIXEL_STRIDE,
+                                                ShotDetector::SAMPLE_ROW_STRIDE, ShotDetector::SAMPLE_DOWNSCALE};
+    const char* modeNames[] = {"full", "pixelstride", "rowstride", "downscale"};
+    const int factors[] = {2, 4, 8};
+
+    vector<int> reference;
+    double reference_fps = 0;
+    cout << "mode\tfactor\tframes/sec\tspeedup\tboundaries\tmatched\tmissed\textra\tagreement" << endl;
+    for(int m = 0; m < 4; m++){
+        for(int f = 0; f < 3; f++){
+            if(modes[m] == ShotDetector::SAMPLE_ALL && f > 0)
+                break;
+            ShotDetector sd(videoFile, threshold, 0, modes[m], factors[f]);
+            VideoCapture cap(videoFile);
+            Mat prevFrame, frame;
+            cap >> prevFrame;
+            if(prevFrame.empty()){
+                cout << "error openning video!!" << endl;
+                return;
+            }
+            MatND prevHist, hist;
+            vector<int> boundaries;
+            int64 elapsed_t = 0;
+            int frames = 0;
+            int64 start_t = getTickCount();
+            if(modes[m] == ShotDetector::SAMPLE_ALL)
+                prevHist = sd.prepareFrame(prevFrame);
+            else
+                sd.prepareFrameCounts(prevFrame, prevHist);
+            elapsed_t += getTickCount() - start_t;
+            for(int i = 1; ; i++){
+                cap >> frame;
+                if(frame.empty())
+                    break;
+                start_t = getTickCount();
+                bool boundary;
+                if(modes[m] == ShotDetector::SAMPLE_ALL){
+                    hist = sd.prepareFrame(frame);
+                    boundary = sd.shotBoundaryDetectHist(prevHist, hist);
+                }else{
+                    sd.prepareFrameCounts(frame, hist);
+                    boundary = sd.shotBoundaryDetectCounts(prevHist, hist, sd.sampledPixelCount(frame));
+                }
+                elapsed_t += getTickCount() - start_t;
+                if(boundary)
+                    boundaries.push_back(i);
+                swap(prevHist, hist);
+                frames++;
+            }
+            double fps = frames / (elapsed_t / getTickFrequency());
+            if(modes[m] == ShotDetector::SAMPLE_ALL){
+                reference = boundaries;
+                reference_fps = fps;
+            }
+            vector<int> matched;
+            set_intersection(reference.begin(), reference.end(), boundaries.begin(), boundaries.end(), back_inserter(matched));
+            size_t missed = reference.size() - matched.size();
+            size_t extra = boundaries.size() - matched.size();
+            size_t all = matched.size() + missed + extra;
+            cout << modeNames[m] << "\t" << (modes[m] == ShotDetector::SAMPLE_ALL ? 1 : factors[f]) << "\t" << fps
+                 << "\t" << fps / reference_fps << "\t" << boundaries.size() << "\t" << matched.size()
+                 << "\t" << missed << "\t" << extra << "\t" << (all ? 100. * matched.size() / all : 100.) << "%" << endl;
+        }
+    }
+}
+
+/**
+ * @brief tile_report: compares the tile mode (see ShotDetector::setTileGrid) with one histogram per frame on the
+ * video: the global histogram, and 2x2 and 4x4 tiles without dropping tile distances and with a quarter of them
+ * dropped. For each setting, prints the wall clock time per frame of the histograms and of the comparisons
+ * (decoding excluded), frames/sec and speedup against the global histogram, the boundaries at threshold
+ * matched with the ones of the global histogram, and the threshold which reproduces most of its decisions.
+ */
+void tile_report(string videoFile, double threshold){
+    const int grids[] = {1, 2, 2, 4, 4};
+    const int ignored[] = {0, 0, 1, 0, 4};
+
+    vector<char> reference;
+    double reference_fps = 0;
+    cout << "tiles\tignored\thist ms\tcompare us\tframes/sec\tspeedup\tboundaries\tmatched\tmissed\textra"
+            "\tcalibrated -t\tagreement" << endl;
+    for(int m = 0; m < 5; m++){
+        ShotDetector sd(videoFile, threshold);
+        sd.setTileGrid(grids[m], ignored[m]);
+        VideoCapture cap(videoFile);
+        Mat frame;
+        cap >> frame;
+        if(frame.empty()){
+            cout << "error openning video!!" << endl;
+            return;
+        }
+        MatND prevHist, hist;
+        //distances of consecutive frames, normalized by the pixel count like the threshold
+        vector<double> distances;
+        int64 hist_t = 0, compare_t = 0;
+        int64 start_t = getTickCount();
+        sd.prepareFrameCounts(frame, prevHist);
+        hist_t += getTickCount() - start_t;
+        int frames = 1;
+        while(1){
+            cap >> frame;
+            if(frame.empty())
+                break;
+            start_t = getTickCount();
+            sd.prepareFrameCounts(frame, hist);
+            int64 compare_start = getTickCount();
+            double distance = sd.histDistance(prevHist, hist);
+            compare_t += getTickCount() - compare_start;
+            hist_t += compare_start - start_t;
+            distances.push_back(distance / sd.sampledPixelCount(frame));
+            swap(prevHist, hist);
+            frames++;
+        }
+        double fps = frames / ((hist_t + compare_t) / getTickFrequency());
+        vector<char> boundaries(distances.size());
+        for(size_t i = 0; i < distances.size(); i++)
+            boundaries[i] = distances[i] > threshold;
+        if(m == 0){
+            reference = boundaries;
+            reference_fps = fps;
+        }
+        size_t found = 0, matched = 0, expected = 0;
+        for(size_t i = 0; i < boundaries.size() && i < reference.size(); i++){
+            found += boundaries[i];
+            expected += reference[i];
+            matched += boundaries[i] && reference[i];
+        }
+        long agreed = 0;
+        double calibrated = distances.empty() ? threshold : calibrate_threshold(distances, reference, agreed);
+        cout << grids[m] << "x" << grids[m] << "\t" << ignored[m] << "\t" << 1000. * hist_t / getTickFrequency() / frames
+             << "\t" << 1e6 * compare_t / getTickFrequency() / std::max(frames - 1, 1) << "\t" << fps
+             << "\t" << fps / reference_fps << "\t" << found << "\t" << matched << "\t" << expected - matched
+             << "\t" << found - matched << "\t" << calibrated << "\t"
+             << (distances.empty() ? 100. : 100. * agreed / distances.size()) << "%" << endl;
+    }
+}
+
+/**
+ * @brief cascade_report: prints the frames evaluated and passed by every stage of a processVideo_Cascade run,
+ * its time per evaluated frame and its share of the time per compared frame, and how many full histograms
+ * were computed against one per frame without the cascade.
+ */
+void cascade_report(const CascadeDetector::Stats &stats, const vector<CascadeDetector::Stage> &stages){
+    double total = 0;
+    for(size_t s = 0; s < stats.stages.size(); s++)
+        total += stats.stages[s].seconds;
+    int frames = std::max(stats.frames, 1);
+    cout << "stage	threshold	evaluated	passed	pass rate	ms/evaluated	ms/frame" << endl;
+    for(size_t s = 0; s < stats.stages.size() && s < stages.size(); s++){
+        const CascadeDetector::StageStats &stage = stats.stages[s];
+        cout << CascadeDetector::metricName(stages[s].metric) << "	" << stages[s].threshold << "	" << stage.evaluated
+             << "	" << stage.passed << "	" << (stage.evaluated ? 100. * stage.passed / stage.evaluated : 0) << "%"
+             << "	" << (stage.evaluated ? 1000. * stage.seconds / stage.evaluated : 0)
+             << "	" << 1000. * stage.seconds / frames << endl;
+    }
+    cout << "cascade: " << 1000. * total / frames << " ms per compared frame, " << stats.histograms
+         << " full histograms computed for " << stats.frames + 1 << " frames" << endl;
+}
+
+/**
+ * @brief yuv_report: measures what the YUV native mode saves on the video. Decoding is timed with and
+ * without the conversion to BGR (when the backend cannot deliver unconverted frames, the frames are
+ * converted to I420 outside of the timing and the saving is estimated from the conversion time).
+ * Then the YUV threshold is calibrated: Chi-Square distances of consecutive BGR and YUV histograms are
+ * collected and the YUV threshold which reproduces most of the BGR boundary decisions at threshold is printed.
+ */
+void yuv_report(string videoFile, double threshold){
+    VideoCapture cap(videoFile);
+    Mat frame, bgr;
+    MatND prevHist, hist;
+    vector<double> bgrDistances;
+    int64 decode_t = 0, hist_t = 0;
+    int frames = 0;
+    while(1){
+        int64 start_t = getTickCount();
+        cap >> frame;
+        decode_t += getTickCount() - start_t;
+        if(frame.empty())
+            break;
+        start_t = getTickCount();
+        calcColorHist(frame, hist, CV_32S);
+        hist_t += getTickCount() - start_t;
+        if(frames > 0)
+            bgrDistances.push_back(compareHistCustom(prevHist, hist, CV_COMP_CHISQR) / frame.total());
+        swap(prevHist, hist);
+        frames++;
+    }
+    if(frames < 2){
+        cout << "error openning video!!" << endl;
+        return;
+    }
+
+    //second pass on unconverted frames
+    cap.open(videoFile);
+    cap.set(CV_CAP_PROP_CONVERT_RGB, 0);
+    bool unconverted = false;
+    vector<double> yuvDistances;
+    int64 rawDecode_t = 0, convert_t = 0, yuvHist_t = 0;
+    Mat i420;
+    for(int i = 0; i < frames; i++){
+        int64 start_t = getTickCount();
+        cap >> frame;
+        rawDecode_t += getTickCount() - start_t;
+        if(frame.empty())
+            break;
+        if(i == 0)
+            unconverted = frame.type() == CV_8UC1;
+        if(unconverted)
+            i420 = frame;
+        else
+            cvtColor(frame, i420, CV_BGR2YUV_I420);
+
+        //conversion done by the decoder when BGR frames are requested
+        start_t = getTickCount();
+        cvtColor(i420, bgr, CV_YUV2BGR_I420);
+        convert_t += getTickCount() - start_t;
+
+        start_t = getTickCount();
+        calcYUVHist(i420, hist, YUV_I420, CV_32S);
+        yuvHist_t += getTickCount() - start_t;
+        if(i > 0)
+            yuvDistances.push_back(compareHistCustom(prevHist, hist, CV_COMP_CHISQR) / yuvFramePixels(i420, YUV_I420));
+        swap(prevHist, hist);
+    }
+    if(yuvDistances.size() != bgrDistances.size()){
+        cout << "frame count of the unconverted pass differs" << endl;
+        return;
+    }
+
+    double ms = 1000. / getTickFrequency() / frames;
+    double bgrDecode = decode_t * ms, bgrHist = hist_t * ms, convert = convert_t * ms, yuvHist = yuvHist_t * ms;
+    //without unconverted frames the YUV path is estimated as the BGR decode minus the conversion
+    double yuvDecode = unconverted ? rawDecode_t * ms : bgrDecode - convert;
+    cout << "stage	ms/frame" << endl;
+    cout << "decode to BGR	" << bgrDecode << endl;
+    cout << "decode unconverted	";
+    if(unconverted)
+        cout << yuvDecode << endl;
+    else
+        cout << "not supported by the backend, estimated " << yuvDecode << endl;
+    cout << "I420 -> BGR	" << convert << endl;
+    cout << "BGR histogram	" << bgrHist << endl;
+    cout << "YUV histogram	" << yuvHist << endl;
+    cout << "end-to-end (decode + histogram): BGR " << 1000. / (bgrDecode + bgrHist) << " frames/sec, YUV "
+         << 1000. / (yuvDecode + yuvHist) << " frames/sec, " << 100. * (1 - (yuvDecode + yuvHist) / (bgrDecode + bgrHist))
+         << "% of the time saved" << endl;
+
+    size_t n = bgrDistances.size();
+    vector<char> reference(n);
+    size_t boundaries = 0;
+    for(size_t i = 0; i < n; i++){
+        reference[i] = bgrDistances[i] > threshold;
+        boundaries += reference[i];
+    }
+    long best;
+    double best_threshold = calibrate_threshold(yuvDistances, reference, best);
+    size_t same = 0;
+    for(size_t i = 0; i < n; i++)
+        same += (yuvDistances[i] > threshold) == (bgrDistances[i] > threshold);
+    cout << "BGR boundaries at threshold " << threshold << ": " << boundaries << " of " << n << " frame pairs" << endl;
+    cout << "YUV decisions at the same threshold: " << 100. * same / n << "% agreement" << endl;
+    cout << "calibrated YUV threshold: -yuvt " << best_threshold << " (" << best_threshold / threshold
+         << " x threshold), " << 100. * best / n << "% agreement" << endl;
+}
+
+/**
+ * @brief calibrate_threshold: Returns the threshold of the distances which reproduces most of the reference
+ * decisions (true for a boundary) of the same frame pairs.
+ * @param agreed: number of frame pairs decided as in the reference at the returned threshold
+ */
+double calibrate_threshold(const vector<double> &distances, const vector<char> &reference, long &agreed){
+    /** with the pairs sorted by distance, a threshold between the k'th and (k+1)'th pair
+     * decides the first k+1 pairs as no boundary and the rest as boundaries.
+     **/
+    size_t n = distances.size();
+    vector< pair<double, bool> > pairs(n);
+    long boundaries = 0;
+    for(size_t i = 0; i < n; i++){
+        pairs[i] = make_pair(distances[i], reference[i] != 0);
+        boundaries += pairs[i].second;
+    }
+    sort(pairs.begin(), pairs.end());
+    //threshold below every distance: all pairs are boundaries
+    long count = boundaries;
+    agreed = count;
+    double best_threshold = n ? pairs[0].first / 2 : 0;
+    for(size_t k = 0; k < n; k++){
+        count += pairs[k].second ? -1 : 1;
+        if(count > agreed && (k + 1 == n || pairs[k + 1].first > pairs[k].first)){
+            agreed = count;
+            best_threshold = k + 1 < n ? (pairs[k].first + pairs[k + 1].first) / 2 : pairs[k].first * 2;
+        }
+    }
+    return best_threshold;
+}
+
+/**
+ * @brief frame_checksum: FNV-1a hash of the pixels of a frame, to compare frames without keeping them.
+ */
+uint64 frame_checksum(const Mat &frame){
+    uint64 hash = 14695981039346656037ULL;
+    for(int r = 0; r < frame.rows; r++){
+        const uchar* row = frame.ptr(r);
+        for(size_t i = 0; i < frame.cols * frame.elemSize(); i++)
+            hash = (hash ^ row[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief extract_report: extracts count frames spread evenly over the video, first with a getShotFromVideo call
+ * (a new capture and a seek) per frame, then with a single FrameExtractor decoding forward only, seeking to
+ * every frame and choosing between both from the measured times. Prints frames/sec, seeks and skipped frames
+ * of each method and the number of frames which differ from the ones of getShotFromVideo.
+ */
+void extract_report(string videoFile, int count){
+    VideoCapture cap(videoFile);
+    int frame_count = (int) cap.get(CV_CAP_PROP_FRAME_COUNT);
+    cap.release();
+    if(frame_count <= 0){
+        cout << "error openning video!!" << endl;
+        return;
+    }
+    count = std::min(count, frame_count);
+    vector<int> frame_numbers;
+    for(int k = 0; k < count; k++)
+        frame_numbers.push_back(1 + (int) ((int64) k * frame_count / count));
+
+    //frames are compared by checksum, the time spent on checksums is not counted
+    ShotDetector sd(videoFile, DEFAULT_THRESHOLD);
+    vector<uint64> reference;
+    int64 reference_t = 0;
+    for(size_t k = 0; k < frame_numbers.size(); k++){
+        int64 start_t = getTickCount();
+        Mat frame = sd.getShotFromVideo(frame_numbers[k] - 1);
+        reference_t += getTickCount() - start_t;
+        reference.push_back(frame_checksum(frame));
+    }
+    double reference_seconds = reference_t / getTickFrequency();
+
+    cout << "extracting " << count << " of " << frame_count << " frames" << endl;
+    cout << "method\tseconds\tframes/sec\tspeedup\tseeks\tskipped\tdiffering" << endl;
+    cout << "getShotFromVideo\t" << reference_seconds << "\t" << count / reference_seconds << "\t1\t" << count
+         << "\t0\t0" << endl;
+    const char* methodNames[] = {"forward", "seek", "auto"};
+    const int seekGaps[] = {INT_MAX, 1, 0};
+    for(int m = 0; m < 3; m++){
+        FrameExtractor extractor(videoFile);
+        extractor.setSeekGap(seekGaps[m]);
+        vector<uint64> extracted;
+        int64 checksum_t = 0;
+        int64 start_t = getTickCount();
+        extractor.extract(frame_numbers, [&](int frame_number, const Mat &frame){
+            int64 call_t = getTickCount();
+            extracted.push_back(frame_checksum(frame));
+            checksum_t += getTickCount() - call_t;
+        });
+        double seconds = (getTickCount() - start_t - checksum_t) / getTickFrequency();
+        int delivered = (int) extracted.size();
+        int differing = count - delivered;
+        for(int k = 0; k < delivered; k++)
+            differing += reference[k] != extracted[k];
+        const FrameExtractor::Stats &stats = extractor.stats();
+        cout << methodNames[m] << "	" << seconds << "	" << delivered / seconds << "	" << reference_seconds / seconds
+             << "	" << stats.seeks << "	" << stats.grabbed << "	" << differing << endl;
+    }
+}
+
+/**
+ * @brief seek_report: looks up count frames at random positions of the video one after the other on a single
+ * capture, first by seeking to each frame (CV_CAP_PROP_POS_FRAMES) and reading it, then with the seek index
+ * (see SeekIndex). Prints the latency per lookup (p50/p99/max), the frames decoded by the indexed lookups and
+ * the number of frames which differ from the ones of a sequential decode of the video.
+ */
+void seek_report(string videoFile, string indexFile, int count){
+    SeekIndex index;
+    if(!index.open(indexFile) || !index.matches(videoFile)){
+        cout << "error openning seek index " << indexFile << endl;
+        return;
+    }
+    int frame_count = index.frameCount();
+    std::mt19937 random(frame_count);
+    vector<int> lookups;
+    for(int k = 0; k < count; k++)
+        lookups.push_back((int) (random() % frame_count));
+
+    //checksums of the looked up frames decoded in order
+    vector<int> sorted(lookups);
+    sort(sorted.begin(), sorted.end());
+    sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+    map<int, uint64> reference;
+    VideoCapture cap(videoFile);
+    Mat frame;
+    size_t next = 0;
+    for(int i = 0; next < sorted.size() && cap.grab(); i++){
+        if(i != sorted[next])
+            continue;
+        cap.retrieve(frame);
+        reference[i] = frame_checksum(frame);
+        next++;
+    }
+    cap.release();
+
+    cout << "looking up " << count << " of " << frame_count << " frames, keyframe interval "
+         << index.header().keyframe_interval << endl;
+    cout << "method\tp50 ms\tp99 ms\tmax ms\tdecoded/lookup\tdiffering" << endl;
+    const char* methodNames[] = {"seek", "indexed"};
+    for(int m = 0; m < 2; m++){
+        VideoCapture capture(videoFile);
+        vector<double> latencies;
+        int position = 0, differing = 0;
+        int64 decoded = 0;
+        for(size_t k = 0; k < lookups.size(); k++){
+            int64 start_t = getTickCount();
+            bool found;
+            if(m == 0){
+                capture.set(CV_CAP_PROP_POS_FRAMES, lookups[k]);
+                found = capture.read(frame);
+            } else {
+                int frames = 0;
+                found = index.seek(capture, lookups[k], position, frames) && capture.retrieve(frame);
+                decoded += frames;
+            }
+            latencies.push_back((getTickCount() - start_t) * 1000. / getTickFrequency());
+            differing += !found || frame_checksum(frame) != reference[lookups[k]];
+        }
+        sort(latencies.begin(), latencies.end());
+        auto percentile = [&](double p){
+            return latencies.empty() ? 0 : latencies[(size_t) (p / 100. * (latencies.size() - 1) + 0.5)];
+        };
+        cout << methodNames[m] << "\t" << percentile(50) << "\t" << percentile(99) << "\t" << percentile(100) << "\t";
+        if(m == 0)
+            cout << "-";
+        else
+            cout << (double) decoded / std::max(count, 1);
+        cout << "\t" << differing << endl;
+    }
+}
+
+/**
+ * @brief batch_videos: Returns the videos of a batch, either the lines of the manifest file
+ * (empty lines and lines starting with '#' are skipped) or the files matching the glob pattern.
+ */
+vector<string> batch_videos(string manifest, bool isGlob){
+    vector<string> videos;
+    if(isGlob){
+        vector<cv::String> matches;
+        cv::glob(manifest, matches, false);
+        videos.assign(matches.begin(), matches.end());
+        sort(videos.begin(), videos.end());
+        return videos;
+    }
+    ifstream list(manifest.c_str());
+    if(!list.is_open()){
+        cout << "error openning batch list " << manifest << endl;
+        return videos;
+    }
+    string line;
+    while(getline(list, line)){
+        //strip carriage returns of lists written on windows
+        if(!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+        if(line.empty() || line[0] == '#')
+            continue;
+        videos.push_back(line);
+    }
+    return videos;
+}
+
+/**
+ * @brief batch_process: Processes the videos of a batch in a single process on num_threads workers,
+ * each worker takes the next unprocessed video and runs processVideo_NoGUI on it. Results of a video
+ * are stored under outputPath/<video name without extension> (suffixed with its index when two videos
+ * have the same name). A video which cannot be opened or fails is reported and the batch goes on.
+ * Prints the time and frames/sec of every video and the aggregate frames/sec of the batch.
+ */
+void batch_process(const vector<string>& videos, string outputPath, double threshold, int sample_period,
+                   ShotDetector::SamplingMode sampling, int sampling_factor,
+                   const KeyframeWriter::Options& keyframeOptions, std::ostream* eventStream, int num_threads,
+                   ShotDetector::OutputFormat resultFormat){
+    if(videos.empty()){
+        cout << "no videos to process" << endl;
+        return;
+    }
+    //output directory of each video, named after the video
+    vector<string> outputs(videos.size());
+    set<string> names;
+    for(size_t i = 0; i < videos.size(); i++){
+        string name = videos[i].substr(videos[i].find_last_of("/\\") + 1);
+        if(name.find('.') != string::npos)
+            name = name.substr(0, name.find_last_of('.'));
+        if(!names.insert(name).second){
+            stringstream suffix;
+            suffix << name << "_" << i;
+            name = suffix.str();
+        }
+        outputs[i] = outputPath + "/" + name;
+    }
+
+    vector<int> frames(videos.size(), 0);
+    vector<double> seconds(videos.size(), 0);
+    vector<char> failed(videos.size(), 0);
+    std::atomic<size_t> nextVideo(0);
+    std::mutex outputMutex;
+    auto worker = [&](){
+        for(size_t i = nextVideo++; i < videos.size(); i = nextVideo++){
+            int64 start_t = cv::getTickCount();
+            try{
+                ShotDetector sd(videos[i], threshold, sample_period, sampling, sampling_factor);
+                sd.setKeyframeOptions(keyframeOptions);
+                sd.setEventStream(eventStream);
+                sd.processVideo_NoGUI(outputs[i], resultFormat);
+                frames[i] = sd.processedFrameCount();
+                failed[i] = frames[i] == 0;
+            }catch(const cv::Exception& e){
+                std::lock_guard<std::mutex> lock(outputMutex);
+                cout << "error processing " << videos[i] << ": " << e.what() << endl;
+                failed[i] = true;
+            }
+            seconds[i] = (cv::getTickCount() - start_t) / cv::getTickFrequency();
+        }
+    };
+
+    num_threads = std::max(1, std::min(num_threads, (int) videos.size()));
+    int64 start_t = cv::getTickCount();
+    vector<std::thread> workers;
+    for(int k = 0; k < num_threads; k++)
+        workers.push_back(std::thread(worker));
+    for(size_t k = 0; k < workers.size(); k++)
+        workers[k].join();
+    double time_elapsed = (cv::getTickCount() - start_t) / cv::getTickFrequency();
+
+    int total_frames = 0;
+    int failures = 0;
+    cout << "video\tframes\tseconds\tframes/sec\tstatus" << endl;
+    for(size_t i = 0; i < videos.size(); i++){
+        total_frames += frames[i];
+        failures += failed[i] ? 1 : 0;
+        cout << videos[i] << "\t" << frames[i] << "\t" << seconds[i] << "\t"
+             << (seconds[i] > 0 ? frames[i] / seconds[i] : 0) << "\t" << (failed[i] ? "failed" : "ok") << endl;
+    }
+    cout << "videos: " << videos.size() << " (" << failures << " failed), threads: " << num_threads << endl;
+    cout << "time elapsed: " << time_elapsed << " seconds" << endl;
+    cout << "frames/sec: " << total_frames / time_elapsed << endl;
+}
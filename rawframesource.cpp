@@ -0,0 +1,278 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#include "rawframesource.h"
+#include <opencv2/imgproc/imgproc.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+
+RawFrameSource::Frame::Frame(): index(-1), arrival(0), slot(-1)
+{
+}
+
+/**
+ * @brief RawFrameSource::RawFrameSource
+ * @param path: "-" for stdin, otherwise a file or a named pipe
+ * @param format: RAWVIDEO_BGR24 or YUV4MPEG (size and fps are read from the stream header)
+ * @param size: frame size of rawvideo
+ * @param fps: frame rate of rawvideo, used for frame times and real-time pacing
+ * @param queue_size: maximum number of frames waiting for the consumer
+ * @param policy: what the reader does when queue_size frames are waiting
+ * @param realtime: release frames at the frame rate instead of as fast as they are read
+ */
+RawFrameSource::RawFrameSource(std::string path, Format format, cv::Size size, double fps, int queue_size,
+                               DropPolicy policy, bool realtime):
+    path(path), format(format), size(size), frameRate(fps), policy(policy), realtime(realtime), input(0),
+    frameBytes(0), queueSize(queue_size > 0 ? queue_size : 1), finished(false), stopping(false), received(0), dropped(0)
+{
+}
+
+RawFrameSource::~RawFrameSource()
+{
+    close();
+}
+
+/**
+ * @brief RawFrameSource::open: Opens the input, reads the stream header and starts the reader thread.
+ * @return: false if the input cannot be opened or its format is not supported
+ */
+bool RawFrameSource::open(){
+    input = path == "-" ? stdin : fopen(path.c_str(), "rb");
+    if(!input){
+        cout << "error openning " << path << endl;
+        return false;
+    }
+    if(format == YUV4MPEG && !readHeader())
+        return false;
+    if(size.width <= 0 || size.height <= 0 || frameRate <= 0){
+        cout << "frame size and fps of the stream must be given" << endl;
+        return false;
+    }
+    if(format == YUV4MPEG){
+        if(size.width % 2 || size.height % 2){
+            cout << "YUV4MPEG frames must have even width and height" << endl;
+            return false;
+        }
+        frameBytes = (size_t) size.width * size.height * 3 / 2;
+    }else{
+        frameBytes = (size_t) size.width * size.height * 3;
+    }
+
+    //the consumer holds the previous and the current frame besides the queued ones
+    buffers.assign(queueSize + 2, std::vector<uchar>(frameBytes));
+    if(policy == DROP_NEWEST)
+        discarded.resize(frameBytes);
+    for(int i = (int) buffers.size() - 1; i >= 0; i--)
+        freeSlots.push_back(i);
+    reader = std::thread(&RawFrameSource::readerLoop, this);
+    return true;
+}
+
+/**
+ * @brief RawFrameSource::readHeader: Parses "YUV4MPEG2 W<width> H<height> F<num>:<den> ... C<chroma>",
+ * only 4:2:0 chroma subsampling is supported.
+ */
+bool RawFrameSource::readHeader(){
+    std::string header;
+    int c;
+    while((c = fgetc(input)) != EOF && c != '\n')
+        header.push_back((char) c);
+    if(header.compare(0, 10, "YUV4MPEG2 ") != 0){
+        cout << "not a YUV4MPEG2 stream" << endl;
+        return false;
+    }
+    stringstream tokens(header.substr(10));
+    std::string token;
+    while(tokens >> token){
+        if(token[0] == 'W'){
+            size.width = atoi(token.c_str() + 1);
+        }else if(token[0] == 'H'){
+            size.height = atoi(token.c_str() + 1);
+        }else if(token[0] == 'F'){
+            double num = 0, den = 1;
+            char colon;
+            stringstream rate(token.substr(1));
+            rate >> num >> colon >> den;
+            if(den > 0)
+                frameRate = num / den;
+        }else if(token[0] == 'C' && token.compare(1, 3, "420") != 0){
+            cout << "unsupported YUV4MPEG chroma " << token.substr(1) << ", only 4:2:0 is supported" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief RawFrameSource::readFrame: Reads the next frame of the input into buffer.
+ * @return: false at the end of input
+ */
+bool RawFrameSource::readFrame(uchar *buffer){
+    if(format == YUV4MPEG){
+        //frame header: "FRAME" and optional parameters up to the end of line
+        char tag[6] = {0};
+        if(fread(tag, 1, 5, input) != 5 || strcmp(tag, "FRAME") != 0)
+            return false;
+        int c;
+        while((c = fgetc(input)) != EOF && c != '\n')
+            ;
+        if(c == EOF)
+            return false;
+    }
+    return fread(buffer, 1, frameBytes, input) == frameBytes;
+}
+
+/**
+ * @brief RawFrameSource::readerLoop: Reads frames until the end of input and queues them for the consumer.
+ */
+void RawFrameSource::readerLoop(){
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int index = 0; ; index++){
+        int slot = -1;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            if(policy == BLOCK)
+                slotFreed.wait(lock, [this]{ return stopping || !freeSlots.empty(); });
+            if(stopping)
+                break;
+            if(!freeSlots.empty()){
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            }else if(policy == DROP_OLDEST && !queued.empty()){
+                slot = queued.front().slot;
+                queued.pop_front();
+                dropped++;
+            }
+        }
+        //without a free buffer (DROP_NEWEST) the frame is read and discarded
+        bool read = readFrame(slot >= 0 ? &buffers[slot][0] : &discarded[0]);
+        if(read && realtime)
+            std::this_thread::sleep_until(start + std::chrono::microseconds((int64) (1e6 * index / frameRate)));
+
+        unique_lock<mutex> lock(queueMutex);
+        if(!read){
+            if(slot >= 0)
+                freeSlots.push_back(slot);
+            break;
+        }
+        received++;
+        if(slot < 0){
+            dropped++;
+            continue;
+        }
+        Frame frame;
+        frame.index = index;
+        frame.arrival = getTickCount();
+        frame.slot = slot;
+        if(format == YUV4MPEG)
+            frame.image = Mat(size.height * 3 / 2, size.width, CV_8UC1, &buffers[slot][0]);
+        else
+            frame.image = Mat(size.height, size.width, CV_8UC3, &buffers[slot][0]);
+        queued.push_back(frame);
+        lock.unlock();
+        frameQueued.notify_one();
+    }
+    lock_guard<mutex> lock(queueMutex);
+    finished = true;
+    frameQueued.notify_all();
+}
+
+/**
+ * @brief RawFrameSource::read: Waits for the next frame. The image of the frame points into a buffer
+ * of the source, which is not reused until the frame is given back with release().
+ * @return: false at the end of input
+ */
+bool RawFrameSource::read(Frame &frame){
+    unique_lock<mutex> lock(queueMutex);
+    frameQueued.wait(lock, [this]{ return finished || !queued.empty(); });
+    if(queued.empty())
+        return false;
+    frame = queued.front();
+    queued.pop_front();
+    return true;
+}
+
+/**
+ * @brief RawFrameSource::release: Gives the buffer of frame back to the reader.
+ */
+void RawFrameSource::release(Frame &frame){
+    if(frame.slot < 0)
+        return;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        freeSlots.push_back(frame.slot);
+    }
+    slotFreed.notify_one();
+    frame.image.release();
+    frame.slot = -1;
+}
+
+/**
+ * @brief RawFrameSource::close: Stops the reader thread and closes the input.
+ */
+void RawFrameSource::close(){
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    slotFreed.notify_all();
+    if(reader.joinable())
+        reader.join();
+    if(input && input != stdin)
+        fclose(input);
+    input = 0;
+}
+
+/**
+ * @brief RawFrameSource::toBGR: Returns the frame as a BGR image. A BGR24 frame is only wrapped (bgr shares
+ * the buffer of the frame), a YUV4MPEG frame is converted into bgr, whose storage is reused when possible.
+ */
+void RawFrameSource::toBGR(const Frame &frame, cv::Mat &bgr) const{
+    if(format == YUV4MPEG)
+        cvtColor(frame.image, bgr, CV_YUV2BGR_I420);
+    else
+        bgr = frame.image;
+}
+
+RawFrameSource::Format RawFrameSource::inputFormat() const{
+    return format;
+}
+
+cv::Size RawFrameSource::frameSize() const{
+    return size;
+}
+
+double RawFrameSource::fps() const{
+    return frameRate;
+}
+
+std::string RawFrameSource::name() const{
+    return path == "-" ? std::string("stdin") : path;
+}
+
+int RawFrameSource::receivedFrames() const{
+    lock_guard<mutex> lock(queueMutex);
+    return received;
+}
+
+int RawFrameSource::droppedFrames() const{
+    lock_guard<mutex> lock(queueMutex);
+    return dropped;
+}
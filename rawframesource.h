@@ -0,0 +1,95 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#ifndef RAWFRAMESOURCE_H
+#define RAWFRAMESOURCE_H
+#include <opencv2/core/core.hpp>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The RawFrameSource class reads uncompressed frames (rawvideo BGR24 or YUV4MPEG2 4:2:0)
+ * from stdin, a file or a named pipe on a reader thread. Frames are read into a fixed set of
+ * buffers and handed out as cv::Mat headers on these buffers, without copying.
+ * When the consumer falls behind and every buffer is queued, the drop policy decides whether
+ * the reader waits (BLOCK), discards the incoming frame (DROP_NEWEST) or replaces the oldest
+ * queued frame (DROP_OLDEST). With real-time pacing, frames are released at the rate of the
+ * source fps, so a file can stand in for a live feed.
+ */
+class RawFrameSource
+{
+public:
+    enum Format {RAWVIDEO_BGR24, YUV4MPEG};
+    enum DropPolicy {BLOCK, DROP_NEWEST, DROP_OLDEST};
+    /** frame handed to the consumer, must be given back with release() **/
+    struct Frame
+    {
+        Frame();
+        cv::Mat image;              // CV_8UC3 BGR, or CV_8UC1 I420 planes (rows * 3/2) for YUV4MPEG
+        int index;                  // 0 based index of the frame in the source, dropped frames included
+        int64 arrival;              // tick count when the frame became available
+        int slot;
+    };
+
+    RawFrameSource(std::string path, Format format, cv::Size size, double fps, int queue_size,
+                   DropPolicy policy, bool realtime);
+    ~RawFrameSource();
+    bool open();
+    bool read(Frame &frame);
+    void release(Frame &frame);
+    void close();
+    void toBGR(const Frame &frame, cv::Mat &bgr) const;
+    Format inputFormat() const;
+    cv::Size frameSize() const;
+    double fps() const;
+    std::string name() const;
+    int receivedFrames() const;
+    int droppedFrames() const;
+
+private:
+    RawFrameSource(const RawFrameSource&);
+    RawFrameSource& operator=(const RawFrameSource&);
+    bool readHeader();
+    bool readFrame(uchar *buffer);
+    void readerLoop();
+
+    std::string path;
+    Format format;
+    cv::Size size;
+    double frameRate;
+    DropPolicy policy;
+    bool realtime;
+    FILE *input;
+    size_t frameBytes;
+    std::vector< std::vector<uchar> > buffers;
+    std::vector<uchar> discarded;   // frames dropped by DROP_NEWEST are read here
+    std::vector<int> freeSlots;
+    std::deque<Frame> queued;
+    size_t queueSize;
+    bool finished;
+    bool stopping;
+    int received;
+    int dropped;
+    mutable std::mutex queueMutex;
+    std::condition_variable frameQueued;
+    std::condition_variable slotFreed;
+    std::thread reader;
+};
+
+#endif // RAWFRAMESOURCE_H
@@ -0,0 +1,731 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#include "resultwriter.h"
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+using namespace std;
+
+#define RESULT_MAGIC "SHOTRES"
+#define VERSION 1
+
+namespace {
+
+/**
+ * @brief The XMLResultWriter class writes the XML layout of cv::FileStorage: a map per header and shot in
+ * the Header and Shots sequences, strings quoted and escaped like FileStorage does.
+ */
+class XMLResultWriter: public ResultWriter
+{
+public:
+    explicit XMLResultWriter(const string &path): ResultWriter(path){}
+    ~XMLResultWriter(){ close(); }
+    void writeHeader(const Header &header){
+        put("<?xml version=\"1.0\"?>\n<opencv_storage>\n<Header>\n  <_>");
+        beginElement("video_path");
+        putString(header.video_path);
+        endElement("video_path");
+        if(header.threshold >= 0){
+            beginElement("threshold");
+            putDouble(header.threshold);
+            endElement("threshold");
+        }
+        intElement("fps", header.fps);
+        intElement("frame_count", header.frame_count);
+        put("</_></Header>\n");
+    }
+    void beginShots(){
+        put("<Shots>");
+    }
+    void shotBegin(int frame_number, double time){
+        put("\n  <_>");
+        intElement("begin_frame_number", frame_number);
+        timeElement("begin_time", time);
+    }
+    void shotSample(int frame_number, double time){
+        intElement("frame_number", frame_number);
+        timeElement("time", time);
+    }
+    void shotEnd(int frame_number, double time){
+        intElement("end_frame_number", frame_number);
+        timeElement("end_time", time);
+        put("</_>");
+    }
+    void aborted(int frame_number, double time, bool inShot){
+        if(!inShot)
+            put("\n  <_>");
+        intElement("aborted_frame_number", frame_number);
+        timeElement("time", time);
+        put("</_>");
+    }
+    void endShots(){
+        put("</Shots>\n");
+    }
+    void writeTransitions(const vector<GradualDetector::Transition> &transitions){
+        put("<GradualTransitions>");
+        for(size_t i = 0; i < transitions.size(); i++){
+            put("\n  <_>");
+            intElement("begin_frame_number", transitions[i].begin_frame_number);
+            timeElement("begin_time", transitions[i].begin_time);
+            intElement("end_frame_number", transitions[i].end_frame_number);
+            timeElement("end_time", transitions[i].end_time);
+            put("</_>");
+        }
+        put("</GradualTransitions>\n");
+    }
+
+protected:
+    void finish(){
+        put("</opencv_storage>\n");
+    }
+
+private:
+    void beginElement(const char *key){
+        put("\n    <");
+        put(key);
+        put('>');
+    }
+    void endElement(const char *key){
+        put("</");
+        put(key);
+        put('>');
+    }
+    void intElement(const char *key, int value){
+        beginElement(key);
+        putInt(value);
+        endElement(key);
+    }
+    void timeElement(const char *key, double time){
+        //times start with a digit, FileStorage quotes them so they are read back as strings
+        beginElement(key);
+        put('"');
+        putTime(time);
+        put('"');
+        endElement(key);
+    }
+    void putString(const string &text){
+        bool quote = text.empty() || isdigit((unsigned char) text[0]) || text[0] == '+' || text[0] == '-' || text[0] == '.';
+        for(size_t i = 0; i < text.size() && !quote; i++){
+            unsigned char c = text[i];
+            quote = c >= 128 || c == ' ' || !isprint(c) || c == '<' || c == '>' || c == '&' || c == '\'' || c == '"';
+        }
+        if(quote)
+            put('"');
+        for(size_t i = 0; i < text.size(); i++){
+            unsigned char c = text[i];
+            if(c == '<')
+                put("&lt;");
+            else if(c == '>')
+                put("&gt;");
+            else if(c == '&')
+                put("&amp;");
+            else if(c == '\'')
+                put("&apos;");
+            else if(c == '"')
+                put("&quot;");
+            else if(c < 0x20 || c == 0x7F){
+                put("&#x");
+                put("0123456789abcdef"[c >> 4]);
+                put("0123456789abcdef"[c & 0xF]);
+                put(';');
+            }else{
+                put((char) c);
+            }
+        }
+        if(quote)
+            put('"');
+    }
+};
+
+/**
+ * @brief The YAMLResultWriter class writes the YAML layout of cv::FileStorage (%YAML:1.0, three spaces
+ * per level), strings are double quoted.
+ */
+class YAMLResultWriter: public ResultWriter
+{
+public:
+    explicit YAMLResultWriter(const string &path): ResultWriter(path), items(0){}
+    ~YAMLResultWriter(){ close(); }
+    void writeHeader(const Header &header){
+        put("%YAML:1.0\nHeader:\n   -");
+        key("video_path");
+        putString(header.video_path);
+        if(header.threshold >= 0){
+            key("threshold");
+            putDouble(header.threshold);
+        }
+        intField("fps", header.fps);
+        intField("frame_count", header.frame_count);
+        put('\n');
+    }
+    void beginShots(){
+        beginList("Shots");
+    }
+    void shotBegin(int frame_number, double time){
+        item();
+        intField("begin_frame_number", frame_number);
+        timeField("begin_time", time);
+    }
+    void shotSample(int frame_number, double time){
+        intField("frame_number", frame_number);
+        timeField("time", time);
+    }
+    void shotEnd(int frame_number, double time){
+        intField("end_frame_number", frame_number);
+        timeField("end_time", time);
+    }
+    void aborted(int frame_number, double time, bool inShot){
+        if(!inShot)
+            item();
+        intField("aborted_frame_number", frame_number);
+        timeField("time", time);
+    }
+    void endShots(){
+        endList();
+    }
+    void writeTransitions(const vector<GradualDetector::Transition> &transitions){
+        beginList("GradualTransitions");
+        for(size_t i = 0; i < transitions.size(); i++){
+            item();
+            intField("begin_frame_number", transitions[i].begin_frame_number);
+            timeField("begin_time", transitions[i].begin_time);
+            intField("end_frame_number", transitions[i].end_frame_number);
+            timeField("end_time", transitions[i].end_time);
+        }
+        endList();
+    }
+
+private:
+    void beginList(const char *name){
+        put(name);
+        put(':');
+        items = 0;
+    }
+    void item(){
+        put("\n   -");
+        items++;
+    }
+    void endList(){
+        put(items ? "\n" : " []\n");
+    }
+    void key(const char *name){
+        put("\n      ");
+        put(name);
+        put(": ");
+    }
+    void intField(const char *name, int value){
+        key(name);
+        putInt(value);
+    }
+    void timeField(const char *name, double time){
+        key(name);
+        put('"');
+        putTime(time);
+        put('"');
+    }
+    void putString(const string &text){
+        put('"');
+        for(size_t i = 0; i < text.size(); i++){
+            unsigned char c = text[i];
+            if(c == '"' || c == '\\'){
+                put('\\');
+                put((char) c);
+            }else if(c < 0x20){
+                put("\\x");
+                put("0123456789abcdef"[c >> 4]);
+                put("0123456789abcdef"[c & 0xF]);
+            }else{
+                put((char) c);
+            }
+        }
+        put('"');
+    }
+
+    int items;                  // items of the current list
+};
+
+/**
+ * @brief The TextResultWriter class writes a line per header field ("fps<TAB>25") and per event
+ * ("shot_begin<TAB>frame_number<TAB>time"), events are named like the ones of the -events stream.
+ * A gradual transition is a "transition" line with its begin and end frame numbers and times.
+ * Tabs, line breaks and backslashes of the video path are written as \t, \n, \r and \\, so it stays one field.
+ */
+class TextResultWriter: public ResultWriter
+{
+public:
+    explicit TextResultWriter(const string &path): ResultWriter(path){}
+    ~TextResultWriter(){ close(); }
+    void writeHeader(const Header &header){
+        put("video_path\t");
+        putField(header.video_path);
+        if(header.threshold >= 0){
+            put("\nthreshold\t");
+            putDouble(header.threshold);
+        }
+        put("\nfps\t");
+        putInt(header.fps);
+        put("\nframe_count\t");
+        putInt(header.frame_count);
+        put('\n');
+    }
+    void beginShots(){
+    }
+    void shotBegin(int frame_number, double time){
+        line("shot_begin", frame_number, time);
+    }
+    void shotSample(int frame_number, double time){
+        line("sample", frame_number, time);
+    }
+    void shotEnd(int frame_number, double time){
+        line("shot_end", frame_number, time);
+    }
+    void aborted(int frame_number, double time, bool inShot){
+        line("aborted", frame_number, time);
+    }
+    void endShots(){
+    }
+    void writeTransitions(const vector<GradualDetector::Transition> &transitions){
+        for(size_t i = 0; i < transitions.size(); i++){
+            put("transition\t");
+            putInt(transitions[i].begin_frame_number);
+            put('\t');
+            putTime(transitions[i].begin_time);
+            put('\t');
+            putInt(transitions[i].end_frame_number);
+            put('\t');
+            putTime(transitions[i].end_time);
+            put('\n');
+        }
+    }
+
+private:
+    void line(const char *event, int frame_number, double time){
+        put(event);
+        put('\t');
+        putInt(frame_number);
+        put('\t');
+        putTime(time);
+        put('\n');
+    }
+    void putField(const string &text){
+        for(size_t i = 0; i < text.size(); i++){
+            char c = text[i];
+            if(c == '\t')
+                put("\\t");
+            else if(c == '\n')
+                put("\\n");
+            else if(c == '\r')
+                put("\\r");
+            else if(c == '\\')
+                put("\\\\");
+            else
+                put(c);
+        }
+    }
+};
+
+/**
+ * @brief The JSONResultWriter class writes {"Header": {...}, "Shots": [...], "GradualTransitions": [...]},
+ * a shot is an object with its begin, its sample frames in a samples array and its end.
+ */
+class JSONResultWriter: public ResultWriter
+{
+public:
+    explicit JSONResultWriter(const string &path): ResultWriter(path), items(0), samples(0){}
+    ~JSONResultWriter(){ close(); }
+    void writeHeader(const Header &header){
+        put("{\n\"Header\": {\"video_path\": ");
+        putString(header.video_path);
+        if(header.threshold >= 0){
+            put(", \"threshold\": ");
+            putDouble(header.threshold);
+        }
+        put(", \"fps\": ");
+        putInt(header.fps);
+        put(", \"frame_count\": ");
+        putInt(header.frame_count);
+        put('}');
+    }
+    void beginShots(){
+        beginList("Shots");
+    }
+    void shotBegin(int frame_number, double time){
+        item();
+        field("begin_frame_number", frame_number, "begin_time", time);
+        samples = 0;
+    }
+    void shotSample(int frame_number, double time){
+        put(samples++ ? ", " : ", \"samples\": [");
+        put('{');
+        field("frame_number", frame_number, "time", time);
+        put('}');
+    }
+    void shotEnd(int frame_number, double time){
+        endSamples();
+        put(", ");
+        field("end_frame_number", frame_number, "end_time", time);
+        put('}');
+    }
+    void aborted(int frame_number, double time, bool inShot){
+        if(inShot){
+            endSamples();
+            put(", ");
+        }else{
+            item();
+        }
+        field("aborted_frame_number", frame_number, "time", time);
+        put('}');
+    }
+    void endShots(){
+        put("\n]");
+    }
+    void writeTransitions(const vector<GradualDetector::Transition> &transitions){
+        beginList("GradualTransitions");
+        for(size_t i = 0; i < transitions.size(); i++){
+            item();
+            field("begin_frame_number", transitions[i].begin_frame_number, "begin_time", transitions[i].begin_time);
+            put(", ");
+            field("end_frame_number", transitions[i].end_frame_number, "end_time", transitions[i].end_time);
+            put('}');
+        }
+        put("\n]");
+    }
+
+protected:
+    void finish(){
+        put("\n}\n");
+    }
+
+private:
+    void beginList(const char *name){
+        put(",\n\"");
+        put(name);
+        put("\": [");
+        items = 0;
+    }
+    void item(){
+        put(items++ ? ",\n{" : "\n{");
+    }
+    void endSamples(){
+        if(samples)
+            put(']');
+        samples = 0;
+    }
+    void field(const char *frameKey, int frame_number, const char *timeKey, double time){
+        put('"');
+        put(frameKey);
+        put("\": ");
+        putInt(frame_number);
+        put(", \"");
+        put(timeKey);
+        put("\": \"");
+        putTime(time);
+        put('"');
+    }
+    void putString(const string &text){
+        put('"');
+        for(size_t i = 0; i < text.size(); i++){
+            unsigned char c = text[i];
+            if(c == '"' || c == '\\'){
+                put('\\');
+                put((char) c);
+            }else if(c < 0x20){
+                put("\\u00");
+                put("0123456789abcdef"[c >> 4]);
+                put("0123456789abcdef"[c & 0xF]);
+            }else{
+                put((char) c);
+            }
+        }
+        put('"');
+    }
+
+    int items;                  // items of the current list
+    int samples;                // samples of the current shot
+};
+
+/**
+ * @brief The BinaryResultWriter class writes a BinaryHeader, the video path and a BinaryRecord per event,
+ * a gradual transition is a TRANSITION_BEGIN and a TRANSITION_END record.
+ */
+class BinaryResultWriter: public ResultWriter
+{
+public:
+    explicit BinaryResultWriter(const string &path): ResultWriter(path){}
+    ~BinaryResultWriter(){ close(); }
+    void writeHeader(const Header &header){
+        BinaryHeader written;
+        memset(&written, 0, sizeof(BinaryHeader));
+        memcpy(written.magic, RESULT_MAGIC, sizeof(RESULT_MAGIC));
+        written.version = VERSION;
+        written.byte_order = 0x01020304;
+        written.header_size = sizeof(BinaryHeader);
+        written.record_size = sizeof(BinaryRecord);
+        written.fps = header.fps;
+        written.frame_count = header.frame_count;
+        written.threshold = header.threshold;
+        written.path_length = (uint32_t) header.video_path.size();
+        put((const char*) &written, sizeof(BinaryHeader));
+        put(header.video_path.data(), header.video_path.size());
+    }
+    void beginShots(){
+    }
+    void shotBegin(int frame_number, double time){
+        record(SHOT_BEGIN, frame_number, time);
+    }
+    void shotSample(int frame_number, double time){
+        record(SHOT_SAMPLE, frame_number, time);
+    }
+    void shotEnd(int frame_number, double time){
+        record(SHOT_END, frame_number, time);
+    }
+    void aborted(int frame_number, double time, bool inShot){
+        record(ABORTED, frame_number, time);
+    }
+    void endShots(){
+    }
+    void writeTransitions(const vector<GradualDetector::Transition> &transitions){
+        for(size_t i = 0; i < transitions.size(); i++){
+            record(TRANSITION_BEGIN, transitions[i].begin_frame_number, transitions[i].begin_time);
+            record(TRANSITION_END, transitions[i].end_frame_number, transitions[i].end_time);
+        }
+    }
+
+private:
+    void record(RecordKind kind, int frame_number, double time){
+        BinaryRecord written;
+        written.kind = kind;
+        written.frame_number = frame_number;
+        written.time = time;
+        put((const char*) &written, sizeof(BinaryRecord));
+    }
+};
+
+}
+
+ResultWriter::Header::Header(): fps(0), frame_count(0), threshold(-1)
+{
+}
+
+/**
+ * @brief ResultWriter::ResultWriter: Opens the result file for writing, see isOpened.
+ */
+ResultWriter::ResultWriter(const std::string &path): file(fopen(path.c_str(), "wb")), buffer(RESULT_BUFFER_SIZE),
+    used(0), written(0)
+{
+}
+
+ResultWriter::~ResultWriter(){
+    if(file)
+        fclose(file);
+}
+
+/**
+ * @brief ResultWriter::create: Creates the writer of the given format, which writes to path
+ * (see extension for the usual extension of each format).
+ */
+ResultWriter* ResultWriter::create(Format format, const std::string &path){
+    switch(format){
+    case YAML:
+        return new YAMLResultWriter(path);
+    case TEXT:
+        return new TextResultWriter(path);
+    case JSON:
+        return new JSONResultWriter(path);
+    case BINARY:
+        return new BinaryResultWriter(path);
+    case XML:
+    default:
+        return new XMLResultWriter(path);
+    }
+}
+
+/**
+ * @brief ResultWriter::extension: Extension of result files of the given format, with the dot.
+ */
+const char* ResultWriter::extension(Format format){
+    switch(format){
+    case YAML:
+        return ".yml";
+    case TEXT:
+        return ".txt";
+    case JSON:
+        return ".json";
+    case BINARY:
+        return ".bin";
+    case XML:
+    default:
+        return ".xml";
+    }
+}
+
+/**
+ * @brief ResultWriter::createDirectories: Creates the directory path and its missing parents, like mkdir -p.
+ * @return: true if path is a directory afterwards
+ */
+bool ResultWriter::createDirectories(const std::string &path){
+    for(size_t i = 1; i <= path.size(); i++){
+        bool separator = i == path.size() || path[i] == '/';
+#ifdef _WIN32
+        separator = separator || path[i] == '\\';
+        //drive letters are not created
+        if(separator && path[i - 1] == ':')
+            continue;
+#endif
+        if(!separator || path[i - 1] == '/' || path[i - 1] == '\\')
+            continue;
+        string parent = path.substr(0, i);
+#ifdef _WIN32
+        int created = _mkdir(parent.c_str());
+#else
+        int created = mkdir(parent.c_str(), 0777);
+#endif
+        if(created != 0 && errno != EEXIST)
+            return false;
+    }
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFMT) == S_IFDIR;
+}
+
+/**
+ * @brief ResultWriter::formatTime: Writes a time interval in D:H:M:S format, the format of
+ * ShotDetector::miliseconds_to_DHMS, to buffer without allocating.
+ * @param buffer: at least RESULT_TIME_LENGTH characters, terminated with zero
+ * @return: length of the written time
+ */
+int ResultWriter::formatTime(double miliseconds, char *buffer){
+    unsigned int timestamp_as_seconds = miliseconds / 1000;
+    unsigned int fields[4];
+    fields[3] = timestamp_as_seconds % 60;
+    timestamp_as_seconds /= 60;
+    fields[2] = timestamp_as_seconds % 60;
+    timestamp_as_seconds /= 60;
+    fields[1] = timestamp_as_seconds % 24;
+    fields[0] = timestamp_as_seconds / 24;
+    int first = fields[0] ? 0 : (fields[1] ? 1 : 2);
+    char *out = buffer;
+    if(first == 0){
+        char digits[12];
+        int n = 0;
+        do{
+            digits[n++] = '0' + fields[0] % 10;
+            fields[0] /= 10;
+        }while(fields[0]);
+        while(n)
+            *out++ = digits[--n];
+        *out++ = 'd';
+        *out++ = ':';
+        first = 1;
+    }
+    for(int k = first; k < 4; k++){
+        *out++ = '0' + fields[k] / 10;
+        *out++ = '0' + fields[k] % 10;
+        if(k < 3)
+            *out++ = ':';
+    }
+    *out = 0;
+    return (int) (out - buffer);
+}
+
+bool ResultWriter::isOpened() const{
+    return file != 0;
+}
+
+/**
+ * @brief ResultWriter::close: Completes and closes the result file, later writes are ignored.
+ * @return: bytes written to the file
+ */
+int64 ResultWriter::close(){
+    if(!file)
+        return written;
+    finish();
+    flush();
+    fclose(file);
+    file = 0;
+    return written;
+}
+
+/**
+ * @brief ResultWriter::finish: Writes what follows the last list of the format, called by close.
+ */
+void ResultWriter::finish(){
+}
+
+void ResultWriter::put(char c){
+    if(used == buffer.size())
+        flush();
+    buffer[used++] = c;
+}
+
+void ResultWriter::put(const char *text){
+    put(text, strlen(text));
+}
+
+void ResultWriter::put(const char *data, size_t size){
+    if(used + size > buffer.size()){
+        flush();
+        if(size > buffer.size()){
+            if(file)
+                written += fwrite(data, 1, size, file);
+            return;
+        }
+    }
+    memcpy(&buffer[used], data, size);
+    used += size;
+}
+
+void ResultWriter::putInt(int64 value){
+    char digits[24];
+    int n = 0;
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t) value : (uint64_t) value;
+    do{
+        digits[sizeof(digits) - 1 - n++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    }while(magnitude);
+    if(value < 0)
+        digits[sizeof(digits) - 1 - n++] = '-';
+    put(digits + sizeof(digits) - n, n);
+}
+
+/**
+ * @brief ResultWriter::putDouble: Writes a value with the fewest digits (up to 17) which read back exactly.
+ */
+void ResultWriter::putDouble(double value){
+    char digits[32];
+    int n = snprintf(digits, sizeof(digits), "%.15g", value);
+    if(strtod(digits, 0) != value)
+        n = snprintf(digits, sizeof(digits), "%.17g", value);
+    put(digits, n);
+}
+
+void ResultWriter::putTime(double miliseconds){
+    char time[RESULT_TIME_LENGTH];
+    put(time, formatTime(miliseconds, time));
+}
+
+/**
+ * @brief ResultWriter::flush: Writes the buffered bytes to the file.
+ */
+void ResultWriter::flush(){
+    if(file && used)
+        written += fwrite(&buffer[0], 1, used, file);
+    used = 0;
+}
@@ -0,0 +1,116 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#ifndef RESULTWRITER_H
+#define RESULTWRITER_H
+#include <opencv2/core/core.hpp>
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "gradualdetector.h"
+
+//bytes collected before they are written to the result file
+#define RESULT_BUFFER_SIZE (64 * 1024)
+//longest D:H:M:S time written by formatTime, with the terminating zero
+#define RESULT_TIME_LENGTH 24
+
+/**
+ * @brief The ResultWriter class is the output sink of the detection: it writes the header, the shots with their
+ * sample frames and the gradual transitions of a video to a result file as they are decided. Subclasses emit
+ * one format each and are created by create():
+ *
+ *  XML, YAML: the layout cv::FileStorage wrote before (Header and Shots lists, a map per shot), readable by it
+ *  TEXT:      one tab separated line per header field and per event, events named like the -events stream
+ *  JSON:      a Header object and a Shots array, the samples of a shot in its samples array
+ *  BINARY:    a BinaryHeader and the video path, followed by a BinaryRecord per event
+ *
+ * Writers format numbers and times into a buffer of RESULT_BUFFER_SIZE bytes which is written to the file
+ * when it is full, so writing an event allocates nothing.
+ */
+class ResultWriter
+{
+public:
+    enum Format {XML, YAML, TEXT, JSON, BINARY};
+    struct Header
+    {
+        Header();
+        std::string video_path;
+        int fps;
+        int frame_count;
+        double threshold;           // written if not negative
+    };
+    /** events of BinaryRecord, shot events have the values of ShotDetector::ShotEvent **/
+    enum RecordKind {SHOT_BEGIN = 1, SHOT_END = 2, SHOT_SAMPLE = 3, ABORTED = 4, TRANSITION_BEGIN = 5, TRANSITION_END = 6};
+    /** header of BINARY files (little endian), followed by path_length bytes of the video path **/
+    struct BinaryHeader
+    {
+        char magic[8];              // "SHOTRES"
+        uint32_t version;
+        uint32_t byte_order;        // 0x01020304 as written by the host
+        uint32_t header_size;
+        uint32_t record_size;
+        int32_t fps;
+        int32_t frame_count;
+        double threshold;           // negative if not set
+        uint32_t path_length;
+        uint32_t reserved;
+    };
+    struct BinaryRecord
+    {
+        int32_t kind;               // RecordKind
+        int32_t frame_number;
+        double time;                // miliseconds
+    };
+
+    static ResultWriter* create(Format format, const std::string &path);
+    static const char* extension(Format format);
+    static bool createDirectories(const std::string &path);
+    static int formatTime(double miliseconds, char *buffer);
+    virtual ~ResultWriter();
+    bool isOpened() const;
+    int64 close();
+
+    virtual void writeHeader(const Header &header) = 0;
+    virtual void beginShots() = 0;
+    virtual void shotBegin(int frame_number, double time) = 0;
+    virtual void shotSample(int frame_number, double time) = 0;
+    virtual void shotEnd(int frame_number, double time) = 0;
+    /** the run was stopped at the given frame, inShot if the current shot has not ended **/
+    virtual void aborted(int frame_number, double time, bool inShot) = 0;
+    virtual void endShots() = 0;
+    virtual void writeTransitions(const std::vector<GradualDetector::Transition> &transitions) = 0;
+
+protected:
+    explicit ResultWriter(const std::string &path);
+    virtual void finish();
+    void put(char c);
+    void put(const char *text);
+    void put(const char *data, size_t size);
+    void putInt(int64 value);
+    void putDouble(double value);
+    void putTime(double miliseconds);
+
+private:
+    ResultWriter(const ResultWriter&);
+    ResultWriter& operator=(const ResultWriter&);
+    void flush();
+
+    FILE *file;
+    std::vector<char> buffer;
+    size_t used;
+    int64 written;
+};
+
+#endif // RESULTWRITER_H
@@ -0,0 +1,232 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#include "runmetrics.h"
+#include "sidecarfile.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sys/stat.h>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+const double latency_bounds_us[METRICS_LATENCY_BUCKETS] = {10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 50000, 250000};
+const char* stage_names[RunMetrics::STAGE_COUNT] = {"decode", "histogram", "compare", "encode", "storage"};
+const char* counter_names[RunMetrics::COUNTER_COUNT] = {"frames_decoded", "boundaries", "keyframes_written", "bytes_written"};
+
+}
+
+RunMetrics::RunMetrics(): exportStopping(false), exportFormat(JSON), exportPeriod(0)
+{
+    reset();
+}
+
+RunMetrics::~RunMetrics()
+{
+    stopExport();
+}
+
+/**
+ * @brief RunMetrics::reset: Sets every counter to zero and restarts the run time.
+ */
+void RunMetrics::reset(){
+    for(int s = 0; s < STAGE_COUNT; s++){
+        stages[s].calls = 0;
+        stages[s].ticks = 0;
+        for(int b = 0; b <= METRICS_LATENCY_BUCKETS; b++)
+            stages[s].buckets[b] = 0;
+    }
+    for(int c = 0; c < COUNTER_COUNT; c++)
+        counters[c] = 0;
+    start_t = getTickCount();
+}
+
+/**
+ * @brief RunMetrics::record: Adds a call of the stage which took the given number of ticks (see cv::getTickCount).
+ */
+void RunMetrics::record(Stage stage, int64 ticks){
+    StageCounters &counters = stages[stage];
+    counters.calls.fetch_add(1, std::memory_order_relaxed);
+    counters.ticks.fetch_add(ticks, std::memory_order_relaxed);
+    double us = 1e6 * ticks / getTickFrequency();
+    int bucket = 0;
+    while(bucket < METRICS_LATENCY_BUCKETS && us > latency_bounds_us[bucket])
+        bucket++;
+    counters.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void RunMetrics::add(Counter counter, int64 value){
+    counters[counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+int64 RunMetrics::count(Counter counter) const{
+    return counters[counter].load(std::memory_order_relaxed);
+}
+
+double RunMetrics::seconds(Stage stage) const{
+    return stages[stage].ticks.load(std::memory_order_relaxed) / getTickFrequency();
+}
+
+int64 RunMetrics::calls(Stage stage) const{
+    return stages[stage].calls.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief RunMetrics::write: Writes the current values in the given format.
+ */
+void RunMetrics::write(std::ostream &out, ExportFormat format) const{
+    if(format == PROMETHEUS)
+        writePrometheus(out);
+    else
+        writeJSON(out);
+}
+
+/**
+ * @brief RunMetrics::writeJSON:
+ * {"elapsed_seconds":..,"counters":{"frames_decoded":..,...},"stages":{"decode":{"calls":..,"seconds":..,
+ * "latency_us":{"le":[10,...],"counts":[..]}},...}}
+ * counts has one more entry than le, the calls slower than the last bound.
+ */
+void RunMetrics::writeJSON(std::ostream &out) const{
+    out << "{\"elapsed_seconds\":" << (getTickCount() - start_t) / getTickFrequency() << ",\"counters\":{";
+    for(int c = 0; c < COUNTER_COUNT; c++)
+        out << (c ? "," : "") << "\"" << counter_names[c] << "\":" << count((Counter) c);
+    out << "},\"stages\":{";
+    for(int s = 0; s < STAGE_COUNT; s++){
+        out << (s ? "," : "") << "\"" << stage_names[s] << "\":{\"calls\":" << calls((Stage) s)
+            << ",\"seconds\":" << seconds((Stage) s) << ",\"latency_us\":{\"le\":[";
+        for(int b = 0; b < METRICS_LATENCY_BUCKETS; b++)
+            out << (b ? "," : "") << latency_bounds_us[b];
+        out << "],\"counts\":[";
+        for(int b = 0; b <= METRICS_LATENCY_BUCKETS; b++)
+            out << (b ? "," : "") << stages[s].buckets[b].load(std::memory_order_relaxed);
+        out << "]}}";
+    }
+    out << "}}" << endl;
+}
+
+/**
+ * @brief RunMetrics::writePrometheus: Writes the counters and a shotdetection_stage_seconds histogram
+ * labeled by stage in the Prometheus text exposition format.
+ */
+void RunMetrics::writePrometheus(std::ostream &out) const{
+    out << "# HELP shotdetection_elapsed_seconds Time since the start of the run.\n"
+        << "# TYPE shotdetection_elapsed_seconds gauge\n"
+        << "shotdetection_elapsed_seconds " << (getTickCount() - start_t) / getTickFrequency() << "\n";
+    for(int c = 0; c < COUNTER_COUNT; c++){
+        out << "# TYPE shotdetection_" << counter_names[c] << "_total counter\n"
+            << "shotdetection_" << counter_names[c] << "_total " << count((Counter) c) << "\n";
+    }
+    out << "# HELP shotdetection_stage_seconds Time per call of a stage of the detector.\n"
+        << "# TYPE shotdetection_stage_seconds histogram\n";
+    for(int s = 0; s < STAGE_COUNT; s++){
+        int64 cumulative = 0;
+        for(int b = 0; b <= METRICS_LATENCY_BUCKETS; b++){
+            cumulative += stages[s].buckets[b].load(std::memory_order_relaxed);
+            out << "shotdetection_stage_seconds_bucket{stage=\"" << stage_names[s] << "\",le=\"";
+            if(b < METRICS_LATENCY_BUCKETS)
+                out << latency_bounds_us[b] * 1e-6;
+            else
+                out << "+Inf";
+            out << "\"} " << cumulative << "\n";
+        }
+        out << "shotdetection_stage_seconds_sum{stage=\"" << stage_names[s] << "\"} " << seconds((Stage) s) << "\n"
+            << "shotdetection_stage_seconds_count{stage=\"" << stage_names[s] << "\"} " << cumulative << "\n";
+    }
+    out.flush();
+}
+
+/**
+ * @brief RunMetrics::exportFile: Writes the metrics to path.tmp and renames it to path, so a scraper
+ * never reads a partially written file.
+ */
+bool RunMetrics::exportFile(const std::string &path, ExportFormat format) const{
+    string tmpPath = path + ".tmp";
+    {
+        ofstream file(tmpPath.c_str());
+        if(!file.is_open()){
+            cout << "error openning " << tmpPath << endl;
+            return false;
+        }
+        write(file, format);
+        file.close();
+        if(!file.good()){
+            cout << "error writing " << tmpPath << endl;
+            remove(tmpPath.c_str());
+            return false;
+        }
+    }
+    if(!SidecarFile::replace(tmpPath, path)){
+        cout << "error writing " << path << endl;
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief RunMetrics::startExport: Exports the metrics to path every period seconds on a separate thread
+ * until stopExport is called.
+ */
+void RunMetrics::startExport(const std::string &path, ExportFormat format, double period){
+    stopExport();
+    exportPath = path;
+    exportFormat = format;
+    exportPeriod = period;
+    exportStopping = false;
+    exporter = std::thread(&RunMetrics::exportLoop, this);
+}
+
+/**
+ * @brief RunMetrics::stopExport: Stops the periodic export. The caller exports the final values.
+ */
+void RunMetrics::stopExport(){
+    if(!exporter.joinable())
+        return;
+    {
+        lock_guard<mutex> lock(exportMutex);
+        exportStopping = true;
+    }
+    exportWake.notify_all();
+    exporter.join();
+}
+
+void RunMetrics::exportLoop(){
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+    unique_lock<mutex> lock(exportMutex);
+    while(1){
+        next += std::chrono::microseconds((int64) (1e6 * exportPeriod));
+        if(exportWake.wait_until(lock, next, [this]{ return exportStopping; }))
+            return;
+        exportFile(exportPath, exportFormat);
+    }
+}
+
+/**
+ * @brief RunMetrics::formatOf: PROMETHEUS for files ending with .prom (as read by the node exporter
+ * textfile collector), JSON otherwise.
+ */
+RunMetrics::ExportFormat RunMetrics::formatOf(const std::string &path){
+    return path.size() > 5 && path.compare(path.size() - 5, 5, ".prom") == 0 ? PROMETHEUS : JSON;
+}
+
+int64 RunMetrics::fileSize(const std::string &path){
+    struct stat st;
+    if(stat(path.c_str(), &st) != 0)
+        return 0;
+    return (int64) st.st_size;
+}
@@ -0,0 +1,96 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#ifndef RUNMETRICS_H
+#define RUNMETRICS_H
+#include <opencv2/core/core.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+//upper bounds of the stage latency buckets in microseconds, the last bucket has no bound
+#define METRICS_LATENCY_BUCKETS 12
+
+/**
+ * @brief The RunMetrics class counts what the detector does during a run: time and calls of each stage
+ * with a histogram of the time per call (a call is a frame for decoding, histograms and comparison,
+ * a keyframe for encoding and an event for the result file), and totals of frames decoded, boundaries,
+ * keyframes and bytes written. Counters are atomic, stages running on several threads (keyframe writers,
+ * segment workers) add to them without locking. They can be exported as JSON or in the Prometheus text format,
+ * at the end of a run and every few seconds while it runs.
+ *
+ * Detectors without metrics pass a null pointer to start() and stop(), which then only test the pointer.
+ */
+class RunMetrics
+{
+public:
+    enum Stage {DECODE, HISTOGRAM, COMPARE, ENCODE, STORAGE, STAGE_COUNT};
+    enum Counter {FRAMES_DECODED, BOUNDARIES, KEYFRAMES_WRITTEN, BYTES_WRITTEN, COUNTER_COUNT};
+    enum ExportFormat {JSON, PROMETHEUS};
+
+    RunMetrics();
+    ~RunMetrics();
+    void reset();
+    void record(Stage stage, int64 ticks);
+    void add(Counter counter, int64 value);
+    int64 count(Counter counter) const;
+    double seconds(Stage stage) const;
+    int64 calls(Stage stage) const;
+    void write(std::ostream &out, ExportFormat format) const;
+    bool exportFile(const std::string &path, ExportFormat format) const;
+    void startExport(const std::string &path, ExportFormat format, double period);
+    void stopExport();
+    static ExportFormat formatOf(const std::string &path);
+    static int64 fileSize(const std::string &path);
+
+    /** start time of a stage, 0 if metrics is null **/
+    static inline int64 start(const RunMetrics *metrics){
+        return metrics ? cv::getTickCount() : 0;
+    }
+    /** records the time since start_t for the stage, nothing if metrics is null **/
+    static inline void stop(RunMetrics *metrics, Stage stage, int64 start_t){
+        if(metrics)
+            metrics->record(stage, cv::getTickCount() - start_t);
+    }
+
+private:
+    RunMetrics(const RunMetrics&);
+    RunMetrics& operator=(const RunMetrics&);
+    void writeJSON(std::ostream &out) const;
+    void writePrometheus(std::ostream &out) const;
+    void exportLoop();
+
+    struct StageCounters
+    {
+        std::atomic<int64> calls;
+        std::atomic<int64> ticks;
+        std::atomic<int64> buckets[METRICS_LATENCY_BUCKETS + 1];
+    };
+    StageCounters stages[STAGE_COUNT];
+    std::atomic<int64> counters[COUNTER_COUNT];
+    int64 start_t;
+    //periodic export
+    std::thread exporter;
+    std::mutex exportMutex;
+    std::condition_variable exportWake;
+    bool exportStopping;
+    std::string exportPath;
+    ExportFormat exportFormat;
+    double exportPeriod;
+};
+
+#endif // RUNMETRICS_H
@@ -0,0 +1,215 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#include "seekindex.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace cv;
+using namespace std;
+
+#define SEEK_INDEX_MAGIC "SHOTIDX"
+#define SEEK_INDEX_BYTE_ORDER 0x01020304u
+
+SeekIndex::SeekIndex(): data(0), output(0)
+{
+}
+
+SeekIndex::~SeekIndex()
+{
+    close();
+}
+
+/**
+ * @brief SeekIndex::open: Maps the index file for reading and checks its header.
+ * @return: false if the file does not exist, is truncated or was written by another version or byte order
+ */
+bool SeekIndex::open(const std::string &path){
+    close();
+    if(!file.map(path, sizeof(Header)))
+        return false;
+    data = file.data();
+
+    const Header &h = header();
+    bool valid = memcmp(h.magic, SEEK_INDEX_MAGIC, sizeof(SEEK_INDEX_MAGIC)) == 0 && h.version == VERSION
+            && h.byte_order == SEEK_INDEX_BYTE_ORDER && h.header_size == sizeof(Header)
+            && h.record_size == sizeof(Record) && h.frame_count > 0
+            && file.size() >= sizeof(Header) + (size_t) h.frame_count * h.record_size;
+    if(!valid)
+        close();
+    return valid;
+}
+
+/**
+ * @brief SeekIndex::matches: Returns true if the open index was written for the video as it is now
+ * (same size and modification time).
+ */
+bool SeekIndex::matches(const std::string &videoPath) const{
+    int64_t size, mtime;
+    if(!data || !SidecarFile::videoStat(videoPath, size, mtime))
+        return false;
+    return header().video_size == size && header().video_mtime == mtime;
+}
+
+/**
+ * @brief SeekIndex::close: Unmaps the file opened for reading.
+ */
+void SeekIndex::close(){
+    file.unmap();
+    data = 0;
+}
+
+const SeekIndex::Header& SeekIndex::header() const{
+    return *(const Header*) data;
+}
+
+int SeekIndex::frameCount() const{
+    return data ? header().frame_count : 0;
+}
+
+const SeekIndex::Record& SeekIndex::record(int index) const{
+    return *(const Record*) (data + sizeof(Header) + (size_t) index * sizeof(Record));
+}
+
+/**
+ * @brief SeekIndex::findTime: Returns the index of the frame with the given time, or -1 if no frame is
+ * within a quarter frame of it.
+ */
+int SeekIndex::findTime(double time) const{
+    int lo = 0, hi = frameCount();
+    while(lo < hi){
+        int mid = lo + (hi - lo) / 2;
+        if(record(mid).time < time)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    int nearest = -1;
+    double distance = 0;
+    for(int i = std::max(lo - 1, 0); i <= lo && i < frameCount(); i++){
+        double d = fabs(record(i).time - time);
+        if(nearest < 0 || d < distance){
+            nearest = i;
+            distance = d;
+        }
+    }
+    double tolerance = header().fps > 0 ? 250. / header().fps : 0.5;
+    return nearest >= 0 && distance <= tolerance ? nearest : -1;
+}
+
+/**
+ * @brief SeekIndex::keyframeIndex: Returns the index of the nearest keyframe at or before the frame with the given index.
+ */
+int SeekIndex::keyframeIndex(int index) const{
+    int key = index - (record(index).frame_number - record(index).keyframe_number);
+    return std::min(std::max(key, 0), index);
+}
+
+/**
+ * @brief SeekIndex::seek: Grabs the frame with the given index, so that it can be retrieved. The capture
+ * decodes forward to it if it is between the keyframe of the frame and the frame, otherwise it seeks to the
+ * keyframe. A seek which lands after the frame (or fails) is repeated from the keyframe before.
+ * @param index: 0 based index of the frame, below frameCount()
+ * @param position: index of the frame the capture decodes next, index + 1 on return
+ * @param decoded: frames grabbed, the requested one included
+ * @return: false if the frame is not in the index or cannot be reached
+ */
+bool SeekIndex::seek(cv::VideoCapture &cap, int index, int &position, int &decoded) const{
+    decoded = 0;
+    if(index < 0 || index >= frameCount())
+        return false;
+    int start = keyframeIndex(index);
+    if(position < start || position > index){
+        while(1){
+            cap.set(CV_CAP_PROP_POS_FRAMES, start);
+            if(cap.grab()){
+                decoded++;
+                int landed = findTime(cap.get(CV_CAP_PROP_POS_MSEC));
+                if(landed < 0)
+                    landed = (int) cap.get(CV_CAP_PROP_POS_FRAMES) - 1;
+                if(landed <= index){
+                    position = landed + 1;
+                    break;
+                }
+            }
+            //landed after the frame or at the end of the video
+            if(start == 0)
+                return false;
+            start = keyframeIndex(start - 1);
+        }
+    }
+    while(position <= index){
+        if(!cap.grab())
+            return false;
+        position++;
+        decoded++;
+    }
+    return true;
+}
+
+/**
+ * @brief SeekIndex::create: Starts writing an index. Records are written to path.tmp, which replaces
+ * path when finish() succeeds, so an interrupted run never leaves an index which looks complete.
+ * @param path: index file
+ * @param videoPath: video the index belongs to
+ * @param keyframe_interval: frames from one keyframe of the video to the next, 0 if not known
+ */
+bool SeekIndex::create(const std::string &path, const std::string &videoPath, int keyframe_interval){
+    output = file.create(path);
+    if(!output)
+        return false;
+    memset(&written, 0, sizeof(Header));
+    written.keyframe_interval = std::max(keyframe_interval, 0);
+    SidecarFile::videoStat(videoPath, written.video_size, written.video_mtime);
+    //the header is written by finish()
+    fwrite(&written, sizeof(Header), 1, output);
+    return true;
+}
+
+/**
+ * @brief SeekIndex::append: Writes the record of the next frame.
+ * @param frame_number: frame number of the backend after reading the frame (1 for the first frame)
+ * @param time: CV_CAP_PROP_POS_MSEC after reading the frame
+ */
+void SeekIndex::append(int frame_number, double time){
+    if(!output)
+        return;
+    Record record;
+    record.frame_number = frame_number;
+    int interval = written.keyframe_interval;
+    record.keyframe_number = interval > 0 ? (frame_number - 1) / interval * interval + 1 : frame_number;
+    record.time = time;
+    fwrite(&record, sizeof(Record), 1, output);
+    written.frame_count++;
+}
+
+/**
+ * @brief SeekIndex::finish: Completes the header and moves the index in place.
+ * @param fps: frame rate reported by the backend
+ */
+bool SeekIndex::finish(double fps){
+    if(!output)
+        return false;
+    memcpy(written.magic, SEEK_INDEX_MAGIC, sizeof(SEEK_INDEX_MAGIC));
+    written.version = VERSION;
+    written.byte_order = SEEK_INDEX_BYTE_ORDER;
+    written.header_size = sizeof(Header);
+    written.record_size = sizeof(Record);
+    written.fps = fps;
+    fseek(output, 0, SEEK_SET);
+    fwrite(&written, sizeof(Header), 1, output);
+    output = 0;
+    return file.commit();
+}
@@ -0,0 +1,92 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#ifndef SEEKINDEX_H
+#define SEEKINDEX_H
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "sidecarfile.h"
+
+/**
+ * @brief The SeekIndex class reads and writes the seek index sidecar of a video, written by processVideo_NoGUI
+ * while it decodes every frame anyway: frame number, time (CV_CAP_PROP_POS_MSEC) and nearest preceding keyframe
+ * of every frame. seek() uses it to position a capture exactly on a frame, decoding as few frames as possible:
+ * it seeks to the keyframe of the frame and decodes forward from there, or only decodes forward when the
+ * capture is already between them. Where a seek lands is checked against the recorded times, so backends
+ * whose seeks are inexact (e.g. on variable frame rate videos) still return the requested frame.
+ *
+ * OpenCV does not report which frames are keyframes, the keyframe interval the video was encoded with
+ * (keyframe_interval, e.g. -g of ffmpeg) is given by the caller. Without it every frame is its own keyframe
+ * in the index, seeks go to the frame and the backend decodes from its keyframe.
+ *
+ * File layout (little endian): a Header, then frame_count Records. Files are memory mapped for reading
+ * where the platform supports it.
+ */
+class SeekIndex
+{
+public:
+    struct Header
+    {
+        char magic[8];              // "SHOTIDX"
+        uint32_t version;
+        uint32_t byte_order;        // 0x01020304 as written by the host
+        uint32_t header_size;
+        uint32_t record_size;
+        int32_t frame_count;        // number of records
+        int32_t keyframe_interval;  // 0 if keyframes are not known
+        double fps;
+        int64_t video_size;         // size and modification time of the video the index belongs to
+        int64_t video_mtime;
+    };
+    struct Record
+    {
+        int32_t frame_number;       // as in the result file, the n'th frame has frame number n
+        int32_t keyframe_number;    // frame number of the nearest keyframe at or before the frame
+        double time;                // miliseconds
+    };
+
+    SeekIndex();
+    ~SeekIndex();
+    bool open(const std::string &path);
+    bool matches(const std::string &videoPath) const;
+    void close();
+    const Header& header() const;
+    int frameCount() const;
+    const Record& record(int index) const;
+    int findTime(double time) const;
+    int keyframeIndex(int index) const;
+    bool seek(cv::VideoCapture &cap, int index, int &position, int &decoded) const;
+
+    bool create(const std::string &path, const std::string &videoPath, int keyframe_interval);
+    void append(int frame_number, double time);
+    bool finish(double fps);
+
+    static const uint32_t VERSION = 1;
+
+private:
+    SeekIndex(const SeekIndex&);
+    SeekIndex& operator=(const SeekIndex&);
+
+    SidecarFile file;
+    //reading
+    const uchar *data;              // mapped file, 0 if none is open
+    //writing
+    FILE *output;
+    Header written;
+};
+
+#endif // SEEKINDEX_H
@@ -13,7 +13,18 @@
 *******************************************************************************/
 
 #include "shotdetector.h"
+#include "shotstream.h"
+#include "spscqueue.h"
+#include "rawframesource.h"
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+
+//number of frames buffered between two stages of processVideo_Pipelined
+#define PIPELINE_QUEUE_SIZE 8
 
 using namespace cv;
 using namespace std;
@@ -23,17 +34,78 @@ using namespace std;
  * @param filename: Video filename or full path
  * @param threshold: Threshold value for shot detection.
  */
-ShotDetector::ShotDetector(std::string filename, double threshold): sample_period(0)
+ShotDetector::ShotDetector(std::string filename, double threshold):
+    ShotDetector(filename, threshold, 0, SAMPLE_ALL, 1)
 {
-    this->videoPath = filename;
-    this->threshold = threshold;
 }
-
-ShotDetector::ShotDetector(std::string filename, double threshold, int sample_period)
+ShotDetector::ShotDetector(std::string filename, double threshold, int sample_period):
+    ShotDetector(filename, threshold, sample_period, SAMPLE_ALL, 1)
+{
+}
+ShotDetector::ShotDetector(std::string filename, double threshold, int sample_period, SamplingMode sampling,
+                           int sampling_factor): yuvNative(false), yuvThreshold(threshold), processedFrames(0),
+    bufferReallocations(0), retrievedFrames(0), bisectedIntervals(0), keyframeWriter(0), eventStream(0),
+    signatureCache(0), metrics(0), gradualWindow(0), adaptiveWindow(0), adaptiveSigmas(ADAPTIVE_DEFAULT_SIGMAS),
+    seekKeyframeInterval(0), checkpointPeriod(DEFAULT_CHECKPOINT_PERIOD), resumeRun(false), tileGrid(0), tileIgnored(0)
 {
     this->videoPath = filename;
     this->threshold = threshold;
     this->sample_period = sample_period;
+    this->sampling = sampling_factor > 1 ? sampling : SAMPLE_ALL;
+    this->sampling_factor = sampling_factor > 1 ? sampling_factor : 1;
+}
+
+ShotDetector::CheckpointStats::CheckpointStats(): written(0), seconds(0), bytes(0), resumed_frames(0)
+{
+}
+
+/**
+ * @brief ShotDetector::ShotState::ShotState: Initial state of the detection loop,
+ * the start of the first shot is already stored.
+ * @param sample_period: sample period of stored frames (0 disables sampling)
+ */
+ShotDetector::ShotState::ShotState(int sample_period): shotFoundAtPrev(false), shotStartStored(true),
+    frameCounter(0), sample_period(sample_period)
+{
+}
+
+/**
+ * @brief ShotDetector::ShotState::update: Advances the state by one frame.
+ * Beginning, end and sample events exclude each other, so at most one event is produced per frame.
+ * @param boundary: boundary decision of the current frame
+ * @return: Returns the event that must be stored for the current frame
+ */
+ShotDetector::ShotEvent ShotDetector::ShotState::update(bool boundary){
+    ShotEvent event = NO_EVENT;
+    if(shotFoundAtPrev && !shotStartStored)
+    {
+        event = SHOT_BEGIN;
+        shotStartStored = true;
+        //shot is already saved, so clear frame counter
+        frameCounter = 0;
+    }
+    if(boundary)
+    {
+        if(!shotFoundAtPrev)
+        {
+            event = SHOT_END;
+            shotStartStored = false;
+            frameCounter = 0;
+        }
+        shotFoundAtPrev = true;
+    }
+    else
+    {
+        shotFoundAtPrev = false;
+    }
+
+    if(sample_period != 0 && frameCounter == sample_period){
+        event = SHOT_SAMPLE;
+        //clear frame counter
+        frameCounter = 0;
+    }
+    frameCounter++;
+    return event;
 }
 
 bool ShotDetector::shotBoundaryDetect(cv::Mat &prevFrame, cv::Mat& currntFrame, int threshold ){
@@ -54,22 +126,14 @@ bool ShotDetector::shotBoundaryDetect(cv::Mat &prevFrame, cv::Mat& currntFrame,
     }
     **/
 
-    int channels[] = {0, 1, 2};
     MatND prevHist, currHist;
     //histogram size (bins) for r,g,b channels equal to 32.
-    int histSize[] = {32, 32, 32};
-    // color ranges for rgb channels are between (0, 256)
-    float color_ranges[] = { 0, 256 };
-    const float* ranges[] = { color_ranges, color_ranges, color_ranges };
-    calcHist(&prevFrame, 1, channels, Mat(), prevHist, 3, histSize, ranges, true, false);
-    calcHist(&currntFrame, 1, channels, Mat(), currHist, 3, histSize, ranges, true, false);
+    calcColorHist(prevFrame, prevHist);
+    calcColorHist(currntFrame, currHist);
 
     // normalize histograms
-    double s = cv::sum(prevHist)[0];
-    prevHist.convertTo(prevHist, prevHist.type(), 1./s, 0);
-
-    s = cv::sum(currHist)[0];
-    currHist.convertTo(currHist, currHist.type(), 1./s, 0);
+    prevHist.convertTo(prevHist, prevHist.type(), 1./prevFrame.total(), 0);
+    currHist.convertTo(currHist, currHist.type(), 1./currntFrame.total(), 0);
 
     /**
     * OpenCV normalize() method supports up to 2 dimensions. So, this does not work on 3D histograms
@@ -99,22 +163,8 @@ bool ShotDetector::shotBoundaryDetect(cv::Mat &prevFrame, cv::Mat& currntFrame,
  */
 bool ShotDetector::shotBoundaryDetect(cv::Mat &prevFrame, cv::Mat& currntFrame){
 
-    int channels[] = {0, 1, 2};
-    MatND prevHist, currHist;
-    //histogram size (bins) for r,g,b channels equal to 32.
-    int histSize[] = {32, 32, 32};
-    // color ranges for rgb channels are between (0, 256)
-    float color_ranges[] = { 0, 256 };
-    const float* ranges[] = { color_ranges, color_ranges, color_ranges };
-    calcHist(&prevFrame, 1, channels, Mat(), prevHist, 3, histSize, ranges, true, false);
-    calcHist(&currntFrame, 1, channels, Mat(), currHist, 3, histSize, ranges, true, false);
-
-    // normalize histograms
-    double s = cv::sum(prevHist)[0];
-    prevHist.convertTo(prevHist, prevHist.type(), 1./s, 0);
-
-    s = cv::sum(currHist)[0];
-    currHist.convertTo(currHist, currHist.type(), 1./s, 0);
+    MatND prevHist = prepareFrame(prevFrame);
+    MatND currHist = prepareFrame(currntFrame);
 
     /**
     * OpenCV normalize() method supports up to 2 dimensions. So, this does not work on 3D histograms
@@ -123,7 +173,7 @@ bool ShotDetector::shotBoundaryDetect(cv::Mat &prevFrame, cv::Mat& currntFrame){
     **/
 
     // calculate the Chi-Squre distance of histograms of the adjacent frames.
-    double result = compareHistCustom( prevHist, currHist, CV_COMP_CHISQR );
+    double result = histDistance( prevHist, currHist );
 
     /** print the results for debugging and testing
     cout << "result: " << result <<"  ";
@@ -151,7 +201,7 @@ bool ShotDetector::shotBoundaryDetect(cv::Mat &prevFrame, cv::Mat& currntFrame){
 bool ShotDetector::shotBoundaryDetectHist(cv::MatND &prevHist, cv::MatND& currHist){
 
     // calculate the Chi-Squre distance of histograms of the adjacent frames.
-    double result = compareHistCustom( prevHist, currHist, CV_COMP_CHISQR );
+    double result = histDistance( prevHist, currHist );
 
     if(result > threshold)
     {
@@ -163,6 +213,22 @@ bool ShotDetector::shotBoundaryDetectHist(cv::MatND &prevHist, cv::MatND& currHi
     }
 }
 
+/**
+ * @brief ShotDetector::shotBoundaryDetectCounts: Same as shotBoundaryDetectHist for histograms which are
+ * not normalized (see prepareFrameCounts). Chi-Square distance of bin counts is pixelCount times the distance
+ * of normalized histograms, so the threshold is scaled instead of normalizing every histogram.
+ * @param prevHist : Histogram of Previous Frame (bin counts)
+ * @param currHist: Histogram of Current Frame (bin counts)
+ * @param pixelCount: Number of pixels of a frame, which is the sum of bin counts
+ * @return: Returns true if shot is detected, otherwise returns false
+ */
+bool ShotDetector::shotBoundaryDetectCounts(cv::MatND &prevHist, cv::MatND& currHist, double pixelCount){
+
+    double result = histDistance( prevHist, currHist );
+
+    return result > threshold * pixelCount;
+}
+
 /**
  * @brief ShotDetector::prepareFrame: This method calculates RGB color histogram of input image
  * and normalizes histogram between (0, 1).
@@ -170,55 +236,184 @@ bool ShotDetector::shotBoundaryDetectHist(cv::MatND &prevHist, cv::MatND& currHi
  * @return: Normalized histogram as a MATND multi dimentional matrix
  */
 cv::MatND ShotDetector::prepareFrame(cv::Mat &frame){
-    int channels[] = {0, 1, 2};
     MatND currHist;
-    //histogram size (bins) for r,g,b channels equal to 32.
-    int histSize[] = {32, 32, 32};
-    // color ranges for rgb channels are between (0, 256)
-    float color_ranges[] = { 0, 256 };
-    const float* ranges[] = { color_ranges, color_ranges, color_ranges };
-    calcHist(&frame, 1, channels, Mat(), currHist, 3, histSize, ranges, true, false);
+    prepareFrameCounts(frame, currHist);
 
-    // normalize histograms
-    double s = cv::sum(currHist)[0];
-    currHist.convertTo(currHist, currHist.type(), 1./s, 0);
+    // normalize histograms, every sampled pixel is counted in a bin so the sum of bins is the pixel count
+    currHist.convertTo(currHist, CV_32F, 1./sampledPixelCount(frame), 0);
     return currHist;
 }
 
+/**
+ * @brief ShotDetector::prepareFrameCounts: This method calculates RGB color histogram of input image
+ * without normalization. Frames of a video have the same number of pixels, so histograms used in the
+ * detection loop are compared as integer bin counts with shotBoundaryDetectCounts.
+ * Unconverted YUV frames (see setYUVNative) are counted with calcYUVHist, the sampling mode does not apply to them.
+ * In tile mode (see setTileGrid) BGR frames are counted with calcColorHistTiles, a histogram per tile.
+ * @param frame: input image
+ * @param hist: Histogram (CV_32S bin counts) as a MATND multi dimentional matrix, storage is reused if possible
+ */
+void ShotDetector::prepareFrameCounts(const cv::Mat &frame, cv::MatND &hist){
+    int layout = yuvLayout(frame);
+    if(layout >= 0){
+        calcYUVHist(frame, hist, layout, CV_32S);
+        return;
+    }
+    bool tiled = tileGrid > 1;
+    //histogram size (bins) for r,g,b channels equal to 32.
+    switch(sampling){
+    case SAMPLE_PIXEL_STRIDE:
+        if(tiled)
+            calcColorHistTiles(frame, hist, tileGrid, sampling_factor, 1, CV_32S);
+        else
+            calcColorHistSampled(frame, hist, sampling_factor, 1, CV_32S);
+        break;
+    case SAMPLE_ROW_STRIDE:
+        if(tiled)
+            calcColorHistTiles(frame, hist, tileGrid, 1, sampling_factor, CV_32S);
+        else
+            calcColorHistSampled(frame, hist, 1, sampling_factor, CV_32S);
+        break;
+    case SAMPLE_DOWNSCALE:
+    {
+        //workers of processVideo_Parallel share the detector, so each thread keeps its own buffer
+        static thread_local Mat downscaled;
+        resize(frame, downscaled, Size(std::max(frame.cols / sampling_factor, 1), std::max(frame.rows / sampling_factor, 1)),
+               0, 0, INTER_AREA);
+        if(tiled)
+            calcColorHistTiles(downscaled, hist, tileGrid, 1, 1, CV_32S);
+        else
+            calcColorHist(downscaled, hist, CV_32S);
+        break;
+    }
+    default:
+        if(tiled)
+            calcColorHistTiles(frame, hist, tileGrid, 1, 1, CV_32S);
+        else
+            calcColorHist(frame, hist, CV_32S);
+        break;
+    }
+}
+
+/**
+ * @brief ShotDetector::sampledPixelCount: Returns the number of pixels prepareFrameCounts counts in the
+ * histogram of a frame, which is the pixel count to be passed to shotBoundaryDetectCounts.
+ * @param frame: input image
+ */
+double ShotDetector::sampledPixelCount(const cv::Mat &frame) const{
+    int layout = yuvLayout(frame);
+    if(layout >= 0)
+        return (double) yuvFramePixels(frame, layout);
+    if(tileGrid > 1){
+        //strides restart at the left edge of every tile
+        switch(sampling){
+        case SAMPLE_PIXEL_STRIDE:
+            return colorHistTilePixels(frame.size(), tileGrid, sampling_factor, 1);
+        case SAMPLE_ROW_STRIDE:
+            return colorHistTilePixels(frame.size(), tileGrid, 1, sampling_factor);
+        case SAMPLE_DOWNSCALE:
+            return (double) std::max(frame.cols / sampling_factor, 1) * std::max(frame.rows / sampling_factor, 1);
+        default:
+            return (double) frame.total();
+        }
+    }
+    switch(sampling){
+    case SAMPLE_PIXEL_STRIDE:
+        return (double) frame.rows * ((frame.cols + sampling_factor - 1) / sampling_factor);
+    case SAMPLE_ROW_STRIDE:
+        return (double) ((frame.rows + sampling_factor - 1) / sampling_factor) * frame.cols;
+    case SAMPLE_DOWNSCALE:
+        return (double) std::max(frame.cols / sampling_factor, 1) * std::max(frame.rows / sampling_factor, 1);
+    default:
+        return (double) frame.total();
+    }
+}
+
+/**
+ * @brief ShotDetector::histDistance: Chi-Square distance of the histograms of two frames. Histograms of a
+ * single tile are compared as a whole. In tile mode each tile is compared with the same tile of the other
+ * frame and the tileIgnored largest tile distances are dropped, so motion confined to a few tiles does not
+ * add up to a boundary. The remaining distances are scaled up by the tiles they stand for, which keeps the
+ * distance comparable with the threshold times the pixel count of the frame.
+ * @param prevHist: Histogram of Previous Frame (bin counts, or normalized)
+ * @param currHist: Histogram of Current Frame, of the same size and type
+ */
+double ShotDetector::histDistance(const cv::MatND &prevHist, const cv::MatND &currHist) const{
+    int tiles = prevHist.dims == 4 ? prevHist.size[0] : 1;
+    if(tiles <= 1 || tileIgnored <= 0)
+        return compareHistCustom(prevHist, currHist, CV_COMP_CHISQR);
+
+    //histograms of the tiles are compared with matrix headers on the tile slices
+    int histSize[] = {COLOR_HIST_BINS, COLOR_HIST_BINS, COLOR_HIST_BINS};
+    static thread_local std::vector<double> distances;
+    distances.resize(tiles);
+    for(int t = 0; t < tiles; t++){
+        MatND prevTile(3, histSize, prevHist.type(), prevHist.data + t * prevHist.step[0]);
+        MatND currTile(3, histSize, currHist.type(), currHist.data + t * currHist.step[0]);
+        distances[t] = compareHistCustom(prevTile, currTile, CV_COMP_CHISQR);
+    }
+    int kept = std::max(tiles - tileIgnored, 1);
+    std::nth_element(distances.begin(), distances.begin() + (kept - 1), distances.end());
+    double sum = 0;
+    for(int t = 0; t < kept; t++)
+        sum += distances[t];
+    return sum * tiles / kept;
+}
+
+/**
+ * @brief ShotDetector::yuvLayout: Returns the YUV layout of a frame delivered unconverted by the decoder,
+ * or -1 if the frame is BGR. Frames are only taken as YUV when the YUV native mode is enabled:
+ * single channel frames hold I420 planes, two channel frames hold packed YUYV.
+ * @param frame: decoded frame
+ */
+int ShotDetector::yuvLayout(const cv::Mat &frame) const{
+    if(!yuvNative)
+        return -1;
+    if(frame.type() == CV_8UC1)
+        return YUV_I420;
+    if(frame.type() == CV_8UC2)
+        return YUV_YUYV;
+    return -1;
+}
+
+/**
+ * @brief ShotDetector::frameBoundary: Boundary decision of the detection loops for the bin counts of two
+ * consecutive frames, same as shotBoundaryDetectCounts with the threshold of boundaryThreshold.
+ * @param prevHist: Histogram of Previous Frame (bin counts)
+ * @param currHist: Histogram of Current Frame (bin counts)
+ * @param currFrame: current frame, decides the color space and the pixel count
+ */
+bool ShotDetector::frameBoundary(cv::MatND &prevHist, cv::MatND &currHist, const cv::Mat &currFrame){
+    return histDistance( prevHist, currHist ) > boundaryThreshold(currFrame);
+}
+
+/**
+ * @brief ShotDetector::boundaryThreshold: Returns the threshold of the Chi-Square distance of bin counts
+ * (see shotBoundaryDetectCounts) for the histogram of currFrame, using the YUV threshold for YUV frames.
+ */
+double ShotDetector::boundaryThreshold(const cv::Mat &currFrame) const{
+    return (yuvLayout(currFrame) < 0 ? threshold : yuvThreshold) * sampledPixelCount(currFrame);
+}
+
+/**
+ * @brief ShotDetector::requestUnconvertedFrames: In YUV native mode asks the backend of cap to deliver frames
+ * without the conversion to BGR. Backends which do not support it keep delivering BGR frames, which are
+ * then processed as usual.
+ */
+void ShotDetector::requestUnconvertedFrames(cv::VideoCapture &cap){
+    if(yuvNative)
+        cap.set(CV_CAP_PROP_CONVERT_RGB, 0);
+}
+
 /**
  * @brief ShotDetector::processVideo: This method process video and detect shot boundaries
  * at video with graphical interface. Results are stored in a file.
  * @param outputFileName: Results are stored in given filename
- * @param format: Format type of output file. It can be XML, YAML or TEXT (basic txt file format)
+ * @param format: Format type of output file. XML, YAML, TEXT, JSON or BINARY (see ResultWriter)
  */
 void ShotDetector::processVideo(std::string outputFileName, OutputFormat format){
     VideoCapture cap(videoPath);
-    stringstream ss;
-    ss << outputFileName;
-
-
-#ifdef _WIN32
-    //create directory if not exists
-    string create_dir_command("mkdir ");
-#else
-    //create directory if not exists
-    string create_dir_command("mkdir -p ");
-#endif
-    create_dir_command += outputFileName;
-    system(create_dir_command.c_str());
-
-    if(format == XML){
-        ss << ".xml";
-    }else if(format == YAML){
-        ss << ".xml";
-    }else if(format == TEXT){
-        ss << ".txt";
-    }else{
-        //should never been reached
-    }
-
-    //store the result in xml format
-    FileStorage fstorage(ss.str(), FileStorage::WRITE);
+    string resultFile = resultFileName(outputFileName, format);
 
     /** store the information whether shot is found at previous frame
      * in order to detect fades and dissolves
@@ -232,14 +427,9 @@ void ShotDetector::processVideo(std::string outputFileName, OutputFormat format)
     }
     Mat prevFrame;
     cap >> prevFrame;
-    fstorage << "Header" << "[" ;
-    fstorage <<"{:"
-            << "video_path" << videoPath
-            << "fps" << (int) cap.get(CV_CAP_PROP_FPS)
-            <<"frame_count" << (int) cap.get(CV_CAP_PROP_FRAME_COUNT) << "}" << "]" ;
-
-    fstorage << "Shots" << "[" ;
-    fstorage << "{:"<< "begin_frame_number" <<(int) cap.get(CV_CAP_PROP_POS_FRAMES) << "begin_time" << miliseconds_to_DHMS( cap.get(CV_CAP_PROP_POS_MSEC) ) ;
+    std::unique_ptr<ResultWriter> results(openResultFile(resultFile, format, videoPath, (int) cap.get(CV_CAP_PROP_FPS),
+                                                         (int) cap.get(CV_CAP_PROP_FRAME_COUNT)));
+    writeShotEvent(*results, SHOT_BEGIN, (int) cap.get(CV_CAP_PROP_POS_FRAMES), cap.get(CV_CAP_PROP_POS_MSEC));
     shotStartStored = true;
 
     //store the shot frame to output path
@@ -253,12 +443,11 @@ void ShotDetector::processVideo(std::string outputFileName, OutputFormat format)
         rootShotPath.append("/");
 #endif
 
+    KeyframeWriter writer(keyframeOptions, metrics);
+    keyframeWriter = &writer;
+
     //save the inital frame which is the start of first shot.
-    string initialShotPath(rootShotPath);
-    stringstream filestream;
-    filestream << "frame_" << cap.get(CV_CAP_PROP_POS_FRAMES) <<".jpg";
-    initialShotPath.append(filestream.str());
-    imwrite(initialShotPath, prevFrame);
+    storeFrame(rootShotPath, (int) cap.get(CV_CAP_PROP_POS_FRAMES), prevFrame);
     int frameCounter = 0;
 
     while(1){
@@ -270,13 +459,8 @@ void ShotDetector::processVideo(std::string outputFileName, OutputFormat format)
             if(!shotFoundAtPrev)
             {
                 int frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
-                fstorage << "end_frame_number" << frame_number<< "end_time" << miliseconds_to_DHMS( cap.get(CV_CAP_PROP_POS_MSEC) ) << "}";
-                string frameStoragePath(rootShotPath);
-                stringstream framestream;
-
-                framestream << frame_number <<".jpg";
-                frameStoragePath.append("frame_").append(framestream.str());
-                imwrite(frameStoragePath, prevFrame);
+                writeShotEvent(*results, SHOT_END, frame_number, cap.get(CV_CAP_PROP_POS_MSEC));
+                storeFrame(rootShotPath, frame_number, prevFrame);
                 //shot is already saved, so clear frame counter
                 frameCounter = 0;
             }
@@ -287,15 +471,10 @@ void ShotDetector::processVideo(std::string outputFileName, OutputFormat format)
         if(shotFoundAtPrev && !shotStartStored)
         {
             int frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
-            fstorage << "{:"<< "begin_frame_number" <<frame_number << "begin_time" << miliseconds_to_DHMS( cap.get(CV_CAP_PROP_POS_MSEC) ) ;
+            writeShotEvent(*results, SHOT_BEGIN, frame_number, cap.get(CV_CAP_PROP_POS_MSEC));
             shotStartStored = true;
 
-            string frameStoragePath(rootShotPath);
-            stringstream framestream;
-
-            framestream << frame_number <<".jpg";
-            frameStoragePath.append("frame_").append(framestream.str());
-            imwrite(frameStoragePath, grabbedFrame);
+            storeFrame(rootShotPath, frame_number, grabbedFrame);
             //shot is already saved, so clear frame counter
             frameCounter = 0;
         }
@@ -304,15 +483,10 @@ void ShotDetector::processVideo(std::string outputFileName, OutputFormat format)
             if(!shotFoundAtPrev)
             {
                 int frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
-                fstorage << "end_frame_number" <<frame_number << "end_time" << miliseconds_to_DHMS( cap.get(CV_CAP_PROP_POS_MSEC) ) << "}";
+                writeShotEvent(*results, SHOT_END, frame_number, cap.get(CV_CAP_PROP_POS_MSEC));
                 shotStartStored = false;
 
-                string frameStoragePath(rootShotPath);
-                stringstream framestream;
-
-                framestream << frame_number <<".jpg";
-                frameStoragePath.append("frame_").append(framestream.str());
-                imwrite(frameStoragePath, grabbedFrame);
+                storeFrame(rootShotPath, frame_number, grabbedFrame);
                 //shot is already saved, so clear frame counter
                 frameCounter = 0;
 
@@ -332,12 +506,8 @@ void ShotDetector::processVideo(std::string outputFileName, OutputFormat format)
 
         if(this->sample_period != 0 && frameCounter == this->sample_period){
             int frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
-            fstorage << "frame_number" <<frame_number << "time" << miliseconds_to_DHMS( cap.get(CV_CAP_PROP_POS_MSEC) );
-            string frameStoragePath(rootShotPath);
-            stringstream framestream;
-            framestream << frame_number <<".jpg";
-            frameStoragePath.append("frame_").append(framestream.str());
-            imwrite(frameStoragePath, grabbedFrame);
+            writeShotEvent(*results, SHOT_SAMPLE, frame_number, cap.get(CV_CAP_PROP_POS_MSEC));
+            storeFrame(rootShotPath, frame_number, grabbedFrame);
 
             //clear frame counter
             frameCounter = 0;
@@ -351,315 +521,1690 @@ void ShotDetector::processVideo(std::string outputFileName, OutputFormat format)
         if(key == 'q' || key == 'Q')
         {
 
-            /* if end of shot is stored at this time, do not add closing curly bracket */
-            if(shotFoundAtPrev && !shotStartStored)
-            {
-                int frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
-                fstorage << "aborted_frame_number" <<frame_number << "time" << miliseconds_to_DHMS( cap.get(CV_CAP_PROP_POS_MSEC) );
-            }
-            /* if end of shot is NOT stored, add closing curly bracket at the end */
-            else
-            {
-                int frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
-                fstorage << "aborted_frame_number" <<frame_number << "time" << miliseconds_to_DHMS( cap.get(CV_CAP_PROP_POS_MSEC) );
-                fstorage << "}" ;
-            }
+            /* if end of shot is stored at this time, the aborted frame is not part of a shot */
+            int frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
+            results->aborted(frame_number, cap.get(CV_CAP_PROP_POS_MSEC), !(shotFoundAtPrev && !shotStartStored));
+            streamEvent("aborted", frame_number, cap.get(CV_CAP_PROP_POS_MSEC));
             break;
         }
     }
-    fstorage << "]" ;
-    fstorage.release();
+    results->endShots();
+    closeResultFile(*results);
+    finishKeyframes(writer);
 }
 
 
 /**
  * @brief ShotDetector::processVideo_NoGUI: This method process video and detect shot boundaries
- * at video without graphical interface. Results are stored in a file.
+ * at video without graphical interface. Results are stored in a file. Frames are decoded here and
+ * pushed to a ShotStream, whose events are written to the result file and the keyframe writer.
  * @param outputFileName: Results are stored in given filename
- * @param format: Format type of output file. It can be XML, YAML or TEXT (basic txt file format)
+ * @param format: Format type of output file. XML, YAML, TEXT, JSON or BINARY (see ResultWriter)
  */
 void ShotDetector::processVideo_NoGUI(std::string outputFileName, OutputFormat format){
     VideoCapture cap(videoPath);
-    stringstream ss;
-    ss << outputFileName;
-
-    //create directory if not exists
-    string create_dir_command("mkdir -p ");
-    create_dir_command += outputFileName;
-    system(create_dir_command.c_str());
-
-    if(format == XML){
-        ss << ".xml";
-    }else if(format == YAML){
-        ss << ".xml";
-    }else if(format == TEXT){
-        ss << ".txt";
-    }else{
-        //should never been reached
-    }
-
-    //store the result in xml format
-    FileStorage fstorage(ss.str(), FileStorage::WRITE);
-    /** store the information whether shot is found at previous frame in order to detect fades and dissolves  **/
-    bool shotFoundAtPrev = false;
-    bool shotStartStored = false;
+    string resultFile = resultFileName(outputFileName, format);
+    processedFrames = 0;
+    bufferReallocations = 0;
 
     if(!cap.isOpened()){
         cout<<"error openning video!!" << endl;
         return;
     }
-    Mat prevFrame;
-    MatND prevHist;
-    int channels[] = {0, 1, 2};
+    requestUnconvertedFrames(cap);
+    FrameBuffers buffers;
 
-    //histogram size (bins) for r,g,b channels equal to 32.
-    int histSize[] = {32, 32, 32};
-    // color ranges for rgb channels are between (0, 256)
-    float color_ranges[] = { 0, 256 };
-    const float* ranges[] = { color_ranges, color_ranges, color_ranges };
+    std::unique_ptr<ResultWriter> results(openResultFile(resultFile, format, videoPath, (int) cap.get(CV_CAP_PROP_FPS),
+                                                         (int) cap.get(CV_CAP_PROP_FRAME_COUNT)));
 
+    //store the shot frame to output path
+    string rootShotPath = shotPath(outputFileName);
+    KeyframeWriter writer(keyframeOptions, metrics);
+    keyframeWriter = &writer;
+
+    vector<GradualDetector::Transition> transitions;
+    //events of the run, kept for the checkpoints
+    vector<ResultWriter::BinaryRecord> events;
+    bool checkpointing = !checkpointPath.empty();
+    checkpointCounters = CheckpointStats();
+    bool queued = false;
+    ShotStream stream(*this);
+    stream.onEvent([&](ShotEvent event, int frame_number, double time, const cv::Mat &frame){
+        writeShotEvent(*results, event, frame_number, time);
+        Mat keyframe = frame;
+        storeFrame(rootShotPath, frame_number, keyframe);
+        queued = true;
+        if(checkpointing){
+            ResultWriter::BinaryRecord record = {event, frame_number, time};
+            events.push_back(record);
+        }
+    });
+    stream.onTransition([&](const GradualDetector::Transition &transition){
+        addGradualTransition(transitions, transition);
+    });
+    //the seek index and the signature cache need every frame, they are not written by a resumed run
+    bool resumed = checkpointing && resumeRun && resumeCheckpoint(cap, buffers, stream, *results, events, transitions, format);
+    SeekIndex seekIndex;
+    bool indexing = !resumed && !seekIndexPath.empty() && seekIndex.create(seekIndexPath, videoPath, seekKeyframeInterval);
+    if(signatureCache && !resumed){
+        stream.onFrame([&](int frame_number, double time, double distance, const cv::Mat &frame, const cv::MatND &hist){
+            cacheFrame(frame_number, time, distance, frame);
+        });
+    }
 
-    cap >> prevFrame;
-    prevHist = prepareFrame(prevFrame);
+    int64 checkpoint_ticks = (int64) (checkpointPeriod * getTickFrequency());
+    int64 next_checkpoint = getTickCount() + checkpoint_ticks;
+    while(1){
+        if(!buffers.read(cap, metrics)){
+            cout<<"empty frame!" << endl;
+            stream.finish((int) cap.get(CV_CAP_PROP_POS_FRAMES), cap.get(CV_CAP_PROP_POS_MSEC));
+            break;
+        }
+        processedFrames++;
+
+        queued = false;
+        int frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
+        double time = cap.get(CV_CAP_PROP_POS_MSEC);
+        if(indexing)
+            seekIndex.append(frame_number, time);
+        stream.feed(buffers.currFrame(), frame_number, time);
+        //a stored frame is shared with the keyframe writer
+        if(queued)
+            buffers.markQueued();
+
+        //current frame becomes the previous one without copying
+        buffers.next();
+
+        if(checkpointing && getTickCount() >= next_checkpoint){
+            saveCheckpoint(stream, events, transitions, writer, format);
+            next_checkpoint = getTickCount() + checkpoint_ticks;
+        }
+    }
+    bufferReallocations = buffers.reallocations + stream.reallocationCount();
+    if(indexing)
+        seekIndex.finish(cap.get(CV_CAP_PROP_FPS));
+    if(signatureCache && !resumed){
+        SignatureCache::Header header;
+        memset(&header, 0, sizeof(header));
+        header.frame_count = processedFrames;
+        header.video_frame_count = (int) cap.get(CV_CAP_PROP_FRAME_COUNT);
+        header.sampling = sampling;
+        header.sampling_factor = sampling_factor;
+        header.tile_grid = (int16_t) tileGrid;
+        header.tile_ignored = (int16_t) tileIgnored;
+        header.flags = yuvLayout(buffers.prevFrame()) >= 0 ? SignatureCache::YUV_HISTOGRAMS : 0;
+        header.end_frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
+        header.end_time = cap.get(CV_CAP_PROP_POS_MSEC);
+        header.fps = cap.get(CV_CAP_PROP_FPS);
+        signatureCache->finish(header);
+    }
+
+    results->endShots();
+    if(gradualWindow > 0)
+        writeGradualTransitions(*results, transitions);
+    closeResultFile(*results);
+    finishKeyframes(writer);
+    //the run is complete, a later run must not resume from it
+    if(checkpointing)
+        remove(checkpointPath.c_str());
+}
 
-    fstorage << "Header" << "[" ;
-    fstorage <<"{:"
-            << "video_path" << videoPath
-            << "fps" << (int) cap.get(CV_CAP_PROP_FPS)
-            <<"frame_count" << (int) cap.get(CV_CAP_PROP_FRAME_COUNT) << "}" << "]" ;
+/**
+ * @brief ShotDetector::processVideo_Sweep: This method detects shot boundaries at several thresholds in a single
+ * pass over the video, without graphical interface. The distance of each pair of adjacent frames is computed once
+ * and decided against every threshold, each threshold has its own shot state machine and result file
+ * (outputFileName_t<threshold> with the extension of the format). Keyframes are stored under the common output
+ * path, a frame selected by several thresholds is stored only once. Thresholds apply to the histograms in use,
+ * YUV ones in YUV native mode. The event stream is not written, its records would not tell thresholds apart.
+ * @param outputFileName: Results are stored in given filename
+ * @param format: Format type of output file. XML, YAML, TEXT, JSON or BINARY (see ResultWriter)
+ * @param thresholds: Threshold values for shot detection
+ */
+void ShotDetector::processVideo_Sweep(std::string outputFileName, OutputFormat format, const std::vector<double> &thresholds){
+    VideoCapture cap(videoPath);
+    string resultFile = resultFileName(outputFileName, format);
+    vector< std::unique_ptr<ResultWriter> > results;
+    vector<ShotState> states(thresholds.size(), ShotState(sample_period));
+    vector<ShotEvent> events(thresholds.size());
+    processedFrames = 0;
+    bufferReallocations = 0;
 
-    fstorage << "Shots" << "[" ;
-    fstorage << "{:"<< "begin_frame_number" <<(int) cap.get(CV_CAP_PROP_POS_FRAMES) << "begin_time" << miliseconds_to_DHMS( cap.get(CV_CAP_PROP_POS_MSEC) ) ;
-    shotStartStored = true;
+    if(!cap.isOpened()){
+        cout<<"error openning video!!" << endl;
+        return;
+    }
+    requestUnconvertedFrames(cap);
+    std::ostream *stream = eventStream;
+    eventStream = 0;
+    FrameBuffers buffers;
+
+    buffers.read(cap, metrics);
+    int64 start_t = RunMetrics::start(metrics);
+    prepareFrameCounts(buffers.currFrame(), buffers.currHist());
+    RunMetrics::stop(metrics, RunMetrics::HISTOGRAM, start_t);
+    processedFrames++;
+
+    for(size_t k = 0; k < thresholds.size(); k++){
+        results.push_back(std::unique_ptr<ResultWriter>(openResultFile(sweepFileName(resultFile, thresholds[k]), format,
+                                                                        videoPath, (int) cap.get(CV_CAP_PROP_FPS),
+                                                                        (int) cap.get(CV_CAP_PROP_FRAME_COUNT), thresholds[k])));
+        writeShotEvent(*results[k], SHOT_BEGIN, (int) cap.get(CV_CAP_PROP_POS_FRAMES), cap.get(CV_CAP_PROP_POS_MSEC));
+    }
 
     //store the shot frame to output path
-#ifdef _WIN32
-    string rootShotPath(outputFileName);
-    if(outputFileName.at(outputFileName.size() -1) != '\\')
-        rootShotPath.append("\\");
-#else
-    string rootShotPath(outputFileName);
-    if(outputFileName.at(outputFileName.size() -1) != '/')
-        rootShotPath.append("/");
-#endif
+    string rootShotPath = shotPath(outputFileName);
+    KeyframeWriter writer(keyframeOptions, metrics);
+    keyframeWriter = &writer;
 
     //save the inital frame which is the start of first shot.
-    string initialShotPath(rootShotPath);
-    stringstream filestream;
-    filestream << "frame_" << cap.get(CV_CAP_PROP_POS_FRAMES) <<".jpg";
-    initialShotPath.append(filestream.str());
-    imwrite(initialShotPath, prevFrame);
-    int frameCounter = 0;
+    storeFrame(rootShotPath, (int) cap.get(CV_CAP_PROP_POS_FRAMES), buffers.currFrame());
+    buffers.markQueued();
+    buffers.next();
 
     while(1){
-        Mat grabbedFrame;
-        cap >> grabbedFrame;
-
-        if(grabbedFrame.empty()){
+        if(!buffers.read(cap, metrics)){
             cout<<"empty frame!" << endl;
-            if(!shotFoundAtPrev)
-            {
-                int frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
-                fstorage << "end_frame_number" << frame_number<< "end_time" << miliseconds_to_DHMS( cap.get(CV_CAP_PROP_POS_MSEC) ) << "}";
-                string frameStoragePath(rootShotPath);
-                stringstream framestream;
-
-                framestream << frame_number <<".jpg";
-                frameStoragePath.append("frame_").append(framestream.str());
-                imwrite(frameStoragePath, prevFrame);
-                //shot is already saved, so clear frame counter
-                frameCounter = 0;
+            int frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
+            bool store = false;
+            for(size_t k = 0; k < thresholds.size(); k++){
+                if(!states[k].shotFoundAtPrev)
+                {
+                    writeShotEvent(*results[k], SHOT_END, frame_number, cap.get(CV_CAP_PROP_POS_MSEC));
+                    store = true;
+                }
             }
+            if(store)
+                storeFrame(rootShotPath, frame_number, buffers.prevFrame());
             break;
         }
-
-        if(shotFoundAtPrev && !shotStartStored)
-        {
-            int frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
-            fstorage << "{:"<< "begin_frame_number" <<frame_number << "begin_time" << miliseconds_to_DHMS( cap.get(CV_CAP_PROP_POS_MSEC) ) ;
-            shotStartStored = true;
-            string frameStoragePath(rootShotPath);
-            stringstream framestream;
-
-            framestream << frame_number <<".jpg";
-            frameStoragePath.append("frame_").append(framestream.str());
-            imwrite(frameStoragePath, grabbedFrame);
-            //shot is already saved, so clear frame counter
-            frameCounter = 0;
-        }
-        MatND grabbedHist = prepareFrame(grabbedFrame);
-        bool result = shotBoundaryDetectHist(prevHist, grabbedHist);
-        if(result)
-        {
-            if(!shotFoundAtPrev)
+        processedFrames++;
+
+        start_t = RunMetrics::start(metrics);
+        prepareFrameCounts(buffers.currFrame(), buffers.currHist());
+        RunMetrics::stop(metrics, RunMetrics::HISTOGRAM, start_t);
+        start_t = RunMetrics::start(metrics);
+        double distance = histDistance(buffers.prevHist(), buffers.currHist());
+        double pixels = sampledPixelCount(buffers.currFrame());
+        for(size_t k = 0; k < thresholds.size(); k++)
+            events[k] = states[k].update(distance > thresholds[k] * pixels);
+        RunMetrics::stop(metrics, RunMetrics::COMPARE, start_t);
+        bool store = false;
+        int frame_number = 0;
+        for(size_t k = 0; k < thresholds.size(); k++){
+            if(events[k] != NO_EVENT)
             {
-                int frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
-                fstorage << "end_frame_number" <<frame_number << "end_time" << miliseconds_to_DHMS( cap.get(CV_CAP_PROP_POS_MSEC) ) << "}";
-                shotStartStored = false;
-                string frameStoragePath(rootShotPath);
-                stringstream framestream;
-
-                framestream << frame_number <<".jpg";
-                frameStoragePath.append("frame_").append(framestream.str());
-                imwrite(frameStoragePath, grabbedFrame);
-                //shot is already saved, so clear frame counter
-                frameCounter = 0;
+                if(!store)
+                    frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
+                writeShotEvent(*results[k], events[k], frame_number, cap.get(CV_CAP_PROP_POS_MSEC));
+                store = true;
             }
-            shotFoundAtPrev = true;
         }
-        else
+        //a frame selected by several thresholds is stored once
+        if(store)
         {
-            shotFoundAtPrev = false;
-        }
-
-        if(this->sample_period != 0 && frameCounter == this->sample_period){
-            int frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
-            fstorage << "frame_number" <<frame_number << "time" << miliseconds_to_DHMS( cap.get(CV_CAP_PROP_POS_MSEC) );
-            string frameStoragePath(rootShotPath);
-            stringstream framestream;
-
-            framestream << frame_number <<".jpg";
-            frameStoragePath.append("frame_").append(framestream.str());
-            imwrite(frameStoragePath, grabbedFrame);
-            //clear frame counter
-            frameCounter = 0;
+            storeFrame(rootShotPath, frame_number, buffers.currFrame());
+            buffers.markQueued();
         }
-        frameCounter++;
-
-        prevFrame = grabbedFrame.clone();
-        prevHist = grabbedHist.clone();
 
+        buffers.next();
     }
+    bufferReallocations = buffers.reallocations;
+    eventStream = stream;
 
-    fstorage << "]" ;
-    fstorage.release();
-}
-
-/**
- * @brief ShotDetector::miliseconds_to_DHMS: This method converts time interval in miliseconds format to Day-Hour-Minute-Second format
- * @param duration: duration in miliseconds
- * @return: Returns D:H:M:S format as a string
- */
-std::string ShotDetector::miliseconds_to_DHMS(double duration){
-
-    char buffer[20];
-    int buffer_length;
-    unsigned int timestamp_as_seconds = duration / 1000;
-    int seconds = (int) (timestamp_as_seconds % 60);
-    timestamp_as_seconds /= 60;
-    int minutes = (int) (timestamp_as_seconds % 60);
-    timestamp_as_seconds /= 60;
-    int hours = (int) (timestamp_as_seconds % 24);
-    int days = (int) (timestamp_as_seconds / 24);
-    if( (hours == 0) && (days == 0) ){
-        buffer_length = sprintf(buffer, "%02d:%02d", minutes, seconds);
-    }else if(days == 0){
-        buffer_length = sprintf(buffer, "%02d:%02d:%02d", hours, minutes, seconds);
-    }else{
-        buffer_length = sprintf(buffer, "%dd:%02d:%02d:%02d", days, hours, minutes, seconds);
+    for(size_t k = 0; k < results.size(); k++){
+        results[k]->endShots();
+        closeResultFile(*results[k]);
     }
-    std::string result(buffer, buffer_length);
-    return result;
+    finishKeyframes(writer);
 }
 
 /**
- * @brief ShotDetector::getShotFromVideo: gets detected shot (specified frame with given frame number) from video.
- * @param frame_number: index of frame to be grabbed. Note that indexing is 0 based.
- * @return returns frame with corresponding frame number from video.
+ * @brief ShotDetector::processVideo_Cascade: This method detects shot boundaries without graphical interface,
+ * deciding each frame with a cascade of metrics (see CascadeDetector) instead of the Chi-Square distance of the
+ * histograms of every frame. Frames are compared as BGR images, the YUV native mode does not apply.
+ * The statistics of the stages are returned by cascadeStats().
+ * @param outputFileName: Results are stored in given filename
+ * @param format: Format type of output file. XML, YAML, TEXT, JSON or BINARY (see ResultWriter)
+ * @param stages: stages of the cascade, in the order they are run
  */
-cv::Mat ShotDetector::getShotFromVideo(double frame_number){
+void ShotDetector::processVideo_Cascade(std::string outputFileName, OutputFormat format,
+                                        const std::vector<CascadeDetector::Stage> &stages){
     VideoCapture cap(videoPath);
+    string resultFile = resultFileName(outputFileName, format);
+    ShotState state(sample_period);
+    CascadeDetector cascade(*this, stages, metrics);
+    processedFrames = 0;
+    bufferReallocations = 0;
+    cascadeCounters = CascadeDetector::Stats();
+
     if(!cap.isOpened()){
-        cout << "error openning video!" <<endl;
-        return Mat();
+        cout<<"error openning video!!" << endl;
+        return;
     }
-    cap.set(CV_CAP_PROP_POS_FRAMES, frame_number);
-    cv::Mat frame;
-    cap >> frame;
-    return frame;
-}
-
-double cv::compareHistCustom( InputArray _H1, InputArray _H2, int method )
-{
-    Mat H1 = _H1.getMat(), H2 = _H2.getMat();
-    const Mat* arrays[] = {&H1, &H2, 0};
-    Mat planes[2];
-    NAryMatIterator it(arrays, planes);
-    double result = 0;
-    int j, len = (int)it.size;
-
-    CV_Assert( H1.type() == H2.type() && H1.type() == CV_32F );
+    FrameBuffers buffers;
+    buffers.read(cap, metrics);
+    cascade.update(buffers.currFrame());
+    processedFrames++;
 
-    double s1 = 0, s2 = 0, s11 = 0, s12 = 0, s22 = 0;
+    std::unique_ptr<ResultWriter> results(openResultFile(resultFile, format, videoPath, (int) cap.get(CV_CAP_PROP_FPS),
+                                                         (int) cap.get(CV_CAP_PROP_FRAME_COUNT)));
+    writeShotEvent(*results, SHOT_BEGIN, (int) cap.get(CV_CAP_PROP_POS_FRAMES), cap.get(CV_CAP_PROP_POS_MSEC));
 
-    CV_Assert( it.planes[0].isContinuous() && it.planes[1].isContinuous() );
+    //store the shot frame to output path
+    string rootShotPath = shotPath(outputFileName);
+    KeyframeWriter writer(keyframeOptions, metrics);
+    keyframeWriter = &writer;
 
-    for( size_t i = 0; i < it.nplanes; i++, ++it )
-    {
-        const float* h1 = (const float*)it.planes[0].data;
-        const float* h2 = (const float*)it.planes[1].data;
-        len = it.planes[0].rows*it.planes[0].cols;
+    //save the inital frame which is the start of first shot.
+    storeFrame(rootShotPath, (int) cap.get(CV_CAP_PROP_POS_FRAMES), buffers.currFrame());
+    buffers.markQueued();
+    buffers.next();
 
-        if( method == CV_COMP_CHISQR )
-        {
-            for( j = 0; j < len; j++ )
-            {
-                double a = h1[j] - h2[j];
-                double b = h1[j] + h2[j];
-                if( fabs(b) > FLT_EPSILON )
-                    result += a*a/b;
-            }
-        }
-        else if( method == CV_COMP_CORREL )
-        {
-            for( j = 0; j < len; j++ )
+    while(1){
+        if(!buffers.read(cap, metrics)){
+            cout<<"empty frame!" << endl;
+            if(!state.shotFoundAtPrev)
             {
-                double a = h1[j];
-                double b = h2[j];
-
-                s12 += a*b;
-                s1 += a;
-                s11 += a*a;
-                s2 += b;
-                s22 += b*b;
+                int frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
+                writeShotEvent(*results, SHOT_END, frame_number, cap.get(CV_CAP_PROP_POS_MSEC));
+                storeFrame(rootShotPath, frame_number, buffers.prevFrame());
             }
+            break;
         }
-        else if( method == CV_COMP_INTERSECT )
-        {
-            for( j = 0; j < len; j++ )
-                result += std::min(h1[j], h2[j]);
-        }
-        else if( method == CV_COMP_BHATTACHARYYA )
+        processedFrames++;
+
+        ShotEvent event = state.update(cascade.update(buffers.currFrame()));
+        if(event != NO_EVENT)
         {
-            for( j = 0; j < len; j++ )
-            {
-                double a = h1[j];
-                double b = h2[j];
-                result += std::sqrt(a*b);
-                s1 += a;
-                s2 += b;
-            }
+            int frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
+            writeShotEvent(*results, event, frame_number, cap.get(CV_CAP_PROP_POS_MSEC));
+            storeFrame(rootShotPath, frame_number, buffers.currFrame());
+            buffers.markQueued();
         }
-        else
-            CV_Error( CV_StsBadArg, "Unknown comparison method" );
-    }
 
-    if( method == CV_COMP_CORREL )
-    {
-        size_t total = H1.total();
-        double scale = 1./total;
-        double num = s12 - s1*s2*scale;
-        double denom2 = (s11 - s1*s1*scale)*(s22 - s2*s2*scale);
-        result = std::abs(denom2) > DBL_EPSILON ? num/std::sqrt(denom2) : 1.;
-    }
-    else if( method == CV_COMP_BHATTACHARYYA )
-    {
-        s1 *= s2;
-        s1 = fabs(s1) > FLT_EPSILON ? 1./std::sqrt(s1) : 1.;
-        result = std::sqrt(std::max(1. - result*s1, 0.));
+        buffers.next();
     }
+    bufferReallocations = buffers.reallocations;
+    cascadeCounters = cascade.stats();
 
-    return result;
+    results->endShots();
+    closeResultFile(*results);
+    finishKeyframes(writer);
 }
 
+/**
+ * @brief ShotDetector::processVideo_Cached: Same as processVideo_NoGUI, but the distances of the frames are kept in
+ * a sidecar file (see SignatureCache). If the cache belongs to the video and was written with the same sampling
+ * and color space, the results are computed from it for the current threshold, adaptive threshold and sample
+ * period without decoding the video; keyframes are not stored in that case. Otherwise, or if gradual transitions
+ * are detected (they need the histograms), the video is processed by processVideo_NoGUI, which writes the cache.
+ * @param outputFileName: Results are stored in given filename
+ * @param format: Format type of output file. XML, YAML, TEXT, JSON or BINARY (see ResultWriter)
+ * @param cacheFile: sidecar file of the video
+ * @return: true if the results are computed from the cache
+ */
+bool ShotDetector::processVideo_Cached(std::string outputFileName, OutputFormat format, std::string cacheFile){
+    SignatureCache cache;
+    if(gradualWindow == 0 && cache.open(cacheFile) && cache.matches(videoPath, sampling, sampling_factor, yuvNative, tileGrid, tileIgnored)){
+        replayCache(cache, outputFileName, format);
+        return true;
+    }
+    cache.close();
+    if(cache.create(cacheFile, videoPath))
+        signatureCache = &cache;
+    processVideo_NoGUI(outputFileName, format);
+    signatureCache = 0;
+    return false;
+}
 
+/**
+ * @brief ShotDetector::replayCache: Replays the cached distances through the adaptive threshold, if enabled, and the
+ * shot state machine and writes the results like processVideo_NoGUI does.
+ */
+void ShotDetector::replayCache(SignatureCache &cache, std::string outputFileName, OutputFormat format){
+    const SignatureCache::Header &header = cache.header();
+    string resultFile = resultFileName(outputFileName, format);
+    ShotState state(sample_period);
+    std::unique_ptr<AdaptiveThreshold> adaptive(adaptiveWindow > 0 ? new AdaptiveThreshold(adaptiveWindow, adaptiveSigmas) : 0);
+    processedFrames = cache.frameCount();
+    bufferReallocations = 0;
+    keyframeStats = KeyframeWriter::Stats();
+
+    std::unique_ptr<ResultWriter> results(openResultFile(resultFile, format, videoPath, (int) header.fps,
+                                                         header.video_frame_count));
+    writeShotEvent(*results, SHOT_BEGIN, cache.record(0).frame_number, cache.record(0).time);
+
+    double frameThreshold = (header.flags & SignatureCache::YUV_HISTOGRAMS) ? yuvThreshold : threshold;
+    for(int i = 1; i < cache.frameCount(); i++){
+        const SignatureCache::Record &record = cache.record(i);
+        ShotEvent event = state.update(AdaptiveThreshold::decide(adaptive.get(), record.distance,
+                                                                 frameThreshold * record.pixels));
+        if(event != NO_EVENT)
+            writeShotEvent(*results, event, record.frame_number, record.time);
+    }
+    if(!state.shotFoundAtPrev)
+        writeShotEvent(*results, SHOT_END, header.end_frame_number, header.end_time);
+
+    results->endShots();
+    closeResultFile(*results);
+}
+
+/**
+ * @brief ShotDetector::cacheFrame: Appends a frame to the signature cache of the run, if any.
+ * @param distance: Chi-Square distance of bin counts to the previous frame
+ */
+void ShotDetector::cacheFrame(int frame_number, double time, double distance, const cv::Mat &frame){
+    if(!signatureCache)
+        return;
+    SignatureCache::Record record;
+    record.frame_number = frame_number;
+    record.pixels = (int) sampledPixelCount(frame);
+    record.time = time;
+    record.distance = distance;
+    signatureCache->append(record);
+}
+
+ShotDetector::FrameBuffers::FrameBuffers(): prev(1), histData(0), reallocations(0)
+{
+    queued[0] = queued[1] = false;
+}
+
+/**
+ * @brief ShotDetector::FrameBuffers::read: Decodes the next frame of cap into the current frame buffer.
+ * @param metrics: decoding time and decoded frames are added to it, unless it is null
+ * @return: false at the end of video
+ */
+bool ShotDetector::FrameBuffers::read(cv::VideoCapture &cap, RunMetrics *metrics){
+    int curr = 1 - prev;
+    //the keyframe writer still shares the pixels of a queued frame
+    if(queued[curr]){
+        frames[curr].release();
+        queued[curr] = false;
+    }
+    const uchar* frameData = frames[curr].data;
+    int64 start_t = RunMetrics::start(metrics);
+    cap >> frames[curr];
+    RunMetrics::stop(metrics, RunMetrics::DECODE, start_t);
+    if(frames[curr].empty())
+        return false;
+    if(metrics)
+        metrics->add(RunMetrics::FRAMES_DECODED, 1);
+    if(frameData != 0 && frames[curr].data != frameData)
+        reallocations++;
+    histData = hists[curr].data;
+    return true;
+}
+
+/**
+ * @brief ShotDetector::FrameBuffers::next: Makes the current frame and histogram the previous ones,
+ * must be called after the histogram of the current frame is computed.
+ */
+void ShotDetector::FrameBuffers::next(){
+    int curr = 1 - prev;
+    if(histData != 0 && hists[curr].data != histData)
+        reallocations++;
+    prev = curr;
+}
+
+/**
+ * @brief ShotDetector::FrameBuffers::markQueued: The current frame is queued to the keyframe writer,
+ * so its buffer must not be decoded into again.
+ */
+void ShotDetector::FrameBuffers::markQueued(){
+    queued[1 - prev] = true;
+}
+
+cv::Mat& ShotDetector::FrameBuffers::prevFrame(){
+    return frames[prev];
+}
+
+cv::Mat& ShotDetector::FrameBuffers::currFrame(){
+    return frames[1 - prev];
+}
+
+cv::MatND& ShotDetector::FrameBuffers::prevHist(){
+    return hists[prev];
+}
+
+cv::MatND& ShotDetector::FrameBuffers::currHist(){
+    return hists[1 - prev];
+}
+
+/**
+ * @brief ShotDetector::processVideo_Parallel: This method splits the video into num_threads segments
+ * and detects shot boundaries of each segment on its own thread with its own capture.
+ * Each segment also decodes the last frame of the previous segment, so every adjacent pair
+ * of frames is compared exactly once. The boundary decisions are merged in frame order
+ * and replayed through the same shot state machine as processVideo_NoGUI, hence the results
+ * are identical to the sequential run (provided that the backend seeks frame-accurately).
+ * @param outputFileName: Results are stored in given filename
+ * @param format: Format type of output file. XML, YAML, TEXT, JSON or BINARY (see ResultWriter)
+ * @param num_threads: Number of segments processed in parallel
+ */
+void ShotDetector::processVideo_Parallel(std::string outputFileName, OutputFormat format, int num_threads){
+    VideoCapture cap(videoPath);
+    if(!cap.isOpened()){
+        cout<<"error openning video!!" << endl;
+        return;
+    }
+    int frame_count = (int) cap.get(CV_CAP_PROP_FRAME_COUNT);
+    if(num_threads <= 1 || frame_count < 2 * num_threads){
+        cap.release();
+        processVideo_NoGUI(outputFileName, format);
+        return;
+    }
+
+    string resultFile = resultFileName(outputFileName, format);
+    string rootShotPath = shotPath(outputFileName);
+
+    //first frame is the start of the first shot, segments begin with the second frame.
+    Mat firstFrame;
+    cap >> firstFrame;
+    if(metrics)
+        metrics->add(RunMetrics::FRAMES_DECODED, 1);
+    int first_frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
+    double first_frame_time = cap.get(CV_CAP_PROP_POS_MSEC);
+    //workers of both passes queue their frames to the same writer
+    KeyframeWriter writer(keyframeOptions, metrics);
+    keyframeWriter = &writer;
+    storeFrame(rootShotPath, first_frame_number, firstFrame);
+
+    vector<Segment> segments(num_threads);
+    for(int k = 0; k < num_threads; k++){
+        Segment& segment = segments[k];
+        segment.first_frame = 1 + (int) ((int64) k * (frame_count - 1) / num_threads);
+        segment.last_frame = 1 + (int) ((int64) (k + 1) * (frame_count - 1) / num_threads);
+        segment.is_last = (k == num_threads - 1);
+    }
+    vector<std::thread> workers;
+    for(int k = 0; k < num_threads; k++){
+        workers.push_back(std::thread(&ShotDetector::detectSegment, this, std::ref(segments[k]), rootShotPath));
+    }
+    for(size_t k = 0; k < workers.size(); k++){
+        workers[k].join();
+    }
+    for(int k = 0; k < num_threads; k++){
+        if(segments[k].failed){
+            cout<<"error openning video in worker " << k << ", falling back to sequential processing" << endl;
+            cap.release();
+            finishKeyframes(writer);
+            processVideo_NoGUI(outputFileName, format);
+            return;
+        }
+    }
+
+    //store the result in xml format
+    std::unique_ptr<ResultWriter> results(openResultFile(resultFile, format, videoPath, (int) cap.get(CV_CAP_PROP_FPS),
+                                                         frame_count));
+    writeShotEvent(*results, SHOT_BEGIN, first_frame_number, first_frame_time);
+
+    /** replay the merged boundary decisions. Frames of a segment before its sync frame
+     * could not be decided by the worker, they are collected to be stored afterwards.
+     **/
+    ShotState state(sample_period);
+    vector< vector< pair<int, int> > > pendingFrames(num_threads);
+    processedFrames = 1;
+    bufferReallocations = 0;
+    for(int k = 0; k < num_threads; k++){
+        Segment& segment = segments[k];
+        bufferReallocations += segment.reallocations;
+        for(size_t j = 0; j < segment.boundary.size(); j++){
+            int frame_index = segment.first_frame + (int) j;
+            ShotEvent event = state.update(segment.boundary[j] != 0);
+            if(event != NO_EVENT)
+            {
+                writeShotEvent(*results, event, segment.frame_numbers[j], segment.frame_times[j]);
+                if(segment.sync_frame < 0 || frame_index < segment.sync_frame)
+                    pendingFrames[k].push_back(make_pair(frame_index, segment.frame_numbers[j]));
+            }
+        }
+        processedFrames += (int) segment.boundary.size();
+
+        if(segment.reached_end){
+            cout<<"empty frame!" << endl;
+            if(!state.shotFoundAtPrev)
+            {
+                writeShotEvent(*results, SHOT_END, segment.end_frame_number, segment.end_time);
+                if(!segment.end_frame_stored)
+                    pendingFrames[k].push_back(make_pair(segment.first_frame + (int) segment.boundary.size() - 1, segment.end_frame_number));
+            }
+            break;
+        }
+    }
+    results->endShots();
+    closeResultFile(*results);
+
+    workers.clear();
+    for(int k = 0; k < num_threads; k++){
+        if(!pendingFrames[k].empty())
+            workers.push_back(std::thread(&ShotDetector::storeFrames, this, segments[k].first_frame - 1, pendingFrames[k], rootShotPath));
+    }
+    for(size_t k = 0; k < workers.size(); k++){
+        workers[k].join();
+    }
+    finishKeyframes(writer);
+}
+
+/**
+ * @brief ShotDetector::processVideo_Pipelined: This method process video and detect shot boundaries
+ * at video without graphical interface, like processVideo_NoGUI. Decoding, histogram computation,
+ * boundary decision and output writing run on separate threads which are connected by bounded
+ * single-producer/single-consumer queues, so decoding never waits for the disk. Frames pass through
+ * every stage in order, so the results are identical to processVideo_NoGUI.
+ * Occupancy of each queue is printed at the end: a queue which is mostly full shows that the stage
+ * consuming it is the bottleneck, a queue which is mostly empty shows that its producer is.
+ * @param outputFileName: Results are stored in given filename
+ * @param format: Format type of output file. XML, YAML, TEXT, JSON or BINARY (see ResultWriter)
+ */
+void ShotDetector::processVideo_Pipelined(std::string outputFileName, OutputFormat format){
+    VideoCapture cap(videoPath);
+    string resultFile = resultFileName(outputFileName, format);
+    ShotState state(sample_period);
+    processedFrames = 0;
+
+    if(!cap.isOpened()){
+        cout<<"error openning video!!" << endl;
+        return;
+    }
+    requestUnconvertedFrames(cap);
+    Mat prevFrame;
+    MatND prevHist;
+
+    cap >> prevFrame;
+    if(metrics)
+        metrics->add(RunMetrics::FRAMES_DECODED, 1);
+    prepareFrameCounts(prevFrame, prevHist);
+    processedFrames++;
+
+    std::unique_ptr<ResultWriter> results(openResultFile(resultFile, format, videoPath, (int) cap.get(CV_CAP_PROP_FPS),
+                                                         (int) cap.get(CV_CAP_PROP_FRAME_COUNT)));
+    writeShotEvent(*results, SHOT_BEGIN, (int) cap.get(CV_CAP_PROP_POS_FRAMES), cap.get(CV_CAP_PROP_POS_MSEC));
+
+    //store the shot frame to output path
+    string rootShotPath = shotPath(outputFileName);
+    KeyframeWriter keyframes(keyframeOptions, metrics);
+    keyframeWriter = &keyframes;
+
+    //save the inital frame which is the start of first shot.
+    storeFrame(rootShotPath, (int) cap.get(CV_CAP_PROP_POS_FRAMES), prevFrame);
+
+    SPSCQueue<PipelineItem> decodedFrames(PIPELINE_QUEUE_SIZE);
+    SPSCQueue<PipelineItem> histograms(PIPELINE_QUEUE_SIZE);
+    SPSCQueue<PipelineItem> events(PIPELINE_QUEUE_SIZE);
+    std::thread decoder(&ShotDetector::decodeStage, this, std::ref(cap), std::ref(decodedFrames));
+    std::thread histogrammer(&ShotDetector::histogramStage, this, std::ref(decodedFrames), std::ref(histograms));
+    std::thread writer(&ShotDetector::writeStage, this, std::ref(events), std::ref(*results), rootShotPath);
+
+    //boundary decisions are taken on this thread
+    while(1){
+        PipelineItem item;
+        histograms.pop(item);
+        if(item.last){
+            cout<<"empty frame!" << endl;
+            if(!state.shotFoundAtPrev)
+            {
+                item.event = SHOT_END;
+                item.frame = prevFrame;
+            }
+            events.push(item);
+            break;
+        }
+        processedFrames++;
+
+        int64 start_t = RunMetrics::start(metrics);
+        item.event = state.update(frameBoundary(prevHist, item.hist, item.frame));
+        RunMetrics::stop(metrics, RunMetrics::COMPARE, start_t);
+        prevFrame = item.frame;
+        prevHist = item.hist;
+        if(item.event != NO_EVENT)
+        {
+            item.hist.release();
+            events.push(item);
+        }
+    }
+    decoder.join();
+    histogrammer.join();
+    writer.join();
+
+    results->endShots();
+    closeResultFile(*results);
+    finishKeyframes(keyframes);
+
+    cout << "pipeline queue occupancy (capacity " << PIPELINE_QUEUE_SIZE << "):" << endl;
+    cout << "  decode -> histogram : average " << decodedFrames.averageOccupancy()
+         << ", full " << 100 * decodedFrames.fullRatio() << "%, empty " << 100 * decodedFrames.emptyRatio() << "%" << endl;
+    cout << "  histogram -> detect : average " << histograms.averageOccupancy()
+         << ", full " << 100 * histograms.fullRatio() << "%, empty " << 100 * histograms.emptyRatio() << "%" << endl;
+    cout << "  detect -> write     : average " << events.averageOccupancy()
+         << ", full " << 100 * events.fullRatio() << "%, empty " << 100 * events.emptyRatio() << "%" << endl;
+}
+
+/**
+ * @brief ShotDetector::processVideo_Coarse: This method process video and detect shot boundaries at video
+ * without graphical interface, like processVideo_NoGUI, but compares the full histograms of every step'th
+ * frame only. Frames in between are grabbed without being retrieved, except the ones which are stored if the
+ * interval turns out to have no boundary (samples, the beginning of a shot). When the distance between the
+ * two ends of an interval exceeds the threshold, the interval is bisected with frame-accurate seeks until
+ * the boundary decisions of its adjacent frames are known, then the shot state machine is replayed on them.
+ * The results are identical to processVideo_NoGUI as long as no shot boundary is hidden inside an interval
+ * whose ends look alike (a cut and a cut back within step frames) and the backend seeks frame-accurately.
+ * @param outputFileName: Results are stored in given filename
+ * @param format: Format type of output file. XML, YAML, TEXT, JSON or BINARY (see ResultWriter)
+ * @param step: distance of compared frames, below 2 processVideo_NoGUI is used
+ */
+void ShotDetector::processVideo_Coarse(std::string outputFileName, OutputFormat format, int step){
+    if(step < 2){
+        processVideo_NoGUI(outputFileName, format);
+        return;
+    }
+    VideoCapture cap(videoPath);
+    string resultFile = resultFileName(outputFileName, format);
+    ShotState state(sample_period);
+    processedFrames = 0;
+    bufferReallocations = 0;
+    retrievedFrames = 0;
+    bisectedIntervals = 0;
+
+    if(!cap.isOpened()){
+        cout<<"error openning video!!" << endl;
+        return;
+    }
+    requestUnconvertedFrames(cap);
+
+    //retrieved frames of the current interval by frame index, the first one is the reference frame
+    std::map<int, CoarseFrame> frames;
+    int lo = 0;
+    CoarseFrame &first = frames[lo];
+    grabCoarseFrame(cap, first);
+    retrieveCoarseFrame(cap, first);
+    coarseHistogram(first);
+    processedFrames++;
+
+    std::unique_ptr<ResultWriter> results(openResultFile(resultFile, format, videoPath, (int) cap.get(CV_CAP_PROP_FPS),
+                                                         (int) cap.get(CV_CAP_PROP_FRAME_COUNT)));
+    writeShotEvent(*results, SHOT_BEGIN, first.frame_number, first.time);
+
+    //store the shot frame to output path
+    string rootShotPath = shotPath(outputFileName);
+    KeyframeWriter writer(keyframeOptions, metrics);
+    keyframeWriter = &writer;
+
+    //save the inital frame which is the start of first shot.
+    storeFrame(rootShotPath, first.frame_number, first.frame);
+
+    int end_frame_number = 0;
+    double end_time = 0;
+    bool reached_end = false;
+    while(!reached_end){
+        /** frames which produce an event if the interval has no boundary are retrieved while grabbing,
+         * so the common case needs no seek.
+         **/
+        ShotState predicted = state;
+        int hi = lo;
+        while(hi < lo + step){
+            CoarseFrame frame;
+            if(!grabCoarseFrame(cap, frame)){
+                reached_end = true;
+                end_frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
+                end_time = cap.get(CV_CAP_PROP_POS_MSEC);
+                break;
+            }
+            hi++;
+            processedFrames++;
+            if(predicted.update(false) != NO_EVENT || hi == lo + step){
+                retrieveCoarseFrame(cap, frame);
+                frames[hi] = frame;
+            }
+        }
+        if(hi == lo)
+            break;
+        //the last frame of a video is only known to be the last one after it is grabbed
+        if(frames.find(hi) == frames.end())
+            seekCoarseFrame(cap, hi, frames[hi]);
+        CoarseFrame &last = frames[hi];
+        coarseHistogram(last);
+
+        std::vector<char> boundary(hi - lo + 1, 0);
+        bool seeked = false;
+        if(coarseBoundary(frames[lo], last)){
+            bisectedIntervals++;
+            bisectInterval(cap, lo, lo, hi, frames, boundary);
+            seeked = true;
+        }
+
+        for(int j = lo + 1; j <= hi; j++){
+            ShotEvent event = state.update(boundary[j - lo] != 0);
+            if(event == NO_EVENT)
+                continue;
+            if(frames.find(j) == frames.end()){
+                seekCoarseFrame(cap, j, frames[j]);
+                seeked = true;
+            }
+            CoarseFrame &frame = frames[j];
+            writeShotEvent(*results, event, frame.frame_number, frame.time);
+            storeFrame(rootShotPath, frame.frame_number, frame.frame);
+        }
+        if(seeked && !reached_end)
+            cap.set(CV_CAP_PROP_POS_FRAMES, hi + 1);
+
+        //the last frame of the interval is the reference frame of the next one
+        CoarseFrame reference = last;
+        frames.clear();
+        frames[hi] = reference;
+        lo = hi;
+    }
+    cout<<"empty frame!" << endl;
+    if(!state.shotFoundAtPrev)
+    {
+        writeShotEvent(*results, SHOT_END, end_frame_number, end_time);
+        storeFrame(rootShotPath, end_frame_number, frames[lo].frame);
+    }
+
+    results->endShots();
+    closeResultFile(*results);
+    finishKeyframes(writer);
+}
+
+ShotDetector::CoarseFrame::CoarseFrame(): frame_number(0), time(0)
+{
+}
+
+/**
+ * @brief ShotDetector::grabCoarseFrame: Grabs the next frame of cap without retrieving it. The backend decodes
+ * the frame, so it is counted as a decoded frame.
+ * @return: false at the end of video
+ */
+bool ShotDetector::grabCoarseFrame(cv::VideoCapture &cap, CoarseFrame &frame){
+    int64 start_t = RunMetrics::start(metrics);
+    bool grabbed = cap.grab();
+    RunMetrics::stop(metrics, RunMetrics::DECODE, start_t);
+    if(!grabbed)
+        return false;
+    if(metrics)
+        metrics->add(RunMetrics::FRAMES_DECODED, 1);
+    frame.frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
+    frame.time = cap.get(CV_CAP_PROP_POS_MSEC);
+    return true;
+}
+
+/**
+ * @brief ShotDetector::retrieveCoarseFrame: Retrieves the frame grabbed last into frame, its conversion is
+ * recorded as a decode call.
+ */
+void ShotDetector::retrieveCoarseFrame(cv::VideoCapture &cap, CoarseFrame &frame){
+    int64 start_t = RunMetrics::start(metrics);
+    cap.retrieve(frame.frame);
+    RunMetrics::stop(metrics, RunMetrics::DECODE, start_t);
+    retrievedFrames++;
+}
+
+/**
+ * @brief ShotDetector::seekCoarseFrame: Seeks cap to the frame with the given index and retrieves it.
+ */
+void ShotDetector::seekCoarseFrame(cv::VideoCapture &cap, int index, CoarseFrame &frame){
+    cap.set(CV_CAP_PROP_POS_FRAMES, index);
+    if(grabCoarseFrame(cap, frame))
+        retrieveCoarseFrame(cap, frame);
+}
+
+/**
+ * @brief ShotDetector::coarseHistogram: Computes the histogram (bin counts) of a retrieved frame.
+ */
+void ShotDetector::coarseHistogram(CoarseFrame &frame){
+    int64 start_t = RunMetrics::start(metrics);
+    prepareFrameCounts(frame.frame, frame.hist);
+    RunMetrics::stop(metrics, RunMetrics::HISTOGRAM, start_t);
+}
+
+/**
+ * @brief ShotDetector::coarseBoundary: Boundary decision of two frames with histograms, see frameBoundary.
+ */
+bool ShotDetector::coarseBoundary(CoarseFrame &prevFrame, CoarseFrame &currFrame){
+    int64 start_t = RunMetrics::start(metrics);
+    bool boundary = frameBoundary(prevFrame.hist, currFrame.hist, currFrame.frame);
+    RunMetrics::stop(metrics, RunMetrics::COMPARE, start_t);
+    return boundary;
+}
+
+/**
+ * @brief ShotDetector::bisectInterval: Finds the boundary decisions of the adjacent frames in (lo, hi], given that
+ * the histograms of frames lo and hi differ by more than the threshold. The middle frame is compared with both
+ * ends and each half which still exceeds the threshold is bisected further; halves whose ends look alike are taken
+ * as having no boundary.
+ * @param origin: index of the first frame of the interval being processed, boundary[0] belongs to it
+ * @param frames: retrieved frames by index, frames lo and hi have their histograms
+ * @param boundary: boundary decisions of the interval, set to 1 for the frames found to be boundaries
+ */
+void ShotDetector::bisectInterval(cv::VideoCapture &cap, int origin, int lo, int hi, std::map<int, CoarseFrame> &frames,
+                                  std::vector<char> &boundary){
+    if(hi - lo == 1){
+        boundary[hi - origin] = 1;
+        return;
+    }
+    int mid = lo + (hi - lo) / 2;
+    if(frames.find(mid) == frames.end())
+        seekCoarseFrame(cap, mid, frames[mid]);
+    CoarseFrame &middle = frames[mid];
+    if(middle.hist.empty())
+        coarseHistogram(middle);
+    if(coarseBoundary(frames[lo], middle))
+        bisectInterval(cap, origin, lo, mid, frames, boundary);
+    if(coarseBoundary(middle, frames[hi]))
+        bisectInterval(cap, origin, mid, hi, frames, boundary);
+}
+
+/**
+ * @brief ShotDetector::processStream: This method detects shot boundaries of uncompressed frames read from
+ * stdin, a file or a named pipe (see RawFrameSource), without graphical interface. Results are stored in
+ * a file like processVideo_NoGUI, through a ShotStream. Frames are processed in place in the buffers of the source; frame numbers
+ * and times count the frames of the source, including the ones dropped by its drop policy.
+ * The latency from the arrival of each frame to its boundary decision is kept (see decisionLatency).
+ * @param source: source of frames, opened by this method
+ * @param outputFileName: Results are stored in given filename
+ * @param format: Format type of output file. XML, YAML, TEXT, JSON or BINARY (see ResultWriter)
+ */
+void ShotDetector::processStream(RawFrameSource &source, std::string outputFileName, OutputFormat format){
+    string resultFile = resultFileName(outputFileName, format);
+    processedFrames = 0;
+    latencies.clear();
+
+    if(!source.open()){
+        cout<<"error openning stream!!" << endl;
+        return;
+    }
+    double frame_ms = 1000. / source.fps();
+    RawFrameSource::Frame prevFrame, currFrame;
+    if(!source.read(prevFrame)){
+        cout<<"empty stream!" << endl;
+        source.close();
+        return;
+    }
+
+    std::unique_ptr<ResultWriter> results(openResultFile(resultFile, format, source.name(), (int) source.fps(), 0));
+
+    string rootShotPath = shotPath(outputFileName);
+    KeyframeWriter writer(keyframeOptions, metrics);
+    keyframeWriter = &writer;
+
+    vector<GradualDetector::Transition> transitions;
+    ShotStream stream(*this);
+    stream.onEvent([&](ShotEvent event, int frame_number, double time, const cv::Mat &frame){
+        writeShotEvent(*results, event, frame_number, time);
+        //buffers of the source are reused, so stored frames are copied
+        Mat keyframe = frame.clone();
+        storeFrame(rootShotPath, frame_number, keyframe);
+    });
+    stream.onTransition([&](const GradualDetector::Transition &transition){
+        addGradualTransition(transitions, transition);
+    });
+
+    //images of the previous and current frames: BGR24 frames are only wrapped, YUV4MPEG frames are converted
+    //to BGR unless their histograms are computed in YUV
+    bool yuv = yuvNative && source.inputFormat() == RawFrameSource::YUV4MPEG;
+    Mat images[2];
+    int prev = 0;
+    if(yuv)
+        images[prev] = prevFrame.image;
+    else
+        source.toBGR(prevFrame, images[prev]);
+    stream.feed(images[prev], prevFrame.index + 1, prevFrame.index * frame_ms);
+    processedFrames++;
+    latencies.push_back(1000. * (getTickCount() - prevFrame.arrival) / getTickFrequency());
+
+    while(1){
+        if(!source.read(currFrame)){
+            cout<<"end of stream!" << endl;
+            stream.finish();
+            break;
+        }
+        processedFrames++;
+
+        int curr = 1 - prev;
+        if(yuv)
+            images[curr] = currFrame.image;
+        else
+            source.toBGR(currFrame, images[curr]);
+        stream.feed(images[curr], currFrame.index + 1, currFrame.index * frame_ms);
+        latencies.push_back(1000. * (getTickCount() - currFrame.arrival) / getTickFrequency());
+
+        //the buffer of the previous frame goes back to the source
+        source.release(prevFrame);
+        prevFrame = currFrame;
+        prev = curr;
+    }
+    source.release(prevFrame);
+    source.close();
+
+    results->endShots();
+    if(gradualWindow > 0)
+        writeGradualTransitions(*results, transitions);
+    closeResultFile(*results);
+    finishKeyframes(writer);
+}
+
+ShotDetector::PipelineItem::PipelineItem(): frame_number(0), time(0), event(NO_EVENT), last(false)
+{
+}
+
+/**
+ * @brief ShotDetector::decodeStage: First stage of processVideo_Pipelined, reads frames until the end of video.
+ */
+void ShotDetector::decodeStage(cv::VideoCapture &cap, SPSCQueue<PipelineItem> &output){
+    while(1){
+        PipelineItem item;
+        int64 start_t = RunMetrics::start(metrics);
+        cap >> item.frame;
+        RunMetrics::stop(metrics, RunMetrics::DECODE, start_t);
+        item.frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
+        item.time = cap.get(CV_CAP_PROP_POS_MSEC);
+        item.last = item.frame.empty();
+        if(metrics && !item.last)
+            metrics->add(RunMetrics::FRAMES_DECODED, 1);
+        output.push(item);
+        if(item.last)
+            break;
+    }
+}
+
+/**
+ * @brief ShotDetector::histogramStage: Second stage of processVideo_Pipelined, computes histograms of frames.
+ */
+void ShotDetector::histogramStage(SPSCQueue<PipelineItem> &input, SPSCQueue<PipelineItem> &output){
+    while(1){
+        PipelineItem item;
+        input.pop(item);
+        if(!item.last){
+            int64 start_t = RunMetrics::start(metrics);
+            prepareFrameCounts(item.frame, item.hist);
+            RunMetrics::stop(metrics, RunMetrics::HISTOGRAM, start_t);
+        }
+        output.push(item);
+        if(item.last)
+            break;
+    }
+}
+
+/**
+ * @brief ShotDetector::writeStage: Last stage of processVideo_Pipelined, writes events and stores their frames.
+ */
+void ShotDetector::writeStage(SPSCQueue<PipelineItem> &input, ResultWriter &results, std::string rootShotPath){
+    while(1){
+        PipelineItem item;
+        input.pop(item);
+        if(item.event != NO_EVENT)
+        {
+            writeShotEvent(results, item.event, item.frame_number, item.time);
+            storeFrame(rootShotPath, item.frame_number, item.frame);
+        }
+        if(item.last)
+            break;
+    }
+}
+
+/**
+ * @brief ShotDetector::detectSegment: Worker of processVideo_Parallel. Computes the boundary decision
+ * of every frame in the segment. Once a shot end is seen inside the segment, the shot state is known
+ * locally and the frames of the following events are stored by the worker itself.
+ * @param segment: segment to be processed, results are stored into it
+ * @param rootShotPath: directory of stored frames
+ */
+void ShotDetector::detectSegment(Segment &segment, std::string rootShotPath){
+    segment.failed = false;
+    segment.sync_frame = -1;
+    segment.reached_end = false;
+    segment.end_frame_stored = false;
+    segment.reallocations = 0;
+
+    VideoCapture cap(videoPath);
+    if(!cap.isOpened()){
+        segment.failed = true;
+        return;
+    }
+    requestUnconvertedFrames(cap);
+    //one frame overlap: the last frame of the previous segment is the reference of the first comparison
+    FrameBuffers buffers;
+    if(segment.first_frame > 1)
+        cap.set(CV_CAP_PROP_POS_FRAMES, segment.first_frame - 1);
+    if(!buffers.read(cap)){
+        segment.reached_end = true;
+        segment.end_frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
+        segment.end_time = cap.get(CV_CAP_PROP_POS_MSEC);
+        return;
+    }
+    prepareFrameCounts(buffers.currFrame(), buffers.currHist());
+    buffers.next();
+    ShotState state(sample_period);
+
+    for(int frame_index = segment.first_frame; segment.is_last || frame_index < segment.last_frame; frame_index++){
+        if(!buffers.read(cap, metrics)){
+            segment.reached_end = true;
+            segment.end_frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
+            segment.end_time = cap.get(CV_CAP_PROP_POS_MSEC);
+            if(!segment.boundary.empty() && !segment.boundary.back())
+            {
+                storeFrame(rootShotPath, segment.end_frame_number, buffers.prevFrame());
+                segment.end_frame_stored = true;
+            }
+            break;
+        }
+        int64 start_t = RunMetrics::start(metrics);
+        prepareFrameCounts(buffers.currFrame(), buffers.currHist());
+        RunMetrics::stop(metrics, RunMetrics::HISTOGRAM, start_t);
+        start_t = RunMetrics::start(metrics);
+        bool result = frameBoundary(buffers.prevHist(), buffers.currHist(), buffers.currFrame());
+        RunMetrics::stop(metrics, RunMetrics::COMPARE, start_t);
+        int frame_number = (int) cap.get(CV_CAP_PROP_POS_FRAMES);
+
+        /** a boundary following a non-boundary frame always ends the current shot,
+         * regardless of the events before this segment, and resets the frame counter.
+         **/
+        if(segment.sync_frame < 0 && result && !segment.boundary.empty() && !segment.boundary.back())
+        {
+            state.shotFoundAtPrev = false;
+            state.shotStartStored = true;
+            segment.sync_frame = frame_index;
+        }
+        segment.boundary.push_back(result);
+        segment.frame_numbers.push_back(frame_number);
+        segment.frame_times.push_back(cap.get(CV_CAP_PROP_POS_MSEC));
+
+        if(segment.sync_frame >= 0 && state.update(result) != NO_EVENT)
+        {
+            storeFrame(rootShotPath, frame_number, buffers.currFrame());
+            buffers.markQueued();
+        }
+
+        buffers.next();
+    }
+    segment.reallocations = buffers.reallocations;
+}
+
+/**
+ * @brief ShotDetector::storeFrames: Stores the given frames of the video by decoding forward from first_frame.
+ * @param first_frame: index of the frame where decoding starts
+ * @param frames: sorted (frame index, frame number) pairs to be stored
+ * @param rootShotPath: directory of stored frames
+ */
+void ShotDetector::storeFrames(int first_frame, std::vector<std::pair<int, int> > frames, std::string rootShotPath){
+    VideoCapture cap(videoPath);
+    if(!cap.isOpened()){
+        cout << "error openning video!" <<endl;
+        return;
+    }
+    cap.set(CV_CAP_PROP_POS_FRAMES, first_frame);
+    int frame_index = first_frame;
+    for(size_t i = 0; i < frames.size(); i++){
+        while(frame_index < frames[i].first && cap.grab())
+            frame_index++;
+        Mat frame;
+        cap >> frame;
+        frame_index++;
+        if(frame.empty())
+            break;
+        storeFrame(rootShotPath, frames[i].second, frame);
+    }
+}
+
+/**
+ * @brief ShotDetector::writeShotEvent: Writes the given event of a frame to the result file.
+ * @param results: result file
+ * @param event: event to be written
+ * @param frame_number: frame number of the event
+ * @param time: position of the frame in miliseconds
+ */
+void ShotDetector::writeShotEvent(ResultWriter &results, ShotEvent event, int frame_number, double time){
+    int64 start_t = RunMetrics::start(metrics);
+    if(event == SHOT_BEGIN){
+        results.shotBegin(frame_number, time);
+        streamEvent("shot_begin", frame_number, time);
+    }else if(event == SHOT_END){
+        results.shotEnd(frame_number, time);
+        streamEvent("shot_end", frame_number, time);
+    }else if(event == SHOT_SAMPLE){
+        results.shotSample(frame_number, time);
+        streamEvent("sample", frame_number, time);
+    }
+    if(metrics){
+        RunMetrics::stop(metrics, RunMetrics::STORAGE, start_t);
+        if(event == SHOT_END)
+            metrics->add(RunMetrics::BOUNDARIES, 1);
+    }
+}
+
+/**
+ * @brief ShotDetector::addGradualTransition: Keeps a gradual transition for the result file and streams its
+ * begin and end as transition_begin and transition_end events.
+ */
+void ShotDetector::addGradualTransition(std::vector<GradualDetector::Transition> &transitions,
+                                        const GradualDetector::Transition &transition){
+    transitions.push_back(transition);
+    streamEvent("transition_begin", transition.begin_frame_number, transition.begin_time);
+    streamEvent("transition_end", transition.end_frame_number, transition.end_time);
+}
+
+/**
+ * @brief ShotDetector::writeGradualTransitions: Writes the gradual transitions of the video after the shots,
+ * as a GradualTransitions list of begin and end frames.
+ */
+void ShotDetector::writeGradualTransitions(ResultWriter &results, const std::vector<GradualDetector::Transition> &transitions){
+    results.writeTransitions(transitions);
+}
+
+/**
+ * @brief ShotDetector::openResultFile: Opens the result file of the given format, writes its header
+ * and begins the list of shots.
+ * @param threshold: threshold written to the header, not written if negative
+ */
+ResultWriter* ShotDetector::openResultFile(const std::string &resultFile, OutputFormat format, const std::string &video_path,
+                                           int fps, int frame_count, double threshold){
+    ResultWriter *results = ResultWriter::create((ResultWriter::Format) format, resultFile);
+    if(!results->isOpened())
+        cout<<"error openning result file " << resultFile << endl;
+    ResultWriter::Header header;
+    header.video_path = video_path;
+    header.fps = fps;
+    header.frame_count = frame_count;
+    header.threshold = threshold;
+    results->writeHeader(header);
+    results->beginShots();
+    return results;
+}
+
+/**
+ * @brief ShotDetector::closeResultFile: Closes the result file, counting the time and the bytes written to metrics.
+ */
+void ShotDetector::closeResultFile(ResultWriter &results){
+    int64 start_t = RunMetrics::start(metrics);
+    int64 bytes = results.close();
+    if(metrics){
+        RunMetrics::stop(metrics, RunMetrics::STORAGE, start_t);
+        metrics->add(RunMetrics::BYTES_WRITTEN, bytes);
+    }
+}
+
+/**
+ * @brief ShotDetector::streamEvent: Writes an event as a single line JSON record to the event stream
+ * (if one is set) and flushes it, so a reader of the stream gets the event as soon as it is decided:
+ * {"video_path":"...","event":"shot_begin","frame_number":1,"time_ms":0,"time":"00:00"}
+ * Detectors sharing a stream write whole lines, records of different videos are told apart by video_path.
+ * @param event: shot_begin, shot_end, sample or aborted
+ * @param frame_number: frame number of the event
+ * @param time: position of the frame in miliseconds
+ */
+void ShotDetector::streamEvent(const char *event, int frame_number, double time){
+    if(!eventStream)
+        return;
+    stringstream record;
+    record << "{\"video_path\":\"";
+    for(size_t i = 0; i < videoPath.size(); i++){
+        unsigned char c = videoPath[i];
+        if(c == '"' || c == '\\')
+            record << '\\' << c;
+        else if(c < 0x20)
+            record << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 0xF];
+        else
+            record << c;
+    }
+    record << "\",\"event\":\"" << event << "\",\"frame_number\":" << frame_number
+           << ",\"time_ms\":" << std::fixed << std::setprecision(3) << time
+           << ",\"time\":\"" << miliseconds_to_DHMS( time ) << "\"}\n";
+
+    static std::mutex streamMutex;
+    std::lock_guard<std::mutex> lock(streamMutex);
+    *eventStream << record.str();
+    eventStream->flush();
+}
+
+/**
+ * @brief ShotDetector::setEventStream: Sets the stream which receives every shot event as a line of JSON
+ * (see streamEvent), e.g. std::cout, a file or a named pipe. The stream is not owned, 0 disables streaming.
+ */
+void ShotDetector::setEventStream(std::ostream *stream){
+    eventStream = stream;
+}
+
+/**
+ * @brief ShotDetector::setGradualWindow: Enables the gradual transition detector of processVideo_NoGUI
+ * (see GradualDetector), which finds fades and dissolves of up to window frames and writes them to the
+ * GradualTransitions list of the result file. 0 (the default) disables it. Shots are detected as before.
+ */
+void ShotDetector::setGradualWindow(int window){
+    gradualWindow = window;
+}
+
+/**
+ * @brief ShotDetector::setAdaptiveThreshold: Makes processVideo_NoGUI and the replay of processVideo_Cached decide
+ * boundaries relative to the rolling mean and standard deviation of the last window distances (see
+ * AdaptiveThreshold) instead of the fixed threshold, which then only scales the distances. 0 (the default) keeps the fixed threshold.
+ * @param window: number of recent distances of the rolling statistics
+ * @param sigmas: standard deviations above the rolling mean of a boundary
+ */
+void ShotDetector::setAdaptiveThreshold(int window, double sigmas){
+    adaptiveWindow = window;
+    adaptiveSigmas = sigmas;
+}
+
+/**
+ * @brief ShotDetector::setTileGrid: Makes the detection loops count the BGR histogram of every frame per tile of a
+ * grid x grid split (see calcColorHistTiles) and compare the frames tile by tile (see histDistance). Cuts
+ * between shots of similar overall color but different layout are found, and motion in a few tiles is ignored.
+ * Tile distances add up to more than the distance of whole frame histograms, so thresholds tuned for them
+ * have to be raised (see -benchtiles). The gradual transition detector compares all tiles of two frames at once.
+ * 0 or 1 (the default) keeps a single histogram per frame. YUV frames are not tiled.
+ * @param grid: tiles per side, e.g. 2 or 4
+ * @param ignored: largest tile distances dropped from the distance of a frame
+ */
+void ShotDetector::setTileGrid(int grid, int ignored){
+    tileGrid = std::min(std::max(grid, 0), TILE_GRID_MAX);
+    tileIgnored = tileGrid > 1 ? std::min(std::max(ignored, 0), tileGrid * tileGrid - 1) : 0;
+}
+
+/**
+ * @brief ShotDetector::setSeekIndex: Makes processVideo_NoGUI write the seek index of the video (see SeekIndex)
+ * to path while it decodes the frames, and extractKeyframes and getShotFromVideo seek with it once it belongs
+ * to the video. An empty path (the default) disables the index.
+ * @param keyframe_interval: frames from one keyframe of the video to the next, 0 if not known
+ */
+void ShotDetector::setSeekIndex(std::string path, int keyframe_interval){
+    seekIndexPath = path;
+    seekKeyframeInterval = keyframe_interval;
+}
+
+/**
+ * @brief ShotDetector::setCheckpoint: Makes processVideo_NoGUI write its state to a checkpoint file every period
+ * seconds (see Checkpoint), which is removed when the run completes. A run with resume continues after the last
+ * frame of the checkpoint, if the file belongs to the video and was written with the same settings, and writes
+ * the same results as an uninterrupted run. An empty path (the default) disables checkpoints.
+ */
+void ShotDetector::setCheckpoint(std::string path, double period, bool resume){
+    checkpointPath = path;
+    checkpointPeriod = period > 0 ? period : DEFAULT_CHECKPOINT_PERIOD;
+    resumeRun = resume;
+}
+
+/**
+ * @brief ShotDetector::checkpointStats: Returns the checkpoints written by the last processVideo_NoGUI run.
+ */
+ShotDetector::CheckpointStats ShotDetector::checkpointStats() const{
+    return checkpointCounters;
+}
+
+/**
+ * @brief ShotDetector::setMetrics: Sets the counters of stage times, frames, boundaries and bytes written
+ * (see RunMetrics), which are added to by processVideo_NoGUI, processVideo_Parallel and processVideo_Pipelined.
+ * The metrics are not owned, 0 (the default) disables them.
+ */
+void ShotDetector::setMetrics(RunMetrics *metrics){
+    this->metrics = metrics;
+}
+
+/**
+ * @brief ShotDetector::setYUVNative: Computes histograms of the detection loops directly on the YUV frames of
+ * the decoder (or of a YUV4MPEG stream), without converting every frame to BGR. Backends which cannot deliver
+ * unconverted frames fall back to BGR histograms and the BGR threshold. The GUI mode always uses BGR frames.
+ * @param enabled: enables the YUV native mode
+ * @param yuv_threshold: Chi-Square threshold of normalized YUV histograms, calibrated for the BGR threshold
+ * with -benchyuv
+ */
+void ShotDetector::setYUVNative(bool enabled, double yuv_threshold){
+    yuvNative = enabled;
+    yuvThreshold = yuv_threshold;
+}
+
+/**
+ * @brief ShotDetector::storeFrame: Queues the frame to the keyframe writer of the current run, to be stored
+ * as frame_<frame_number> under rootShotPath with the extension of the keyframe format.
+ * The writer shares the pixels of frame, which must not be written afterwards.
+ * Unconverted YUV frames are converted to BGR here, only for the frames which are stored.
+ */
+void ShotDetector::storeFrame(std::string rootShotPath, int frame_number, cv::Mat &frame){
+    stringstream framestream;
+    framestream << "frame_" << frame_number;
+    rootShotPath.append(framestream.str());
+    int layout = yuvLayout(frame);
+    if(layout >= 0){
+        Mat bgr;
+        cvtColor(frame, bgr, layout == YUV_I420 ? CV_YUV2BGR_I420 : CV_YUV2BGR_YUY2);
+        keyframeWriter->write(rootShotPath, bgr);
+        return;
+    }
+    keyframeWriter->write(rootShotPath, frame);
+}
+
+/**
+ * @brief ShotDetector::finishKeyframes: Waits until every keyframe of the run is written and keeps the writer statistics.
+ */
+void ShotDetector::finishKeyframes(KeyframeWriter &writer){
+    writer.close();
+    keyframeStats = writer.stats();
+    keyframeWriter = 0;
+}
+
+/**
+ * @brief ShotDetector::setKeyframeOptions: Sets the format, quality, thumbnail size and writer threads of stored keyframes.
+ */
+void ShotDetector::setKeyframeOptions(const KeyframeWriter::Options &options){
+    keyframeOptions = options;
+}
+
+/**
+ * @brief ShotDetector::cascadeStats: Returns the frames evaluated and passed and the time of each stage of the last
+ * processVideo_Cascade run.
+ */
+CascadeDetector::Stats ShotDetector::cascadeStats() const{
+    return cascadeCounters;
+}
+
+/**
+ * @brief ShotDetector::keyframeWriterStats: Returns the backpressure statistics of the keyframe writer of the last run.
+ */
+KeyframeWriter::Stats ShotDetector::keyframeWriterStats() const{
+    return keyframeStats;
+}
+
+/**
+ * @brief ShotDetector::shotPath: Returns the output path with a trailing path separator.
+ */
+std::string ShotDetector::shotPath(std::string outputFileName){
+#ifdef _WIN32
+    string rootShotPath(outputFileName);
+    if(outputFileName.at(outputFileName.size() -1) != '\\')
+        rootShotPath.append("\\");
+#else
+    string rootShotPath(outputFileName);
+    if(outputFileName.at(outputFileName.size() -1) != '/')
+        rootShotPath.append("/");
+#endif
+    return rootShotPath;
+}
+
+/**
+ * @brief ShotDetector::resultFileName: Creates output directory if not exists and
+ * returns the name of result file for given format.
+ */
+std::string ShotDetector::resultFileName(std::string outputFileName, OutputFormat format){
+    //create directory if not exists
+    if(!ResultWriter::createDirectories(outputFileName))
+        cout<<"error creating output directory " << outputFileName << endl;
+    return outputFileName + ResultWriter::extension((ResultWriter::Format) format);
+}
+
+/**
+ * @brief ShotDetector::sweepFileName: Returns the result file of a threshold of processVideo_Sweep,
+ * which is resultFile with _t<threshold> inserted before its extension.
+ */
+std::string ShotDetector::sweepFileName(std::string resultFile, double threshold){
+    stringstream suffix;
+    suffix << "_t" << threshold;
+    size_t extension = resultFile.rfind('.');
+    return resultFile.insert(extension == string::npos ? resultFile.size() : extension, suffix.str());
+}
+
+/**
+ * @brief ShotDetector::processedFrameCount: Number of frames processed by the last processVideo_NoGUI,
+ * processVideo_Parallel, processVideo_Pipelined or processVideo_Coarse run.
+ */
+int ShotDetector::processedFrameCount() const{
+    return processedFrames;
+}
+
+/**
+ * @brief ShotDetector::bufferReallocationCount: Returns how many times the detection loop of the last run
+ * (processVideo_NoGUI or the workers of processVideo_Parallel) reallocated one of its frame or histogram
+ * buffers although it could have been reused, 0 when the loop keeps decoding and computing into the same
+ * buffers. Only these buffers are watched, other heap allocations (inside OpenCV, result lists, sidecar
+ * files) are not counted. The decode buffer of a frame queued to the keyframe writer is replaced by design,
+ * one new buffer per keyframe, and not counted either.
+ */
+int ShotDetector::bufferReallocationCount() const{
+    return bufferReallocations;
+}
+
+/**
+ * @brief ShotDetector::decisionLatency: Returns the given percentile (0-100) of the latencies from the arrival
+ * of a frame to its boundary decision in the last processStream run, in miliseconds (100 gives the maximum).
+ */
+double ShotDetector::decisionLatency(double percentile) const{
+    if(latencies.empty())
+        return 0;
+    std::vector<double> sorted(latencies);
+    size_t rank = (size_t) (percentile / 100. * (sorted.size() - 1) + 0.5);
+    rank = std::min(rank, sorted.size() - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+/**
+ * @brief ShotDetector::retrievedFrameCount: Number of frames retrieved (converted and counted in a histogram)
+ * by the last processVideo_Coarse run, the other frames were only grabbed.
+ */
+int ShotDetector::retrievedFrameCount() const{
+    return retrievedFrames;
+}
+
+/**
+ * @brief ShotDetector::bisectedIntervalCount: Number of intervals of the last processVideo_Coarse run whose
+ * end points differed by more than the threshold and were bisected.
+ */
+int ShotDetector::bisectedIntervalCount() const{
+    return bisectedIntervals;
+}
+
+/**
+ * @brief ShotDetector::miliseconds_to_DHMS: This method converts time interval in miliseconds format to Day-Hour-Minute-Second format
+ * @param duration: duration in miliseconds
+ * @return: Returns D:H:M:S format as a string
+ */
+std::string ShotDetector::miliseconds_to_DHMS(double duration){
+    char buffer[RESULT_TIME_LENGTH];
+    int buffer_length = ResultWriter::formatTime(duration, buffer);
+    std::string result(buffer, buffer_length);
+    return result;
+}
+
+/**
+ * @brief ShotDetector::extractKeyframes: Stores the given frames of the video under outputFileName like the
+ * keyframes of a detection run (frame_<frame_number>), reading them with a single capture (see FrameExtractor)
+ * and encoding them on the keyframe writer while the next ones are decoded.
+ * @param frame_numbers: frame numbers of the result file, e.g. the begin_frame_number of every shot
+ * @return: number of frames stored
+ */
+int ShotDetector::extractKeyframes(const std::vector<int> &frame_numbers, std::string outputFileName){
+    extractStats = FrameExtractor::Stats();
+    FrameExtractor extractor(videoPath);
+    if(!extractor.isOpened()){
+        cout<<"error openning video!!" << endl;
+        return 0;
+    }
+    if(!ResultWriter::createDirectories(outputFileName))
+        cout<<"error creating output directory " << outputFileName << endl;
+    string rootShotPath = shotPath(outputFileName);
+    SeekIndex seekIndex;
+    if(openSeekIndex(seekIndex))
+        extractor.setSeekIndex(&seekIndex);
+    KeyframeWriter writer(keyframeOptions, metrics);
+    keyframeWriter = &writer;
+    int stored = extractor.extract(frame_numbers, [&](int frame_number, const Mat &frame){
+        //the extractor retrieves every frame into a new buffer, which the writer can share
+        Mat shared = frame;
+        storeFrame(rootShotPath, frame_number, shared);
+    });
+    finishKeyframes(writer);
+    extractStats = extractor.stats();
+    return stored;
+}
+
+/**
+ * @brief ShotDetector::extractionStats: Returns the seeks and grabs of the last extractKeyframes run.
+ */
+FrameExtractor::Stats ShotDetector::extractionStats() const{
+    return extractStats;
+}
+
+/**
+ * @brief ShotDetector::saveCheckpoint: Writes the state of processVideo_NoGUI after the last fed frame to the
+ * checkpoint file: the settings it depends on, the events and gradual transitions so far and the state of the
+ * stream. The keyframes of the events are written first, so a resumed run does not need to store them again.
+ */
+void ShotDetector::saveCheckpoint(const ShotStream &stream, const std::vector<ResultWriter::BinaryRecord> &events,
+                                  const std::vector<GradualDetector::Transition> &transitions, KeyframeWriter &writer,
+                                  OutputFormat format){
+    int64 start_t = getTickCount();
+    writer.wait();
+    Checkpoint checkpoint;
+    putCheckpointSettings(checkpoint, format);
+    checkpoint.putInt((int64) events.size());
+    for(size_t i = 0; i < events.size(); i++){
+        checkpoint.putInt(events[i].kind);
+        checkpoint.putInt(events[i].frame_number);
+        checkpoint.putDouble(events[i].time);
+    }
+    checkpoint.putInt((int64) transitions.size());
+    for(size_t i = 0; i < transitions.size(); i++)
+        GradualDetector::saveTransition(checkpoint, transitions[i]);
+    stream.saveState(checkpoint);
+    if(checkpoint.write(checkpointPath, videoPath, stream.frameCount())){
+        checkpointCounters.written++;
+        checkpointCounters.bytes = checkpoint.size();
+    }
+    checkpointCounters.seconds += (getTickCount() - start_t) / getTickFrequency();
+}
+
+/**
+ * @brief ShotDetector::resumeCheckpoint: Continues processVideo_NoGUI from the checkpoint file: the last frame of
+ * the checkpoint is sought and decoded again, the stream state is restored once the frame is verified (see
+ * ShotStream::restore) and the events so far are written to the result file. A backend which does not seek to
+ * the exact frame decodes forward from the first frame instead.
+ * @return: false if there is no checkpoint of the video with the same settings, the run starts from the first frame
+ */
+bool ShotDetector::resumeCheckpoint(cv::VideoCapture &cap, FrameBuffers &buffers, ShotStream &stream, ResultWriter &results,
+                                    std::vector<ResultWriter::BinaryRecord> &events,
+                                    std::vector<GradualDetector::Transition> &transitions, OutputFormat format){
+    Checkpoint checkpoint;
+    if(!checkpoint.read(checkpointPath)){
+        cout << "no checkpoint in " << checkpointPath << ", starting from the first frame" << endl;
+        return false;
+    }
+    if(!checkpoint.matches(videoPath) || !sameCheckpointSettings(checkpoint, format)){
+        cout << "checkpoint " << checkpointPath << " belongs to another video or other settings, starting from the first frame" << endl;
+        return false;
+    }
+    vector<ResultWriter::BinaryRecord> savedEvents((size_t) std::max<int64>(checkpoint.getInt(), 0));
+    for(size_t i = 0; i < savedEvents.size() && !checkpoint.failed(); i++){
+        savedEvents[i].kind = (int32_t) checkpoint.getInt();
+        savedEvents[i].frame_number = (int32_t) checkpoint.getInt();
+        savedEvents[i].time = checkpoint.getDouble();
+    }
+    vector<GradualDetector::Transition> savedTransitions((size_t) std::max<int64>(checkpoint.getInt(), 0));
+    for(size_t i = 0; i < savedTransitions.size() && !checkpoint.failed(); i++)
+        GradualDetector::loadTransition(checkpoint, savedTransitions[i]);
+    if(checkpoint.failed()){
+        cout << "error reading checkpoint " << checkpointPath << ", starting from the first frame" << endl;
+        return false;
+    }
+
+    size_t streamState = checkpoint.tell();
+    int last = checkpoint.frameCount() - 1;
+    bool restored = false;
+    for(int attempt = 0; attempt < 2 && !restored; attempt++){
+        if(attempt == 0){
+            cap.set(CV_CAP_PROP_POS_FRAMES, last);
+        }else{
+            cap.set(CV_CAP_PROP_POS_FRAMES, 0);
+            for(int i = 0; i < last && cap.grab(); i++);
+        }
+        checkpoint.seek(streamState);
+        restored = buffers.read(cap) && stream.restore(checkpoint, buffers.currFrame(), (int) cap.get(CV_CAP_PROP_POS_FRAMES));
+    }
+    if(!restored){
+        cout << "error resuming from checkpoint " << checkpointPath << ", starting from the first frame" << endl;
+        cap.set(CV_CAP_PROP_POS_FRAMES, 0);
+        return false;
+    }
+    buffers.next();
+
+    for(size_t i = 0; i < savedEvents.size(); i++){
+        const ResultWriter::BinaryRecord &record = savedEvents[i];
+        if(record.kind == SHOT_BEGIN)
+            results.shotBegin(record.frame_number, record.time);
+        else if(record.kind == SHOT_END)
+            results.shotEnd(record.frame_number, record.time);
+        else if(record.kind == SHOT_SAMPLE)
+            results.shotSample(record.frame_number, record.time);
+    }
+    events.swap(savedEvents);
+    transitions.swap(savedTransitions);
+    processedFrames = checkpoint.frameCount();
+    checkpointCounters.resumed_frames = processedFrames;
+    cout << "resuming after frame " << processedFrames << " from checkpoint " << checkpointPath << endl;
+    return true;
+}
+
+/**
+ * @brief ShotDetector::putCheckpointSettings: Stores the settings the state of a checkpoint depends on.
+ */
+void ShotDetector::putCheckpointSettings(Checkpoint &checkpoint, OutputFormat format) const{
+    checkpoint.putDouble(threshold);
+    checkpoint.putDouble(yuvThreshold);
+    checkpoint.putInt(yuvNative);
+    checkpoint.putInt(sample_period);
+    checkpoint.putInt(sampling);
+    checkpoint.putInt(sampling_factor);
+    checkpoint.putInt(gradualWindow);
+    checkpoint.putInt(adaptiveWindow);
+    checkpoint.putDouble(adaptiveSigmas);
+    checkpoint.putInt(format);
+    checkpoint.putInt(tileGrid);
+    checkpoint.putInt(tileIgnored);
+}
+
+/**
+ * @brief ShotDetector::sameCheckpointSettings: Reads the settings stored by putCheckpointSettings and compares
+ * them with the current ones.
+ */
+bool ShotDetector::sameCheckpointSettings(Checkpoint &checkpoint, OutputFormat format) const{
+    return checkpoint.getDouble() == threshold && checkpoint.getDouble() == yuvThreshold
+            && checkpoint.getInt() == yuvNative && checkpoint.getInt() == sample_period
+            && checkpoint.getInt() == sampling && checkpoint.getInt() == sampling_factor
+            && checkpoint.getInt() == gradualWindow && checkpoint.getInt() == adaptiveWindow
+            && checkpoint.getDouble() == adaptiveSigmas && checkpoint.getInt() == format
+            && checkpoint.getInt() == tileGrid && checkpoint.getInt() == tileIgnored && !checkpoint.failed();
+}
+
+/**
+ * @brief ShotDetector::openSeekIndex: Opens the seek index set by setSeekIndex.
+ * @return: false if there is none or it does not belong to the video
+ */
+bool ShotDetector::openSeekIndex(SeekIndex &index) const{
+    if(seekIndexPath.empty())
+        return false;
+    if(index.open(seekIndexPath) && index.matches(videoPath))
+        return true;
+    index.close();
+    return false;
+}
+
+/**
+ * @brief ShotDetector::getShotFromVideo: gets detected shot (specified frame with given frame number) from video.
+ * Frames of the seek index of the video (see setSeekIndex) are sought with it.
+ * @param frame_number: index of frame to be grabbed. Note that indexing is 0 based.
+ * @return returns frame with corresponding frame number from video.
+ */
+cv::Mat ShotDetector::getShotFromVideo(double frame_number){
+    VideoCapture cap(videoPath);
+    if(!cap.isOpened()){
+        cout << "error openning video!" <<endl;
+        return Mat();
+    }
+    cv::Mat frame;
+    SeekIndex seekIndex;
+    if(openSeekIndex(seekIndex) && frame_number < seekIndex.frameCount()){
+        int position = 0, decoded;
+        if(seekIndex.seek(cap, (int) frame_number, position, decoded))
+            cap.retrieve(frame);
+        return frame;
+    }
+    cap.set(CV_CAP_PROP_POS_FRAMES, frame_number);
+    cap >> frame;
+    return frame;
+}
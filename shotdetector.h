@@ -18,29 +18,242 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+#include "adaptivethreshold.h"
+#include "cascadedetector.h"
+#include "checkpoint.h"
+#include "colorhistogram.h"
+#include "frameextractor.h"
+#include "gradualdetector.h"
+#include "keyframewriter.h"
+#include "resultwriter.h"
+#include "runmetrics.h"
+#include "seekindex.h"
+#include "signaturecache.h"
+
+//seconds between the checkpoints of processVideo_NoGUI
+#define DEFAULT_CHECKPOINT_PERIOD 5
+//tiles per side of the tile mode, see setTileGrid
+#define TILE_GRID_MAX 16
+
+template<typename T> class SPSCQueue;
+class RawFrameSource;
+class ShotStream;
 
-namespace cv {
-double compareHistCustom( InputArray _H1, InputArray _H2, int method );
-}
 class ShotDetector
 {
 public:
-    enum OutputFormat {XML, YAML, TEXT};
+    /** format of the result file, see ResultWriter **/
+    enum OutputFormat {XML = ResultWriter::XML, YAML = ResultWriter::YAML, TEXT = ResultWriter::TEXT,
+                       JSON = ResultWriter::JSON, BINARY = ResultWriter::BINARY};
+    /** events which can be decided for a single frame of the video **/
+    enum ShotEvent {NO_EVENT, SHOT_BEGIN, SHOT_END, SHOT_SAMPLE};
+    /**
+     * pixels of a frame counted in its histogram: all of them, every n'th pixel of each row,
+     * every n'th row, or all pixels of the frame downscaled by n with area interpolation.
+     */
+    enum SamplingMode {SAMPLE_ALL, SAMPLE_PIXEL_STRIDE, SAMPLE_ROW_STRIDE, SAMPLE_DOWNSCALE};
+    /**
+     * @brief The ShotState struct keeps the shot bookkeeping of the detection loop
+     * (shot found at previous frame, shot start stored, sample counter) and decides
+     * which event is produced by the boundary decision of each frame.
+     */
+    struct ShotState
+    {
+        ShotState(int sample_period);
+        ShotEvent update(bool boundary);
+        bool shotFoundAtPrev;
+        bool shotStartStored;
+        int frameCounter;
+        int sample_period;
+    };
+    /** checkpoints of the last processVideo_NoGUI run, see setCheckpoint **/
+    struct CheckpointStats
+    {
+        CheckpointStats();
+        int written;
+        double seconds;             // time spent on checkpoints, waiting for pending keyframes included
+        size_t bytes;               // size of the state in the last checkpoint
+        int resumed_frames;         // frames of the checkpoint the run resumed from, 0 if it started from the first frame
+    };
     ShotDetector(std::string filename, double threshold);
     ShotDetector(std::string filename, double threshold, int sample_period);
+    ShotDetector(std::string filename, double threshold, int sample_period, SamplingMode sampling, int sampling_factor);
     void processVideo(std::string outputFileName, OutputFormat format);
     void processVideo_NoGUI(std::string outputFileName, OutputFormat format);
+    void processVideo_Parallel(std::string outputFileName, OutputFormat format, int num_threads);
+    void processVideo_Pipelined(std::string outputFileName, OutputFormat format);
+    void processVideo_Coarse(std::string outputFileName, OutputFormat format, int step);
+    void processVideo_Sweep(std::string outputFileName, OutputFormat format, const std::vector<double> &thresholds);
+    void processVideo_Cascade(std::string outputFileName, OutputFormat format,
+                              const std::vector<CascadeDetector::Stage> &stages);
+    bool processVideo_Cached(std::string outputFileName, OutputFormat format, std::string cacheFile);
+    void processStream(RawFrameSource &source, std::string outputFileName, OutputFormat format);
+    int extractKeyframes(const std::vector<int> &frame_numbers, std::string outputFileName);
+    int processedFrameCount() const;
+    int bufferReallocationCount() const;
+    int retrievedFrameCount() const;
+    int bisectedIntervalCount() const;
+    double decisionLatency(double percentile) const;
+    void setKeyframeOptions(const KeyframeWriter::Options &options);
+    void setEventStream(std::ostream *stream);
+    void setYUVNative(bool enabled, double yuv_threshold);
+    void setMetrics(RunMetrics *metrics);
+    void setGradualWindow(int window);
+    void setAdaptiveThreshold(int window, double sigmas);
+    void setSeekIndex(std::string path, int keyframe_interval);
+    void setCheckpoint(std::string path, double period, bool resume);
+    void setTileGrid(int grid, int ignored);
+    KeyframeWriter::Stats keyframeWriterStats() const;
+    FrameExtractor::Stats extractionStats() const;
+    CheckpointStats checkpointStats() const;
+    CascadeDetector::Stats cascadeStats() const;
     std::string videoPath;
     static bool shotBoundaryDetect(cv::Mat &prevFrame, cv::Mat& currntFrame, int threshold );
     bool shotBoundaryDetect(cv::Mat &prevFrame, cv::Mat& currntFrame );
     bool shotBoundaryDetectHist(cv::MatND &prevHist, cv::MatND& currntFrame );
+    bool shotBoundaryDetectCounts(cv::MatND &prevHist, cv::MatND& currHist, double pixelCount );
     cv::MatND prepareFrame(cv::Mat &frame);
+    void prepareFrameCounts(const cv::Mat &frame, cv::MatND &hist);
+    double sampledPixelCount(const cv::Mat &frame) const;
+    double histDistance(const cv::MatND &prevHist, const cv::MatND &currHist) const;
+    int yuvLayout(const cv::Mat &frame) const;
     cv::Mat getShotFromVideo(double frame_number);
 private:
+    friend class ShotStream;
+    /** part of the video processed by a single worker of processVideo_Parallel **/
+    struct Segment
+    {
+        int first_frame;            // index of the first frame compared in this segment
+        int last_frame;             // index after the last frame (ignored for the last segment)
+        bool is_last;
+        bool failed;
+        int sync_frame;             // first frame whose shot state is known locally, -1 if none
+        std::vector<char> boundary;
+        std::vector<int> frame_numbers;
+        std::vector<double> frame_times;
+        bool reached_end;
+        int end_frame_number;
+        double end_time;
+        bool end_frame_stored;
+        int reallocations;
+    };
+    /**
+     * @brief The FrameBuffers struct keeps the frame and histogram buffers of a detection loop.
+     * Each frame is decoded into the buffers of the frame before the previous one, so after
+     * the first two frames the loop reuses them instead of allocating and copying.
+     * A frame queued to the keyframe writer keeps its buffer, a new one is decoded instead.
+     */
+    struct FrameBuffers
+    {
+        FrameBuffers();
+        bool read(cv::VideoCapture &cap, RunMetrics *metrics = 0);
+        void next();
+        void markQueued();
+        cv::Mat& prevFrame();
+        cv::Mat& currFrame();
+        cv::MatND& prevHist();
+        cv::MatND& currHist();
+        cv::Mat frames[2];
+        cv::MatND hists[2];
+        bool queued[2];
+        int prev;
+        const uchar* histData;      // histogram buffer of the current frame before it is computed
+        int reallocations;          // buffers (re)allocated although they could have been reused
+    };
+    /** frame passed between the stages of processVideo_Pipelined **/
+    struct PipelineItem
+    {
+        PipelineItem();
+        cv::Mat frame;
+        cv::MatND hist;
+        int frame_number;
+        double time;
+        ShotEvent event;
+        bool last;                  // end of video is reached
+    };
+    /** frame retrieved by processVideo_Coarse **/
+    struct CoarseFrame
+    {
+        CoarseFrame();
+        cv::Mat frame;
+        cv::MatND hist;             // empty until the frame is compared
+        int frame_number;
+        double time;
+    };
+    void decodeStage(cv::VideoCapture &cap, SPSCQueue<PipelineItem> &output);
+    void histogramStage(SPSCQueue<PipelineItem> &input, SPSCQueue<PipelineItem> &output);
+    void writeStage(SPSCQueue<PipelineItem> &input, ResultWriter &results, std::string rootShotPath);
+    bool grabCoarseFrame(cv::VideoCapture &cap, CoarseFrame &frame);
+    void retrieveCoarseFrame(cv::VideoCapture &cap, CoarseFrame &frame);
+    void seekCoarseFrame(cv::VideoCapture &cap, int index, CoarseFrame &frame);
+    void coarseHistogram(CoarseFrame &frame);
+    bool coarseBoundary(CoarseFrame &prevFrame, CoarseFrame &currFrame);
+    void bisectInterval(cv::VideoCapture &cap, int origin, int lo, int hi, std::map<int, CoarseFrame> &frames,
+                        std::vector<char> &boundary);
+    void detectSegment(Segment &segment, std::string rootShotPath);
+    void storeFrames(int first_frame, std::vector<std::pair<int, int> > frames, std::string rootShotPath);
+    void writeShotEvent(ResultWriter &results, ShotEvent event, int frame_number, double time);
+    void streamEvent(const char *event, int frame_number, double time);
+    void addGradualTransition(std::vector<GradualDetector::Transition> &transitions,
+                              const GradualDetector::Transition &transition);
+    void writeGradualTransitions(ResultWriter &results, const std::vector<GradualDetector::Transition> &transitions);
+    ResultWriter* openResultFile(const std::string &resultFile, OutputFormat format, const std::string &video_path,
+                                 int fps, int frame_count, double threshold = -1);
+    void closeResultFile(ResultWriter &results);
+    double boundaryThreshold(const cv::Mat &currFrame) const;
+    bool frameBoundary(cv::MatND &prevHist, cv::MatND &currHist, const cv::Mat &currFrame);
+    void cacheFrame(int frame_number, double time, double distance, const cv::Mat &frame);
+    void replayCache(SignatureCache &cache, std::string outputFileName, OutputFormat format);
+    bool openSeekIndex(SeekIndex &index) const;
+    void saveCheckpoint(const ShotStream &stream, const std::vector<ResultWriter::BinaryRecord> &events,
+                        const std::vector<GradualDetector::Transition> &transitions, KeyframeWriter &writer,
+                        OutputFormat format);
+    bool resumeCheckpoint(cv::VideoCapture &cap, FrameBuffers &buffers, ShotStream &stream, ResultWriter &results,
+                          std::vector<ResultWriter::BinaryRecord> &events,
+                          std::vector<GradualDetector::Transition> &transitions, OutputFormat format);
+    void putCheckpointSettings(Checkpoint &checkpoint, OutputFormat format) const;
+    bool sameCheckpointSettings(Checkpoint &checkpoint, OutputFormat format) const;
+    void requestUnconvertedFrames(cv::VideoCapture &cap);
+    void storeFrame(std::string rootShotPath, int frame_number, cv::Mat &frame);
+    void finishKeyframes(KeyframeWriter &writer);
+    std::string shotPath(std::string outputFileName);
+    std::string resultFileName(std::string outputFileName, OutputFormat format);
+    std::string sweepFileName(std::string resultFile, double threshold);
     std::string miliseconds_to_DHMS(double duration);
     cv::Mat currentFrame;
     double threshold;
     int sample_period;
+    SamplingMode sampling;
+    int sampling_factor;
+    bool yuvNative;                     // histograms of unconverted YUV frames, see setYUVNative
+    double yuvThreshold;
+    int processedFrames;
+    int bufferReallocations;
+    int retrievedFrames;
+    int bisectedIntervals;
+    std::vector<double> latencies;      // arrival to decision of each frame of processStream, miliseconds
+    KeyframeWriter::Options keyframeOptions;
+    KeyframeWriter *keyframeWriter;     // writer of the current run
+    KeyframeWriter::Stats keyframeStats;
+    FrameExtractor::Stats extractStats;  // seeks and grabs of the last extractKeyframes run
+    std::ostream *eventStream;
+    SignatureCache *signatureCache;     // cache written by the current processVideo_NoGUI run
+    RunMetrics *metrics;                // stage times and counters, 0 if disabled
+    int gradualWindow;                  // window of the gradual transition detector, 0 if disabled
+    int adaptiveWindow;                 // window of the adaptive threshold, 0 for the fixed threshold
+    double adaptiveSigmas;
+    std::string seekIndexPath;          // seek index written by processVideo_NoGUI, empty if disabled
+    int seekKeyframeInterval;
+    std::string checkpointPath;         // checkpoint of processVideo_NoGUI, empty if disabled
+    double checkpointPeriod;            // seconds between checkpoints
+    bool resumeRun;                     // continue from the checkpoint, if there is one for the video
+    CheckpointStats checkpointCounters;
+    int tileGrid;                       // tiles per side of the tiled histograms, 0 for one histogram per frame
+    int tileIgnored;                    // largest tile distances dropped from the distance of a frame
+    CascadeDetector::Stats cascadeCounters;  // stages of the last processVideo_Cascade run
 
 };
 
@@ -0,0 +1,195 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#include "shotstream.h"
+#include "checkpoint.h"
+#include <cstring>
+
+using namespace cv;
+using namespace std;
+
+/**
+ * @brief ShotStream::ShotStream
+ * @param detector: settings of the detection, see the class description
+ */
+ShotStream::ShotStream(ShotDetector &detector): detector(detector), state(detector.sample_period),
+    gradual(detector.gradualWindow > 0 ? new GradualDetector(detector, detector.gradualWindow) : 0),
+    adaptive(detector.adaptiveWindow > 0 ? new AdaptiveThreshold(detector.adaptiveWindow, detector.adaptiveSigmas) : 0),
+    prev(1), lastFrameNumber(0), lastTime(0), frames(0), reallocations(0), finished(false)
+{
+}
+
+void ShotStream::onEvent(EventCallback callback){
+    eventCallback = callback;
+}
+
+void ShotStream::onTransition(TransitionCallback callback){
+    transitionCallback = callback;
+}
+
+void ShotStream::onFrame(FrameCallback callback){
+    frameCallback = callback;
+}
+
+/**
+ * @brief ShotStream::feed: Detects the events of the next frame, frames are numbered 1, 2, ... in feeding order.
+ * @param timestamp: position of the frame in miliseconds
+ */
+ShotDetector::ShotEvent ShotStream::feed(const cv::Mat &frame, double timestamp){
+    return feed(frame, frames + 1, timestamp);
+}
+
+/**
+ * @brief ShotStream::feed: Detects the events of the next frame and reports them to the callbacks.
+ * The first frame begins the first shot.
+ * @param frame: BGR frame, or a YUV frame of the layouts of ShotDetector::yuvLayout in YUV native mode
+ * @param frame_number: frame number reported with the events of the frame
+ * @param timestamp: position of the frame in miliseconds
+ * @return: event of the frame
+ */
+ShotDetector::ShotEvent ShotStream::feed(const cv::Mat &frame, int frame_number, double timestamp){
+    int curr = 1 - prev;
+    const uchar* histData = hists[curr].data;
+    int64 start_t = RunMetrics::start(detector.metrics);
+    detector.prepareFrameCounts(frame, hists[curr]);
+    RunMetrics::stop(detector.metrics, RunMetrics::HISTOGRAM, start_t);
+    if(histData != 0 && hists[curr].data != histData)
+        reallocations++;
+
+    ShotDetector::ShotEvent event = ShotDetector::SHOT_BEGIN;
+    double distance = 0;
+    double limit = detector.boundaryThreshold(frame);
+    bool boundary = false;
+    if(frames > 0){
+        start_t = RunMetrics::start(detector.metrics);
+        distance = detector.histDistance(hists[prev], hists[curr]);
+        boundary = AdaptiveThreshold::decide(adaptive.get(), distance, limit);
+        event = state.update(boundary);
+        RunMetrics::stop(detector.metrics, RunMetrics::COMPARE, start_t);
+    }
+    if(frameCallback)
+        frameCallback(frame_number, timestamp, distance, frame, hists[curr]);
+    GradualDetector::Transition transition;
+    if(gradual && gradual->update(hists[curr], distance, limit, boundary, frame_number, timestamp, transition) && transitionCallback)
+        transitionCallback(transition);
+    if(event != ShotDetector::NO_EVENT && eventCallback)
+        eventCallback(event, frame_number, timestamp, frame);
+
+    lastFrame = frame;
+    lastFrameNumber = frame_number;
+    lastTime = timestamp;
+    frames++;
+    prev = curr;
+    return event;
+}
+
+/**
+ * @brief ShotStream::finish: Ends the video at the last fed frame: the last shot ends there, unless it was
+ * just ended by a boundary, and a gradual transition in progress is reported.
+ */
+void ShotStream::finish(){
+    finish(lastFrameNumber, lastTime);
+}
+
+/**
+ * @brief ShotStream::finish: Same as finish(), reporting the end of the last shot with the given frame number
+ * and timestamp (the position of a decoder after its last frame). The stream takes no frames afterwards.
+ */
+void ShotStream::finish(int frame_number, double timestamp){
+    if(finished || frames == 0)
+        return;
+    finished = true;
+    if(!state.shotFoundAtPrev && eventCallback)
+        eventCallback(ShotDetector::SHOT_END, frame_number, timestamp, lastFrame);
+    GradualDetector::Transition transition;
+    if(gradual && gradual->finish(transition) && transitionCallback)
+        transitionCallback(transition);
+}
+
+int ShotStream::frameCount() const{
+    return frames;
+}
+
+int ShotStream::reallocationCount() const{
+    return reallocations;
+}
+
+/**
+ * @brief ShotStream::saveState: Stores the state of the stream after the last fed frame in a checkpoint: shot
+ * state, frame count, histogram of the last frame and the states of the gradual and adaptive detectors.
+ */
+void ShotStream::saveState(Checkpoint &checkpoint) const{
+    checkpoint.putInt(state.shotFoundAtPrev);
+    checkpoint.putInt(state.shotStartStored);
+    checkpoint.putInt(state.frameCounter);
+    checkpoint.putInt(frames);
+    checkpoint.putInt(lastFrameNumber);
+    checkpoint.putDouble(lastTime);
+    checkpoint.putHist(hists[prev]);
+    checkpoint.putInt(gradual ? 1 : 0);
+    if(gradual)
+        gradual->saveState(checkpoint);
+    checkpoint.putInt(adaptive ? 1 : 0);
+    if(adaptive)
+        adaptive->saveState(checkpoint);
+}
+
+/**
+ * @brief ShotStream::restore: Continues a stream from the state stored by saveState, as if the frames before
+ * had been fed. The caller passes the last frame before the checkpoint again, decoded after a seek: it must have the
+ * frame number and the histogram stored, otherwise the seek missed the frame and the stream is left unchanged.
+ * @param frame: last frame fed before the checkpoint, kept like a fed frame
+ * @param frame_number: frame number of frame
+ * @return: false if lastFrame is not the frame of the checkpoint, the settings differ or the checkpoint is corrupt
+ */
+bool ShotStream::restore(Checkpoint &checkpoint, const cv::Mat &frame, int frame_number){
+    ShotDetector::ShotState savedState(detector.sample_period);
+    savedState.shotFoundAtPrev = checkpoint.getInt() != 0;
+    savedState.shotStartStored = checkpoint.getInt() != 0;
+    savedState.frameCounter = (int) checkpoint.getInt();
+    int savedFrames = (int) checkpoint.getInt();
+    int savedFrameNumber = (int) checkpoint.getInt();
+    double savedTime = checkpoint.getDouble();
+    cv::MatND savedHist;
+    if(!checkpoint.getHist(savedHist) || savedFrames <= 0 || savedFrameNumber != frame_number)
+        return false;
+
+    cv::MatND hist;
+    detector.prepareFrameCounts(frame, hist);
+    if(hist.type() != savedHist.type() || hist.total() != savedHist.total() || !hist.isContinuous()
+            || memcmp(hist.data, savedHist.data, hist.total() * hist.elemSize()) != 0)
+        return false;
+
+    std::unique_ptr<GradualDetector> savedGradual(gradual ? new GradualDetector(detector, gradual->window()) : 0);
+    if((checkpoint.getInt() != 0) != (savedGradual != 0) || (savedGradual && !savedGradual->loadState(checkpoint)))
+        return false;
+    std::unique_ptr<AdaptiveThreshold> savedAdaptive(adaptive ? new AdaptiveThreshold(detector.adaptiveWindow,
+                                                                                       detector.adaptiveSigmas) : 0);
+    if((checkpoint.getInt() != 0) != (savedAdaptive != 0) || (savedAdaptive && !savedAdaptive->loadState(checkpoint))
+            || checkpoint.failed())
+        return false;
+
+    state = savedState;
+    gradual.swap(savedGradual);
+    adaptive.swap(savedAdaptive);
+    prev = 0;
+    hists[prev] = hist;
+    hists[1 - prev].release();
+    lastFrame = frame;
+    lastFrameNumber = savedFrameNumber;
+    lastTime = savedTime;
+    frames = savedFrames;
+    finished = false;
+    return true;
+}
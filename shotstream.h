@@ -0,0 +1,83 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#ifndef SHOTSTREAM_H
+#define SHOTSTREAM_H
+#include "shotdetector.h"
+#include <functional>
+#include <memory>
+
+/**
+ * @brief The ShotStream class detects shot boundaries of frames pushed by the caller, e.g. frames a transcoder
+ * has already decoded. It opens, reads and writes no files: each decision is reported through callbacks.
+ * Threshold, sampling, YUV native histograms, adaptive threshold, gradual transitions and metrics are the
+ * settings of the ShotDetector it is created with, which must outlive the stream.
+ *
+ *     ShotDetector detector("", 0.49, 30);
+ *     ShotStream stream(detector);
+ *     stream.onEvent([](ShotDetector::ShotEvent event, int frame_number, double time, const cv::Mat &frame){ ... });
+ *     while(decoder.read(frame))
+ *         stream.feed(frame, timestamp_ms);
+ *     stream.finish();
+ *
+ * Frames passed to callbacks are the frames fed by the caller, copy them to keep them. The stream keeps a
+ * reference to the last fed frame, which is reported with the shot end of finish(): the caller must not write
+ * into it until the next feed.
+ */
+class ShotStream
+{
+public:
+    /** shot begin, end or sample frame **/
+    typedef std::function<void(ShotDetector::ShotEvent event, int frame_number, double time, const cv::Mat &frame)> EventCallback;
+    /** gradual transition, with ShotDetector::setGradualWindow **/
+    typedef std::function<void(const GradualDetector::Transition &transition)> TransitionCallback;
+    /** every frame: its distance to the previous one (0 for the first frame) and its CV_32S histogram **/
+    typedef std::function<void(int frame_number, double time, double distance, const cv::Mat &frame,
+                               const cv::MatND &hist)> FrameCallback;
+
+    explicit ShotStream(ShotDetector &detector);
+    void onEvent(EventCallback callback);
+    void onTransition(TransitionCallback callback);
+    void onFrame(FrameCallback callback);
+    ShotDetector::ShotEvent feed(const cv::Mat &frame, double timestamp);
+    ShotDetector::ShotEvent feed(const cv::Mat &frame, int frame_number, double timestamp);
+    void finish();
+    void finish(int frame_number, double timestamp);
+    int frameCount() const;
+    int reallocationCount() const;
+    void saveState(Checkpoint &checkpoint) const;
+    bool restore(Checkpoint &checkpoint, const cv::Mat &frame, int frame_number);
+
+private:
+    ShotStream(const ShotStream&);
+    ShotStream& operator=(const ShotStream&);
+
+    ShotDetector &detector;
+    ShotDetector::ShotState state;
+    std::unique_ptr<GradualDetector> gradual;
+    std::unique_ptr<AdaptiveThreshold> adaptive;
+    EventCallback eventCallback;
+    TransitionCallback transitionCallback;
+    FrameCallback frameCallback;
+    cv::MatND hists[2];             // histograms of the previous and the current frame
+    int prev;
+    cv::Mat lastFrame;
+    int lastFrameNumber;
+    double lastTime;
+    int frames;
+    int reallocations;              // histogram buffers reallocated although they could have been reused
+    bool finished;
+};
+
+#endif // SHOTSTREAM_H
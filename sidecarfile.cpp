@@ -0,0 +1,168 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#include "sidecarfile.h"
+#include <iostream>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace cv;
+using namespace std;
+
+SidecarFile::SidecarFile(): mapped(0), mappedSize(0), output(0)
+{
+}
+
+SidecarFile::~SidecarFile()
+{
+    unmap();
+    discard();
+}
+
+/**
+ * @brief SidecarFile::map: Maps a file for reading.
+ * @param minSize: smallest valid file (its header)
+ * @return: false if the file does not exist or is smaller than minSize
+ */
+bool SidecarFile::map(const std::string &path, size_t minSize){
+    unmap();
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        return false;
+    struct stat st;
+    if(fstat(fd, &st) == 0 && st.st_size >= (off_t) minSize && st.st_size > 0){
+        void *region = mmap(0, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if(region != MAP_FAILED){
+            mapped = (const uchar*) region;
+            mappedSize = (size_t) st.st_size;
+        }
+    }
+    ::close(fd);
+#else
+    FILE *input = fopen(path.c_str(), "rb");
+    if(!input)
+        return false;
+    fseek(input, 0, SEEK_END);
+    long size = ftell(input);
+    fseek(input, 0, SEEK_SET);
+    if(size >= (long) minSize && size > 0){
+        fileData.resize((size_t) size);
+        if(fread(&fileData[0], 1, fileData.size(), input) == fileData.size()){
+            mapped = &fileData[0];
+            mappedSize = fileData.size();
+        }
+    }
+    fclose(input);
+#endif
+    return mapped != 0;
+}
+
+/**
+ * @brief SidecarFile::unmap: Releases the file mapped for reading.
+ */
+void SidecarFile::unmap(){
+#ifndef _WIN32
+    if(mapped)
+        munmap((void*) mapped, mappedSize);
+#endif
+    mapped = 0;
+    mappedSize = 0;
+    fileData.clear();
+}
+
+const uchar* SidecarFile::data() const{
+    return mapped;
+}
+
+size_t SidecarFile::size() const{
+    return mappedSize;
+}
+
+/**
+ * @brief SidecarFile::create: Starts writing path, the contents are written to the returned path.tmp.
+ * A file which is neither committed nor discarded is discarded by the destructor.
+ * @return: the temporary file, 0 if it cannot be created
+ */
+FILE* SidecarFile::create(const std::string &path){
+    discard();
+    outputPath = path;
+    output = fopen((path + ".tmp").c_str(), "wb");
+    if(!output)
+        cout << "error openning " << path << ".tmp" << endl;
+    return output;
+}
+
+/**
+ * @brief SidecarFile::commit: Closes the temporary file and moves it over the path given to create().
+ * The temporary file is removed if a write to it failed.
+ * @param sync: flush the file to the disk first, so it survives the machine and not only the process
+ */
+bool SidecarFile::commit(bool sync){
+    if(!output)
+        return false;
+    bool stored = fflush(output) == 0 && !ferror(output);
+#ifndef _WIN32
+    if(sync)
+        stored = fsync(fileno(output)) == 0 && stored;
+#endif
+    stored = fclose(output) == 0 && stored;
+    output = 0;
+    string tmpPath = outputPath + ".tmp";
+    if(!stored || !replace(tmpPath, outputPath)){
+        cout << "error writing " << outputPath << endl;
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief SidecarFile::discard: Closes and removes the temporary file of an unfinished write.
+ */
+void SidecarFile::discard(){
+    if(!output)
+        return;
+    fclose(output);
+    output = 0;
+    remove((outputPath + ".tmp").c_str());
+}
+
+/**
+ * @brief SidecarFile::replace: Moves tmpPath over path. The target is only removed first where rename does not
+ * replace an existing file (Windows), elsewhere path always names a complete file.
+ */
+bool SidecarFile::replace(const std::string &tmpPath, const std::string &path){
+#ifdef _WIN32
+    remove(path.c_str());
+#endif
+    return rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+/**
+ * @brief SidecarFile::videoStat: Size and modification time of the video a sidecar file belongs to.
+ * @return: false if the video does not exist
+ */
+bool SidecarFile::videoStat(const std::string &videoPath, int64_t &size, int64_t &mtime){
+    struct stat st;
+    if(stat(videoPath.c_str(), &st) != 0)
+        return false;
+    size = (int64_t) st.st_size;
+    mtime = (int64_t) st.st_mtime;
+    return true;
+}
@@ -0,0 +1,59 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#ifndef SIDECARFILE_H
+#define SIDECARFILE_H
+#include <opencv2/core/core.hpp>
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The SidecarFile class does the file handling shared by the sidecar files of a video (SignatureCache,
+ * SeekIndex, Checkpoint). For reading, the file is memory mapped where the platform supports it, otherwise read
+ * into memory. For writing, the contents go to path.tmp, which is moved over path by commit(), so readers never
+ * see a partial file: on POSIX the rename replaces path atomically, a file which is being replaced stays
+ * readable until the new one is in place.
+ */
+class SidecarFile
+{
+public:
+    SidecarFile();
+    ~SidecarFile();
+    //reading
+    bool map(const std::string &path, size_t minSize);
+    void unmap();
+    const uchar* data() const;
+    size_t size() const;
+    //writing
+    FILE* create(const std::string &path);
+    bool commit(bool sync = false);
+    void discard();
+
+    static bool replace(const std::string &tmpPath, const std::string &path);
+    static bool videoStat(const std::string &videoPath, int64_t &size, int64_t &mtime);
+
+private:
+    SidecarFile(const SidecarFile&);
+    SidecarFile& operator=(const SidecarFile&);
+
+    const uchar *mapped;
+    size_t mappedSize;
+    std::vector<uchar> fileData;    // contents of the file where it is not memory mapped
+    FILE *output;
+    std::string outputPath;
+};
+
+#endif // SIDECARFILE_H
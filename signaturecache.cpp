@@ -0,0 +1,137 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#include "signaturecache.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace cv;
+using namespace std;
+
+#define SIGNATURE_MAGIC "SHOTSIG"
+#define SIGNATURE_BYTE_ORDER 0x01020304u
+
+SignatureCache::SignatureCache(): data(0), output(0)
+{
+}
+
+SignatureCache::~SignatureCache()
+{
+    close();
+}
+
+/**
+ * @brief SignatureCache::open: Maps the cache file for reading and checks its header.
+ * @return: false if the file does not exist, is truncated or was written by another version or byte order
+ */
+bool SignatureCache::open(const std::string &path){
+    close();
+    if(!file.map(path, sizeof(Header)))
+        return false;
+    data = file.data();
+
+    const Header &h = header();
+    bool valid = memcmp(h.magic, SIGNATURE_MAGIC, sizeof(SIGNATURE_MAGIC)) == 0 && h.version == VERSION
+            && h.byte_order == SIGNATURE_BYTE_ORDER && h.header_size == sizeof(Header)
+            && h.record_size == sizeof(Record) && h.frame_count > 0
+            && file.size() >= sizeof(Header) + (size_t) h.frame_count * h.record_size;
+    if(!valid)
+        close();
+    return valid;
+}
+
+/**
+ * @brief SignatureCache::matches: Returns true if the open cache was written for the video as it is now
+ * (same size and modification time) with histograms of the same sampling, color space and tiles.
+ */
+bool SignatureCache::matches(const std::string &videoPath, int sampling, int sampling_factor, bool yuv, int tile_grid,
+                             int tile_ignored) const{
+    int64_t size, mtime;
+    if(!data || !SidecarFile::videoStat(videoPath, size, mtime))
+        return false;
+    const Header &h = header();
+    return h.video_size == size && h.video_mtime == mtime && h.sampling == sampling
+            && h.sampling_factor == sampling_factor && ((h.flags & YUV_HISTOGRAMS) != 0) == yuv
+            && std::max(h.tile_grid, (int16_t) 1) == std::max(tile_grid, 1) && h.tile_ignored == tile_ignored;
+}
+
+/**
+ * @brief SignatureCache::close: Unmaps the file opened for reading.
+ */
+void SignatureCache::close(){
+    file.unmap();
+    data = 0;
+}
+
+const SignatureCache::Header& SignatureCache::header() const{
+    return *(const Header*) data;
+}
+
+int SignatureCache::frameCount() const{
+    return data ? header().frame_count : 0;
+}
+
+const SignatureCache::Record& SignatureCache::record(int index) const{
+    return *(const Record*) (data + sizeof(Header) + (size_t) index * header().record_size);
+}
+
+/**
+ * @brief SignatureCache::create: Starts writing a cache. Records are written to path.tmp, which replaces
+ * path when finish() succeeds, so an interrupted run never leaves a cache which looks complete.
+ * @param path: cache file
+ * @param videoPath: video the cache belongs to
+ */
+bool SignatureCache::create(const std::string &path, const std::string &videoPath){
+    output = file.create(path);
+    if(!output)
+        return false;
+    memset(&written, 0, sizeof(Header));
+    SidecarFile::videoStat(videoPath, written.video_size, written.video_mtime);
+    //the header is written by finish()
+    fwrite(&written, sizeof(Header), 1, output);
+    return true;
+}
+
+/**
+ * @brief SignatureCache::append: Writes the record of the next frame.
+ * @param record: frame number, time, pixel count and distance to the previous frame
+ */
+void SignatureCache::append(const Record &record){
+    if(!output)
+        return;
+    fwrite(&record, sizeof(Record), 1, output);
+}
+
+/**
+ * @brief SignatureCache::finish: Completes the header with the fields given in header and moves the cache in place.
+ * @param header: frame_count, video_frame_count, sampling, flags, end position and fps of the run
+ */
+bool SignatureCache::finish(const Header &header){
+    if(!output)
+        return false;
+    int64_t video_size = written.video_size, video_mtime = written.video_mtime;
+    written = header;
+    memcpy(written.magic, SIGNATURE_MAGIC, sizeof(SIGNATURE_MAGIC));
+    written.version = VERSION;
+    written.byte_order = SIGNATURE_BYTE_ORDER;
+    written.header_size = sizeof(Header);
+    written.reserved = 0;
+    written.record_size = sizeof(Record);
+    written.video_size = video_size;
+    written.video_mtime = video_mtime;
+    fseek(output, 0, SEEK_SET);
+    fwrite(&written, sizeof(Header), 1, output);
+    output = 0;
+    return file.commit();
+}
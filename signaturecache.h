@@ -0,0 +1,93 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#ifndef SIGNATURECACHE_H
+#define SIGNATURECACHE_H
+#include <opencv2/core/core.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "sidecarfile.h"
+
+/**
+ * @brief The SignatureCache class reads and writes the sidecar file of a video, which keeps what the
+ * detection loop computed for every frame: frame number, time and the Chi-Square distance of its histogram
+ * to the one of the previous frame. Boundary decisions for any threshold can be replayed from the distances
+ * without decoding the video.
+ *
+ * File layout (little endian): a Header, then frame_count records of record_size bytes, each one a Record.
+ * Files are memory mapped for reading where the platform supports it.
+ */
+class SignatureCache
+{
+public:
+    enum Flags {YUV_HISTOGRAMS = 1};
+    struct Header
+    {
+        char magic[8];              // "SHOTSIG"
+        uint32_t version;
+        uint32_t byte_order;        // 0x01020304 as written by the host
+        uint32_t header_size;
+        uint32_t record_size;
+        uint32_t reserved;          // 0
+        uint32_t flags;
+        int32_t frame_count;        // number of records
+        int32_t video_frame_count;  // frame count reported by the backend
+        int32_t sampling;           // sampling mode and factor the histograms were computed with
+        int32_t sampling_factor;
+        int32_t end_frame_number;   // position of the backend at the end of video
+        int16_t tile_grid;          // tiles per side and dropped tile distances of the distances (see
+        int16_t tile_ignored;       // ShotDetector::setTileGrid), 0 for whole frame histograms
+        double end_time;
+        double fps;
+        int64_t video_size;         // size and modification time of the video the cache belongs to
+        int64_t video_mtime;
+    };
+    struct Record
+    {
+        int32_t frame_number;
+        int32_t pixels;             // pixels counted in the histogram
+        double time;
+        double distance;            // Chi-Square distance of bin counts to the previous frame (0 for the first)
+    };
+
+    SignatureCache();
+    ~SignatureCache();
+    bool open(const std::string &path);
+    bool matches(const std::string &videoPath, int sampling, int sampling_factor, bool yuv, int tile_grid,
+                 int tile_ignored) const;
+    void close();
+    const Header& header() const;
+    int frameCount() const;
+    const Record& record(int index) const;
+
+    bool create(const std::string &path, const std::string &videoPath);
+    void append(const Record &record);
+    bool finish(const Header &header);
+
+    static const uint32_t VERSION = 1;
+
+private:
+    SignatureCache(const SignatureCache&);
+    SignatureCache& operator=(const SignatureCache&);
+
+    SidecarFile file;
+    //reading
+    const uchar *data;              // mapped file, 0 if none is open
+    //writing
+    FILE *output;
+    Header written;
+};
+
+#endif // SIGNATURECACHE_H
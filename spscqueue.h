@@ -0,0 +1,137 @@
+/*#******************************************************************************
+ ** IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ **
+ ** By downloading, copying, installing or using the software you agree to this license.
+ ** If you do not agree to this license, do not download, install,
+ ** copy or use the software.
+ **
+ ** See COPYING file for license information.
+ **
+ **  Creation - July 2015
+ **      Author: Yasin Yıldırım (yildirimyasi@gmail.com), Istanbul, Turkey
+ **
+*******************************************************************************/
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <cstddef>
+
+//times a waiting side yields before it blocks until the other side wakes it up
+#define SPSC_SPIN_COUNT 64
+
+/**
+ * @brief The SPSCQueue class is a bounded single-producer/single-consumer ring queue.
+ * push() blocks while the queue is full and pop() blocks while it is empty: a waiting side
+ * yields SPSC_SPIN_COUNT times, then sleeps on a condition variable until the other side
+ * moves its index, so a stalled stage does not keep a core busy.
+ * Occupancy statistics are kept separately by each side, so they are only
+ * valid to read after both threads are finished.
+ */
+template<typename T>
+class SPSCQueue
+{
+public:
+    explicit SPSCQueue(size_t capacity): buffer(capacity), head(0), tail(0),
+        producerWaiting(false), consumerWaiting(false),
+        pushes(0), fullWaits(0), occupancySum(0), pops(0), emptyWaits(0)
+    {
+    }
+
+    /**
+     * @brief push: Appends item to the queue. Must only be called from the producer thread.
+     */
+    void push(const T& item){
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t occupancy = t - head.load(std::memory_order_acquire);
+        if(occupancy >= buffer.size()){
+            fullWaits++;
+            wait(producerWaiting, notFull, [&]{ return t - head.load() < buffer.size(); });
+        }
+        occupancySum += occupancy;
+        pushes++;
+        buffer[t % buffer.size()] = item;
+        tail.store(t + 1);
+        wake(consumerWaiting, notEmpty);
+    }
+
+    /**
+     * @brief pop: Removes the oldest item of the queue. Must only be called from the consumer thread.
+     */
+    void pop(T& item){
+        size_t h = head.load(std::memory_order_relaxed);
+        if(tail.load(std::memory_order_acquire) == h){
+            emptyWaits++;
+            wait(consumerWaiting, notEmpty, [&]{ return tail.load() != h; });
+        }
+        pops++;
+        item = buffer[h % buffer.size()];
+        //release the resources held by the slot
+        buffer[h % buffer.size()] = T();
+        head.store(h + 1);
+        wake(producerWaiting, notFull);
+    }
+
+    size_t capacity() const { return buffer.size(); }
+    /** average number of queued items seen by push() **/
+    double averageOccupancy() const { return pushes ? (double) occupancySum / pushes : 0.; }
+    /** ratio of push() calls which waited because the consumer was behind **/
+    double fullRatio() const { return pushes ? (double) fullWaits / pushes : 0.; }
+    /** ratio of pop() calls which waited because the producer was behind **/
+    double emptyRatio() const { return pops ? (double) emptyWaits / pops : 0.; }
+
+private:
+    SPSCQueue(const SPSCQueue&);
+    SPSCQueue& operator=(const SPSCQueue&);
+
+    /**
+     * @brief wait: Spins until ready() holds, then blocks on condition. The waiting flag is raised
+     * before ready() is checked again and the index stores are sequentially consistent, so either
+     * this side sees the new index or the other side sees the flag and wakes it up.
+     */
+    template<typename Ready>
+    void wait(std::atomic<bool> &waiting, std::condition_variable &condition, Ready ready){
+        for(int i = 0; i < SPSC_SPIN_COUNT; i++){
+            if(ready())
+                return;
+            std::this_thread::yield();
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        waiting.store(true);
+        condition.wait(lock, ready);
+        waiting.store(false);
+    }
+
+    /**
+     * @brief wake: Wakes up the other side if it is blocked in wait(), must be called after the index is stored.
+     */
+    void wake(std::atomic<bool> &waiting, std::condition_variable &condition){
+        if(!waiting.load())
+            return;
+        //taking the lock makes sure the waiter is either before its check or inside condition.wait
+        std::lock_guard<std::mutex> lock(mutex);
+        condition.notify_one();
+    }
+
+    std::vector<T> buffer;
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    std::atomic<bool> producerWaiting;
+    std::atomic<bool> consumerWaiting;
+    //statistics of the producer side
+    size_t pushes;
+    size_t fullWaits;
+    size_t occupancySum;
+    //statistics of the consumer side
+    size_t pops;
+    size_t emptyWaits;
+};
+
+#endif // SPSCQUEUE_H